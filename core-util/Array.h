@@ -39,8 +39,12 @@ namespace util {
   * in a runtime error or cause undefined behaviour.
   *
   * If the templated type is a class or a struct, it needs to have a copy constructor
+  *
+  * Modifications of the array are protected by a CriticalSectionLock by default. A different
+  * locking policy (for example NullLock, for arrays protected by an external lock) can be
+  * given as the second template argument.
   */
-template <typename T>
+template <typename T, typename Lock = CriticalSectionLock>
 class Array {
 public:
     /** Create a new array
@@ -148,7 +152,7 @@ public:
                 return false;
             }
             {
-                CriticalSectionLock lock;
+                Lock lock;
                 if (prev_capacity == _capacity) { // allocate only if someone else didn't
                     if((_head = create_new_array(_grow_capacity, _elements, _head)) == NULL) {
                         return false;
@@ -160,7 +164,7 @@ public:
         {
             // TODO: this will eventually be 'atomic_set(&_elements);' after we figure
             // out the atomic access primitives
-            CriticalSectionLock lock;
+            Lock lock;
             _elements ++;
         }
         new(get_element_address(idx)) T(new_element);
@@ -172,7 +176,7 @@ public:
     void pop_back() {
         T *p = NULL;
         {
-            CriticalSectionLock lock;
+            Lock lock;
             if (_elements > 0) {
                 p = get_element_address(_elements - 1);
                 --_elements;
@@ -183,6 +187,68 @@ public:
         }
     }
 
+    /** Search the array for an element that satisfies a predicate
+      * The array is searched from the last element to the first one, one zone at a time,
+      * so the zones are walked only once during the search. The lock is held during the search,
+      * so 'pred' must not modify the array.
+      * @param pred the predicate (called with a const reference to each element)
+      * @returns the index of the last element that satisfies 'pred', or get_num_elements()
+      *          if no such element was found
+      */
+    template <typename Predicate>
+    unsigned find_if(Predicate pred) const {
+        Lock lock;
+        array_link *crt = _head;
+        unsigned idx = _elements;
+
+        while (idx > 0) {
+            idx --;
+            while (idx < crt->first_idx) {
+                crt = crt->prev;
+            }
+            if (pred(*(const T*)(crt->data + _element_size * (idx - crt->first_idx)))) {
+                return idx;
+            }
+        }
+        return _elements;
+    }
+
+    /** Removes all the elements that satisfy a predicate
+      * The array is scanned once, from the last element to the first one; each element that
+      * satisfies the predicate is replaced with the (already checked) last element in the array,
+      * so the relative order of the remaining elements is not preserved. Like push_back, this only
+      * needs T's copy constructor. The lock is held during the scan, so 'pred' must not modify
+      * the array.
+      * @param pred the predicate (called with a const reference to each element)
+      * @returns the number of removed elements
+      */
+    template <typename Predicate>
+    unsigned remove_if(Predicate pred) {
+        Lock lock;
+        array_link *crt = _head;
+        unsigned idx = _elements, removed = 0;
+
+        while (idx > 0) {
+            idx --;
+            while (idx < crt->first_idx) {
+                crt = crt->prev;
+            }
+            T *p = (T*)(crt->data + _element_size * (idx - crt->first_idx));
+            if (pred(*(const T*)p)) {
+                unsigned last = _elements - 1;
+                p->~T();
+                if (idx != last) {
+                    T *q = get_element_address(last);
+                    new(p) T(*q);
+                    q->~T();
+                }
+                _elements --;
+                removed ++;
+            }
+        }
+        return removed;
+    }
+
     /** Return the number of zones (linked memory areas) in this array
       * @returns number of zones
       */
@@ -226,8 +292,9 @@ private:
     array_link *create_new_array(size_t elements, unsigned first_idx = 0, array_link *prev = NULL) const {
         // Create the array space + an array_link structure in the same contigous memory area
         // Layout: array storage area | array_link structure
-        // Since the array elements are aligned to at least 4 bytes, the array_link address will be correctly aligned
-        size_t array_storage_size = _element_size * elements;
+        // The storage area is rounded up so that the array_link is aligned even when the elements are aligned
+        // to less than a pointer (4 byte aligned elements on a 64 bit host)
+        size_t array_storage_size = PoolAllocator::align_up(_element_size * elements, alignof(array_link));
         void *temp = mbed_ualloc(array_storage_size + sizeof(array_link), _alloc_traits);
         if (temp == NULL)
             return NULL;
@@ -24,6 +24,7 @@
 #include "core-util/Array.h"
 #include "ualloc/ualloc.h"
 #include <stdio.h>
+#include <utility>
 
 /** A reentrant binary heap class (https://en.wikipedia.org/wiki/Heap_(data_structure))
   * It uses the implicit representation: the heap's nodes are stored in an Array and accessed
@@ -88,7 +89,11 @@ public:
     }
 };
 
-template <typename T, typename Comparator=MinCompare<T> >
+/** The heap operations are protected by a CriticalSectionLock by default. A different locking
+  * policy (for example NullLock, for heaps protected by an external lock) can be given as the
+  * third template argument.
+  */
+template <typename T, typename Comparator=MinCompare<T>, typename Lock=CriticalSectionLock>
 class BinaryHeap {
 public:
     /** Construct a new binary heap
@@ -119,7 +124,7 @@ public:
       * @returns true for success, false for failure (out of memory)
       */
     bool insert(const T& p) {
-        CriticalSectionLock lock;
+        Lock lock;
         if (!_array.push_back(p))
             return false;
         if (++_elements > 1) {
@@ -145,12 +150,76 @@ public:
          if (_elements == 0) {
             CORE_UTIL_RUNTIME_ERROR("get_root() called on an empty BinaryHeap");
         }
-        CriticalSectionLock lock;
-        T temp = _array[0];
+        Lock lock;
+        T temp(std::move(_array[0]));
         remove_root();
         return temp;
     }
 
+    /** Remove up to 'n' elements from the root of the heap in a single critical section
+      * The elements are moved to 'out' in heap order (best element first).
+      * @param n maximum number of elements to remove
+      * @param out array of at least 'n' elements that receives the removed elements
+      * @returns the number of removed elements
+      */
+    size_t pop_n(size_t n, T* out) {
+        Lock lock;
+        size_t count = 0;
+        while ((count < n) && (_elements > 0)) {
+            _pop_into(out[count ++]);
+        }
+        return count;
+    }
+
+    /** Remove elements from the root of the heap while they satisfy a predicate, in a single
+      * critical section. This is useful for draining all the expired timers at once.
+      * The elements are moved to 'out' in heap order (best element first).
+      * @param pred the predicate (called with a const reference to the root)
+      * @param out array of at least 'max_elements' elements that receives the removed elements
+      * @param max_elements maximum number of elements to remove
+      * @returns the number of removed elements
+      */
+    template <typename Predicate>
+    size_t pop_while(Predicate pred, T* out, size_t max_elements) {
+        Lock lock;
+        size_t count = 0;
+        while ((count < max_elements) && (_elements > 0) && pred((const T&)_array[0])) {
+            _pop_into(out[count ++]);
+        }
+        return count;
+    }
+
+    /** Copy the 'k' best elements in the heap to 'out', in heap order, without changing the heap
+      * The heap is explored best-first: a small heap of candidate nodes starts with the root,
+      * and each time the best candidate is copied to 'out' its two children become candidates.
+      * This examines at most 2k - 1 nodes and runs in O(k log k), whatever the heap's size.
+      * @param k number of elements to copy
+      * @param out array of at least 'k' elements that receives the copies
+      * @param frontier scratch array of at least 'k' indices, used for the candidate nodes
+      * @returns the number of copied elements (less than 'k' if the heap has less than 'k' elements)
+      */
+    size_t top_k(size_t k, T* out, size_t* frontier) const {
+        Lock lock;
+        size_t count = 0, candidates = 0;
+        if ((k > 0) && (_elements > 0)) {
+            frontier[candidates ++] = 0;
+        }
+        while (candidates > 0) {
+            size_t node = frontier[0];
+            frontier[0] = frontier[-- candidates];
+            _frontier_propagate_down(frontier, candidates);
+            out[count ++] = _array[node];
+            if (count == k)
+                break;
+            // After 'count' copies there are at most count + 1 candidates, so they fit in 'k'
+            for (size_t child = _left(node); (child <= _right(node)) && (child < _elements); child ++) {
+                frontier[candidates] = child;
+                _frontier_propagate_up(frontier, candidates ++);
+            }
+        }
+        return count;
+    }
+
     /** Removes the element at the root of the heap, possibly re-shaping the heap
       * to keep it consistent
       */
@@ -158,7 +227,7 @@ public:
         if (_elements == 0)
             return;
         {
-            CriticalSectionLock lock;
+            Lock lock;
             _swap(0, --_elements); // element 0 will be destroyed by 'pop_back()' below
             _array.pop_back();
             if (_elements > 1) {
@@ -176,29 +245,46 @@ public:
 
     /** Remove an element from the heap. The element is searched in the heap by value using
       * the equality operator (==), then removed. If multiple elements with the same value
-      * as 'e' are found, only the first one is removed.
+      * as 'e' are found, only one of them is removed.
       * @returns true if the element was found and removed, false otherwise.
       */
     bool remove(const T& e) {
         if (_elements == 0)
             return false;
         {
-            CriticalSectionLock lock;
-            size_t i;
-            for (i = 0; i < _elements; i ++) {
-                if (e == _array[i])
-                    break;
-            }
+            Lock lock;
+            size_t i = _array.find_if(_equals(e));
             if (i == _elements)
                 return false;
             _swap(i, --_elements); // element i will be destroyed by 'pop_back()' below
             _array.pop_back();
-            if (_elements > 1)
-                _propagate_down(i);
+            if (i < _elements)
+                _restore(i);
             return true;
         }
     }
 
+    /** Remove all the elements that satisfy a predicate from the heap.
+      * The elements are removed in a single pass over the heap, after which the heap is
+      * rebuilt in O(n), so this is much faster than calling remove() for each element.
+      * @param pred the predicate (called with a const reference to each element)
+      * @returns the number of removed elements
+      */
+    template <typename Predicate>
+    size_t remove_if(Predicate pred) {
+        if (_elements == 0)
+            return 0;
+        {
+            Lock lock;
+            size_t removed = _array.remove_if(pred);
+            if (removed > 0) {
+                _elements -= removed;
+                _heapify();
+            }
+            return removed;
+        }
+    }
+
     /** Check the heap's consistency by applying the user supplied comparison function to its nodes
       * @returns true if the heap is consistent, false otherwise
       */
@@ -233,6 +319,61 @@ private:
         return (i - 1) / 2;
     }
 
+    void _pop_into(T& dest) {
+        // Move the root to 'dest', then replace it with the last element in the heap
+        dest = std::move(_array[0]);
+        if (--_elements > 0) {
+            _array[0] = std::move(_array[_elements]);
+        }
+        _array.pop_back();
+        if (_elements > 1) {
+            _propagate_down(0);
+        }
+    }
+
+    void _frontier_propagate_up(size_t* frontier, size_t pos) const {
+        // Like _propagate_up, for the heap of candidate node indices used by top_k()
+        while (pos > 0) {
+            size_t parent = _parent(pos);
+            if (_comparator(_array[frontier[parent]], _array[frontier[pos]]))
+                break;
+            std::swap(frontier[pos], frontier[parent]);
+            pos = parent;
+        }
+    }
+
+    void _frontier_propagate_down(size_t* frontier, size_t candidates) const {
+        // Like _propagate_down, for the heap of candidate node indices used by top_k()
+        size_t pos = 0;
+        while (true) {
+            size_t left = _left(pos), right = _right(pos), temp;
+            if (left >= candidates)
+                break;
+            temp = ((right < candidates) && !_comparator(_array[frontier[left]], _array[frontier[right]])) ? right : left;
+            if (_comparator(_array[frontier[pos]], _array[frontier[temp]]))
+                break;
+            std::swap(frontier[pos], frontier[temp]);
+            pos = temp;
+        }
+    }
+
+    void _restore(size_t node) {
+        // This is called when the node at 'node' is replaced with the last node in the heap
+        // The new node might be out of order relative to either its parent or its children
+        if ((node > 0) && _comparator(_array[node], _array[_parent(node)])) {
+            _propagate_up(node);
+        } else {
+            _propagate_down(node);
+        }
+    }
+
+    void _heapify() {
+        // Rebuild the heap bottom-up (Floyd's method) in O(n)
+        for (size_t node = _elements / 2; node > 0; node --) {
+            _propagate_down(node - 1);
+        }
+    }
+
     void _propagate_up(size_t node) {
         // This is called when a node is added in the last position in the heap
         // We might need to move the node up towards the parent until the heap property
@@ -274,13 +415,26 @@ private:
 
     void _swap(size_t pos1, size_t pos2) {
         if (pos1 != pos2) {
-            T temp = _array[pos1];
-            _array[pos1] = _array[pos2];
-            _array[pos2] = temp;
+            T temp(std::move(_array[pos1]));
+            _array[pos1] = std::move(_array[pos2]);
+            _array[pos2] = std::move(temp);
         }
     }
 
-    Array<T> _array;
+    class _equals {
+    public:
+        _equals(const T& e): _e(e) {
+        }
+
+        bool operator ()(const T& other) const {
+            return _e == other;
+        }
+
+    private:
+        const T& _e;
+    };
+
+    Array<T, Lock> _array;
     Comparator _comparator;
     volatile size_t _elements;
 };
@@ -0,0 +1,306 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_CALLABLE_H
+#define MBED_CALLABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "core-util/assert.h"
+#include "core-util/PoolAllocator.h"
+#include "ualloc/ualloc.h"
+
+#ifdef YOTTA_CFG_UTIL_CALLABLE_INLINE_SIZE
+#define CALLABLE_INLINE_SIZE (YOTTA_CFG_UTIL_CALLABLE_INLINE_SIZE)
+#else
+#define CALLABLE_INLINE_SIZE 16
+#endif
+
+namespace mbed {
+namespace util {
+
+template <typename Signature, size_t InlineSize = CALLABLE_INLINE_SIZE>
+class Callable;
+
+/** A class for storing and calling any callable object: a lambda, a function object, a static
+ *  function or a FunctionPointer.
+ *
+ *  The target is stored in an inline buffer of InlineSize bytes when it fits. Larger targets
+ *  (for example lambdas with many captures) are stored in a memory block allocated with
+ *  mbed_ualloc, or from a PoolAllocator or ExtendablePoolAllocator passed to the constructor,
+ *  instead of being rejected at compile time like the bound arguments of FunctionPointerBind.
+ *  Copying a Callable copies its target (allocating a new block from the same allocator if
+ *  needed); moving it moves the target, or simply takes over the block.
+ *
+ *  If the memory for the target can't be allocated, the Callable is left empty.
+ *
+ *  Usage:
+ *  @code
+ *  int total = 0;
+ *  Callable<void(int)> add([&total](int x) { total += x; });
+ *  add(5);
+ *  @endcode
+ */
+template <typename R, typename... Args, size_t InlineSize>
+class Callable<R(Args...), InlineSize> {
+public:
+    /** Create an empty Callable
+     */
+    Callable(): _ops(NULL) {
+    }
+
+    /** Create a Callable that stores a copy of 'f'. The copy is kept in the inline buffer
+     *  if it fits there, otherwise in a block allocated with mbed_ualloc.
+     *
+     *  @param f The callable object
+     */
+    template <typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Callable>::value>::type>
+    Callable(F&& f): _ops(NULL) {
+        attach<PoolAllocator>(std::forward<F>(f), NULL);
+    }
+
+    /** Create a Callable that stores a copy of 'f'. The copy is kept in the inline buffer
+     *  if it fits there, otherwise in a block allocated from 'allocator'.
+     *
+     *  @param f The callable object
+     *  @param allocator PoolAllocator or ExtendablePoolAllocator with elements of at least
+     *         get_allocation_size<F>() bytes
+     */
+    template <typename F, typename Allocator>
+    Callable(F&& f, Allocator& allocator): _ops(NULL) {
+        attach<Allocator>(std::forward<F>(f), &allocator);
+    }
+
+    Callable(const Callable& other): _ops(NULL) {
+        copy(other);
+    }
+
+    Callable(Callable&& other): _ops(NULL) {
+        move(other);
+    }
+
+    ~Callable() {
+        clear();
+    }
+
+    Callable& operator=(const Callable& rhs) {
+        if (this != &rhs) {
+            clear();
+            copy(rhs);
+        }
+        return *this;
+    }
+
+    Callable& operator=(Callable&& rhs) {
+        if (this != &rhs) {
+            clear();
+            move(rhs);
+        }
+        return *this;
+    }
+
+    /** Destroy the target, making this instance empty
+     */
+    void clear() {
+        if (_ops != NULL) {
+            _ops->destructor(&_storage);
+            _ops = NULL;
+        }
+    }
+
+    inline operator bool(void) const {
+        return _ops != NULL;
+    }
+
+    /** Call the target
+     */
+    R call(Args... args) {
+#ifndef YOTTA_CFG_UTIL_FUNCTIONPOINTER_DISABLE_NULL_CHECK
+        CORE_UTIL_ASSERT(_ops != NULL);
+#endif
+        return _ops->invoke(&_storage, std::forward<Args>(args)...);
+    }
+
+    R operator ()(Args... args) {
+        return call(std::forward<Args>(args)...);
+    }
+
+    /** Check if a target of type F is stored in the inline buffer
+     *  @returns true if F is stored inline, false if it needs an allocation
+     */
+    template <typename F>
+    static bool is_inline() {
+        return fits_inline<typename std::decay<F>::type>::value;
+    }
+
+    /** Size of the memory blocks used for targets of type F that don't fit in the inline buffer
+     *  @returns the element size needed in the allocator passed to the constructor
+     */
+    template <typename F>
+    static size_t get_allocation_size() {
+        return sizeof(typename remote_target<typename std::decay<F>::type, PoolAllocator>::block);
+    }
+
+private:
+    typedef typename std::aligned_storage<InlineSize>::type storage_t;
+
+    // Operations on the stored target, one table for each target type (like ArgOps)
+    struct CallableOps {
+        R (*invoke)(void *storage, Args&&... args);
+        bool (*copy)(void *dest, const void *src);
+        void (*move)(void *dest, void *src);
+        void (*destructor)(void *storage);
+    };
+
+    template <typename F>
+    struct fits_inline : public std::integral_constant<bool,
+        (sizeof(F) <= sizeof(storage_t)) && (std::alignment_of<F>::value <= std::alignment_of<storage_t>::value)> {
+    };
+
+    // Target stored in the inline buffer
+    template <typename F>
+    struct inline_target {
+        static F *get(void *storage) {
+            return reinterpret_cast<F*>(storage);
+        }
+
+        static R invoke(void *storage, Args&&... args) {
+            return (*get(storage))(std::forward<Args>(args)...);
+        }
+
+        static bool copy(void *dest, const void *src) {
+            new(dest) F(*get(const_cast<void*>(src)));
+            return true;
+        }
+
+        static void move(void *dest, void *src) {
+            new(dest) F(std::move(*get(src)));
+            get(src)->~F();
+        }
+
+        static void destructor(void *storage) {
+            get(storage)->~F();
+        }
+
+        static const CallableOps *ops() {
+            static const CallableOps table = {&invoke, &copy, &move, &destructor};
+            return &table;
+        }
+
+        template <typename G>
+        static bool create(void *storage, G&& f, void *) {
+            new(storage) F(std::forward<G>(f));
+            return true;
+        }
+    };
+
+    // Target stored in a block from 'allocator', or from mbed_ualloc if 'allocator' is NULL
+    template <typename F, typename Allocator>
+    struct remote_target {
+        struct block {
+            template <typename G>
+            block(G&& _f, Allocator *_allocator): f(std::forward<G>(_f)), allocator(_allocator) {
+            }
+
+            F f;
+            Allocator *allocator;
+        };
+
+        static block *get(const void *storage) {
+            return *reinterpret_cast<block* const*>(storage);
+        }
+
+        static R invoke(void *storage, Args&&... args) {
+            return get(storage)->f(std::forward<Args>(args)...);
+        }
+
+        static bool copy(void *dest, const void *src) {
+            block *b = get(src);
+            return create(dest, b->f, b->allocator);
+        }
+
+        static void move(void *dest, void *src) {
+            *reinterpret_cast<block**>(dest) = get(src);
+        }
+
+        static void destructor(void *storage) {
+            block *b = get(storage);
+            Allocator *allocator = b->allocator;
+            b->~block();
+            if (allocator) {
+                allocator->free(b);
+            } else {
+                mbed_ufree(b);
+            }
+        }
+
+        static const CallableOps *ops() {
+            static const CallableOps table = {&invoke, &copy, &move, &destructor};
+            return &table;
+        }
+
+        template <typename G>
+        static bool create(void *storage, G&& f, Allocator *allocator) {
+            void *mem;
+            if (allocator) {
+                mem = allocator->alloc();
+            } else {
+                UAllocTraits_t traits = {0};
+                mem = mbed_ualloc(sizeof(block), traits);
+            }
+            if (mem == NULL) {
+                return false;
+            }
+            *reinterpret_cast<block**>(storage) = new(mem) block(std::forward<G>(f), allocator);
+            return true;
+        }
+    };
+
+    template <typename Allocator, typename F>
+    void attach(F&& f, Allocator *allocator) {
+        typedef typename std::decay<F>::type target_t;
+        typedef typename std::conditional<fits_inline<target_t>::value,
+            inline_target<target_t>, remote_target<target_t, Allocator> >::type target;
+        if (target::create(&_storage, std::forward<F>(f), allocator)) {
+            _ops = target::ops();
+        }
+    }
+
+    void copy(const Callable& other) {
+        if ((other._ops != NULL) && other._ops->copy(&_storage, &other._storage)) {
+            _ops = other._ops;
+        }
+    }
+
+    void move(Callable& other) {
+        if (other._ops != NULL) {
+            other._ops->move(&_storage, &other._storage);
+            _ops = other._ops;
+            other._ops = NULL;
+        }
+    }
+
+    const CallableOps *_ops;
+    storage_t _storage;
+};
+
+} /* namespace util */
+} /* namespace mbed */
+
+#endif // MBED_CALLABLE_H
@@ -0,0 +1,227 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MBED_UTIL_CONCURRENT_PRIORITY_QUEUE_H__
+#define __MBED_UTIL_CONCURRENT_PRIORITY_QUEUE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core-util/BinaryHeap.h"
+#include "core-util/SpinLock.h"
+#include "core-util/atomic_ops.h"
+#include "ualloc/ualloc.h"
+
+/** A concurrent priority queue that lets multiple threads insert and pop elements in parallel.
+  *
+  * It uses the "MultiQueue" design: the elements are spread over a number of independent
+  * binary heaps, each protected by its own SpinLock. insert() adds the element to a randomly
+  * chosen heap that is not locked by someone else; pop_root() looks at the roots of two randomly
+  * chosen heaps and pops the better one. Contention is therefore spread over all the heaps
+  * instead of being serialized by a single CriticalSectionLock as in BinaryHeap.
+  *
+  * The price for this is relaxed ordering: pop_root() returns an element that is close to the
+  * root of the whole queue, but not necessarily the root itself. With 'num_queues' heaps, the
+  * returned element is expected to be among the first O(num_queues) elements. Use BinaryHeap
+  * if the exact order is needed. pop_root() only fails when all the heaps were seen empty.
+  *
+  * The elements are ordered using the same comparator classes as BinaryHeap (MinCompare and
+  * MaxCompare). A good choice for 'num_queues' is twice the number of threads using the queue.
+  *
+  * Usage example:
+  *
+  * @code
+  * #include "core-util/ConcurrentPriorityQueue.h"
+  *
+  * ConcurrentPriorityQueue<uint32_t> queue;
+  *
+  * int main() {
+  *     UAllocTraits_t traits = {0};
+  *     queue.init(8, 32, 32, traits);
+  *     // ... threads call queue.insert(...) and queue.pop_root(...) ...
+  * }
+  * @endcode
+  */
+namespace mbed {
+namespace util {
+
+template <typename T, typename Comparator=MinCompare<T> >
+class ConcurrentPriorityQueue {
+public:
+    /** Construct a new concurrent priority queue
+      */
+    ConcurrentPriorityQueue(const Comparator& comparator = Comparator()):
+        _queues(NULL), _num_queues(0), _seed(0x9E3779B9UL), _comparator(comparator) {
+    }
+
+    /* Forbid copy and assignment */
+    ConcurrentPriorityQueue(const ConcurrentPriorityQueue&) = delete;
+    ConcurrentPriorityQueue(ConcurrentPriorityQueue&&) = delete;
+    ConcurrentPriorityQueue& operator =(const ConcurrentPriorityQueue&) = delete;
+    ConcurrentPriorityQueue& operator =(ConcurrentPriorityQueue&&) = delete;
+
+    /** Destructor. It destroys all the elements and frees all allocated memory
+      */
+    ~ConcurrentPriorityQueue() {
+        if (_queues != NULL) {
+            for (size_t i = 0; i < _num_queues; i ++) {
+                _queues[i].~sub_queue();
+            }
+            mbed_ufree(_queues);
+        }
+    }
+
+    /** Initialize the queue
+      * @param num_queues number of internal heaps (at least 2)
+      * @param initial_capacity initial capacity of each internal heap
+      * @param grow_capacity number of elements to add when the capacity of an internal heap is exceeded
+      * @param alloc_traits allocator traits (for mbed_ualloc)
+      * @param alignment alignment of each element in the internal heaps
+      * @returns true if the initialization succeeded, false otherwise
+      */
+    bool init(size_t num_queues, size_t initial_capacity, size_t grow_capacity, UAllocTraits_t alloc_traits, unsigned alignment = MBED_UTIL_POOL_ALLOC_DEFAULT_ALIGN) {
+        if ((_queues != NULL) || (num_queues < 2))
+            return false; // prevent repeated initialization
+        _queues = (sub_queue*)mbed_ualloc(num_queues * sizeof(sub_queue), alloc_traits);
+        if (_queues == NULL)
+            return false;
+        for (size_t i = 0; i < num_queues; i ++) {
+            new(&_queues[i]) sub_queue(_comparator);
+            _num_queues = i + 1;
+            if (!_queues[i].heap.init(initial_capacity, grow_capacity, alloc_traits, alignment))
+                return false;
+        }
+        return true;
+    }
+
+    /** Inserts an element in the queue
+      * @param e the element to insert
+      * @returns true for success, false for failure (out of memory)
+      */
+    bool insert(const T& e) {
+        size_t i = _random_index();
+        // Use the first heap that is not locked by someone else
+        while (!_queues[i].lock.try_lock()) {
+            i = (i + 1) % _num_queues;
+        }
+        bool res = _queues[i].heap.insert(e);
+        _queues[i].lock.unlock();
+        return res;
+    }
+
+    /** Removes an element close to the root of the queue
+      * @param e will be set to the removed element
+      * @returns true if an element was removed, false if the queue is empty
+      */
+    bool pop_root(T& e) {
+        for (size_t attempt = 0; attempt < _num_queues; attempt ++) {
+            sub_queue *q1 = &_queues[_random_index()], *q2 = &_queues[_random_index()];
+            if (!q1->lock.try_lock())
+                continue;
+            if ((q2 != q1) && q2->lock.try_lock()) {
+                // Choose the heap with the better root, release the other one
+                if (q1->heap.is_empty() ||
+                    (!q2->heap.is_empty() && !_comparator(q1->heap.get_root(), q2->heap.get_root()))) {
+                    sub_queue *temp = q1;
+                    q1 = q2;
+                    q2 = temp;
+                }
+                q2->lock.unlock();
+            }
+            if (_pop_locked(q1, e))
+                return true;
+        }
+        // The randomly chosen heaps were busy or empty, so look at all of them before giving up
+        for (size_t i = 0; i < _num_queues; i ++) {
+            _queues[i].lock.lock();
+            if (_pop_locked(&_queues[i], e))
+                return true;
+        }
+        return false;
+    }
+
+    /** Checks if the queue is empty
+      * The result is only a snapshot if other threads are using the queue at the same time.
+      * @returns true if the queue is empty, false otherwise
+      */
+    bool is_empty() const {
+        for (size_t i = 0; i < _num_queues; i ++) {
+            if (!_queues[i].heap.is_empty())
+                return false;
+        }
+        return true;
+    }
+
+    /** Returns the number of elements in the queue
+      * The result is only a snapshot if other threads are using the queue at the same time.
+      * @returns number of elements in the queue
+      */
+    size_t get_num_elements() const {
+        size_t elements = 0;
+        for (size_t i = 0; i < _num_queues; i ++) {
+            elements += _queues[i].heap.get_num_elements();
+        }
+        return elements;
+    }
+
+    /** Returns the number of internal heaps
+      * @returns number of internal heaps
+      */
+    size_t get_num_queues() const {
+        return _num_queues;
+    }
+
+private:
+    struct sub_queue {
+        sub_queue(const Comparator& comparator): lock(), heap(comparator) {
+        }
+
+        SpinLock lock;
+        BinaryHeap<T, Comparator, NullLock> heap;
+    };
+
+    bool _pop_locked(sub_queue *q, T& e) {
+        // Called with 'q' locked, always unlocks it
+        bool res = !q->heap.is_empty();
+        if (res)
+            e = q->heap.pop_root();
+        q->lock.unlock();
+        return res;
+    }
+
+    size_t _random_index() {
+        // xorshift32. Concurrent callers can read the same '_seed' and overwrite each other's
+        // update; that only makes the choice of heap less random, which is harmless since the
+        // heaps are locked independently. Relaxed atomics make this well defined without
+        // ordering anything.
+        uint32_t x = atomic_load(&_seed, atomic_relaxed);
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        atomic_store(&_seed, x, atomic_relaxed);
+        return x % _num_queues;
+    }
+
+    sub_queue *_queues;
+    size_t _num_queues;
+    uint32_t _seed;
+    Comparator _comparator;
+};
+
+} // namespace util
+} // namespace mbed
+
+#endif // #ifndef __MBED_UTIL_CONCURRENT_PRIORITY_QUEUE_H__
@@ -0,0 +1,306 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MBED_UTIL_COROUTINE_H__
+#define __MBED_UTIL_COROUTINE_H__
+
+/* Coroutines need a C++20 compiler; with older compilers this header only defines
+ * CORE_UTIL_HAS_COROUTINES to 0.
+ */
+#if defined(__cpp_impl_coroutine) && (__cpp_impl_coroutine >= 201902L)
+#define CORE_UTIL_HAS_COROUTINES 1
+#else
+#define CORE_UTIL_HAS_COROUTINES 0
+#endif
+
+#if CORE_UTIL_HAS_COROUTINES
+
+#include <stddef.h>
+#include <stdint.h>
+#include <coroutine>
+#include "core-util/assert.h"
+#include "core-util/EventQueue.h"
+#include "core-util/FunctionPointer.h"
+#include "core-util/PoolAllocator.h"
+#include "core-util/TimerQueue.h"
+#include "ualloc/ualloc.h"
+
+namespace mbed {
+namespace util {
+
+/** Allocates the frames of EventTask coroutines.
+  *
+  * Frames are taken from the PoolAllocator set with set_pool() when they fit in its elements,
+  * and from mbed_ualloc otherwise (or when the pool is exhausted). The pool must be set before
+  * the first coroutine is started and must not change while coroutines are running.
+  */
+class CoroutineFrameAllocator {
+public:
+    /** Set the pool for the coroutine frames
+      * @param pool the pool (NULL to always use mbed_ualloc)
+      * @param element_size the size of the elements of 'pool'
+      */
+    static void set_pool(PoolAllocator *pool, size_t element_size) {
+        get_state().pool = pool;
+        get_state().element_size = element_size;
+    }
+
+    static void *alloc(size_t size) {
+        state& s = get_state();
+        void *p = NULL;
+        if ((s.pool != NULL) && (size <= s.element_size)) {
+            p = s.pool->alloc();
+        }
+        if (p == NULL) {
+            UAllocTraits_t traits = {0};
+            p = mbed_ualloc(size, traits);
+        }
+        return p;
+    }
+
+    static void free(void *p) {
+        state& s = get_state();
+        if ((s.pool != NULL) && s.pool->owns(p)) {
+            s.pool->free(p);
+        } else {
+            mbed_ufree(p);
+        }
+    }
+
+private:
+    struct state {
+        PoolAllocator *pool;
+        size_t element_size;
+    };
+
+    static state& get_state() {
+        // zero initialized, no construction needed
+        static state s;
+        return s;
+    }
+};
+
+/** Return type of coroutines that are driven by Events.
+  *
+  * An EventTask coroutine starts running when it is called, until its first co_await.
+  * The awaitables below suspend it and post an Event that resumes it later, from
+  * EventQueue::dispatch() or TimerQueue::dispatch(), so a chain of callbacks can be written
+  * as sequential code. The Events are bound in place and the queue nodes come from the pools
+  * of the queues, so a step doesn't allocate any memory; the frame of the coroutine is
+  * allocated once, by CoroutineFrameAllocator. The frame is freed when the coroutine returns,
+  * or when the Event that would resume it is destroyed without being called (for example
+  * when its queue is destroyed), which also destroys the local variables of the coroutine.
+  * The Events that resume a coroutine must be called and destroyed in a single thread.
+  *
+  * Usage:
+  * @code
+  * EventTask blink(EventQueue& queue, TimerQueue& timers) {
+  *     while (true) {
+  *         led = !led;
+  *         co_await sleep_for(timers, 500);
+  *         co_await post_to(queue);
+  *     }
+  * }
+  * @endcode
+  */
+class EventTask {
+public:
+    struct promise_type {
+        // The coroutine doesn't stop at its final suspend point unless Events still refer
+        // to its frame, in which case the last one frees it
+        struct final_awaiter {
+            bool await_ready() const noexcept {
+                return promise->event_refs == 0;
+            }
+
+            void await_suspend(std::coroutine_handle<>) const noexcept {
+            }
+
+            void await_resume() const noexcept {
+            }
+
+            promise_type *promise;
+        };
+
+        promise_type(): event_refs(0), waiting(false) {
+        }
+
+        EventTask get_return_object() {
+            return EventTask(true);
+        }
+
+        static EventTask get_return_object_on_allocation_failure() {
+            return EventTask(false);
+        }
+
+        std::suspend_never initial_suspend() noexcept {
+            return std::suspend_never();
+        }
+
+        final_awaiter final_suspend() noexcept {
+            return final_awaiter{this};
+        }
+
+        void return_void() {
+        }
+
+        void unhandled_exception() {
+            CORE_UTIL_RUNTIME_ERROR("Unhandled exception in an EventTask coroutine\r\n");
+        }
+
+        static void *operator new(size_t size) noexcept {
+            return CoroutineFrameAllocator::alloc(size);
+        }
+
+        static void operator delete(void *p) {
+            CoroutineFrameAllocator::free(p);
+        }
+
+        // Number of EventResumers that refer to the frame
+        unsigned event_refs;
+        // True while the coroutine waits for one of the Events to be called
+        bool waiting;
+    };
+
+    /** Checks if the coroutine was started
+      * @returns true if the coroutine started, false if its frame couldn't be allocated
+      */
+    explicit operator bool() const {
+        return _started;
+    }
+
+private:
+    EventTask(bool started): _started(started) {
+    }
+
+    bool _started;
+};
+
+/** The argument bound to the Events that resume an EventTask coroutine. It counts the
+  * references to the frame, so that the frame is destroyed when the last Event is destroyed
+  * while the coroutine still waits for it, or after the coroutine returned.
+  */
+class EventResumer {
+public:
+    typedef std::coroutine_handle<EventTask::promise_type> handle_t;
+
+    explicit EventResumer(handle_t h): _h(h) {
+        _h.promise().event_refs ++;
+    }
+
+    EventResumer(const EventResumer& other): _h(other._h) {
+        if (_h)
+            _h.promise().event_refs ++;
+    }
+
+    EventResumer(EventResumer&& other): _h(other._h) {
+        other._h = nullptr;
+    }
+
+    EventResumer& operator =(const EventResumer&) = delete;
+    EventResumer& operator =(EventResumer&&) = delete;
+
+    ~EventResumer() {
+        if (!_h)
+            return;
+        EventTask::promise_type& p = _h.promise();
+        if ((-- p.event_refs == 0) && (p.waiting || _h.done()))
+            _h.destroy();
+    }
+
+    void resume() const {
+        _h.promise().waiting = false;
+        _h.resume();
+    }
+
+private:
+    handle_t _h;
+};
+
+/** Awaitable that resumes the coroutine from an Event. Use post_to() and sleep_for() to
+  * create one. If the Event can't be posted, the coroutine continues immediately.
+  */
+template <typename Poster>
+class EventAwaiter {
+public:
+    EventAwaiter(const Poster& poster): _poster(poster) {
+    }
+
+    bool await_ready() const {
+        return false;
+    }
+
+    bool await_suspend(EventResumer::handle_t h) {
+        // 'resumer' keeps the frame alive if the Event is destroyed before post() returns
+        EventResumer resumer(h);
+        h.promise().waiting = true;
+        bool posted = _poster(FunctionPointer1<void, EventResumer>(&EventAwaiter::resume).bind(resumer));
+        h.promise().waiting = posted;
+        return posted;
+    }
+
+    void await_resume() const {
+    }
+
+private:
+    static void resume(EventResumer resumer) {
+        resumer.resume();
+    }
+
+    Poster _poster;
+};
+
+struct EventQueuePoster {
+    bool operator ()(Event&& e) const {
+        return queue->post(std::move(e));
+    }
+
+    EventQueue *queue;
+};
+
+struct TimerQueuePoster {
+    bool operator ()(Event&& e) const {
+        return timers->post_in(std::move(e), delay).is_valid();
+    }
+
+    TimerQueue *timers;
+    uint32_t delay;
+};
+
+/** Suspend the coroutine and resume it from the next EventQueue::dispatch() of 'queue'
+  * @param queue the queue
+  * @returns the awaitable
+  */
+inline EventAwaiter<EventQueuePoster> post_to(EventQueue& queue) {
+    return EventAwaiter<EventQueuePoster>(EventQueuePoster{&queue});
+}
+
+/** Suspend the coroutine and resume it when a timer of 'timers' expires
+  * @param timers the timer queue
+  * @param delay number of ticks to wait, relative to the time of the last dispatch()
+  * @returns the awaitable
+  */
+inline EventAwaiter<TimerQueuePoster> sleep_for(TimerQueue& timers, uint32_t delay) {
+    return EventAwaiter<TimerQueuePoster>(TimerQueuePoster{&timers, delay});
+}
+
+} // namespace util
+} // namespace mbed
+
+#endif // CORE_UTIL_HAS_COROUTINES
+
+#endif // #ifndef __MBED_UTIL_COROUTINE_H__
@@ -50,6 +50,16 @@ public:
 
 };
 
+/** RAII object that does nothing. It can be used instead of CriticalSectionLock as the
+  * locking policy of containers (Array, BinaryHeap) that are already protected by another
+  * lock, or that are never accessed concurrently.
+  */
+class NullLock {
+public:
+    NullLock() {
+    }
+};
+
 } // namespace util
 } // namespace mbed
 
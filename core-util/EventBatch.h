@@ -0,0 +1,226 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MBED_UTIL_EVENT_BATCH_H__
+#define __MBED_UTIL_EVENT_BATCH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <tuple>
+#include <utility>
+#include "core-util/CriticalSectionLock.h"
+#include "core-util/assert.h"
+#include "core-util/atomic_ops.h"
+#include "core-util/EventQueue.h"
+#include "core-util/FunctionPointer.h"
+#include "ualloc/ualloc.h"
+
+/** Collects the arguments of many calls to the same handler and passes them all in one call.
+  *
+  * Instead of binding the same FunctionPointer to different arguments thousands of times
+  * (one Event, one queue node and one indirect call each), add() appends the arguments to
+  * the batch and flush() calls the batch handler once with an array of all the argument
+  * tuples collected so far. If the batch is given an EventQueue, the first add() to an
+  * empty batch posts a single Event that flushes it, so the calls are coalesced until the
+  * queue is dispatched.
+  *
+  * add() can be called from interrupt handlers and threads at the same time: it copies the
+  * arguments in a CriticalSectionLock. The batch uses two buffers, so flush() only holds the
+  * lock to swap them and calls the handler outside it while new arguments are collected in
+  * the other buffer. Only one thread can call flush().
+  *
+  * Usage example:
+  *
+  * @code
+  * #include "core-util/EventBatch.h"
+  *
+  * void packets_received(const EventBatch<uint8_t*, size_t>::ArgStruct *packets, size_t count) {
+  *     for (size_t i = 0; i < count; i ++)
+  *         process(std::get<0>(packets[i]), std::get<1>(packets[i]));
+  * }
+  *
+  * EventBatch<uint8_t*, size_t> batch(packets_received, &queue);
+  *
+  * void rx_irq() {
+  *     batch.add(buffer, length);
+  * }
+  * @endcode
+  */
+namespace mbed {
+namespace util {
+
+template <typename... Args>
+class EventBatch {
+public:
+    /** The arguments of one add(), as stored by the bound Events of VariadicFunctionPointer
+      */
+    typedef std::tuple<Args...> ArgStruct;
+
+    /** The batch handler, called with the collected arguments and their number
+      */
+    typedef FunctionPointer2<void, const ArgStruct*, size_t> BatchHandler;
+
+    /** Construct a new batch
+      * @param handler the batch handler
+      * @param queue if not NULL, the queue where the batch posts an Event that flushes it
+      */
+    EventBatch(const BatchHandler& handler, EventQueue *queue = NULL):
+        _handler(handler), _queue(queue), _capacity(0), _active(0), _posted(false), _queued_events(0) {
+        _buffers[0].args = _buffers[1].args = NULL;
+        _buffers[0].count = _buffers[1].count = 0;
+    }
+
+    /* Forbid copy and assignment */
+    EventBatch(const EventBatch&) = delete;
+    EventBatch(EventBatch&&) = delete;
+    EventBatch& operator =(const EventBatch&) = delete;
+    EventBatch& operator =(EventBatch&&) = delete;
+
+    /** Destructor. The arguments that were not flushed are destroyed
+      * The flush Event posted to the queue points to the batch, so the batch must not be
+      * destroyed while that Event is still in the queue (calling flush() doesn't remove it):
+      * dispatch the queue first. The batch counts the flush Events in the queue and asserts
+      * that there are none left.
+      */
+    ~EventBatch() {
+        CORE_UTIL_ASSERT_MSG(atomic_load(&_queued_events) == 0, "EventBatch destroyed with a flush Event still in the queue");
+        for (unsigned i = 0; i < 2; i ++) {
+            _clear(_buffers[i]);
+            if (_buffers[i].args != NULL)
+                mbed_ufree(_buffers[i].args);
+        }
+    }
+
+    /** Initialize the batch
+      * @param capacity maximum number of calls collected between two flushes
+      * @param alloc_traits allocator traits (for mbed_ualloc)
+      * @returns true if the initialization succeeded, false otherwise
+      */
+    bool init(size_t capacity, UAllocTraits_t alloc_traits) {
+        if ((_capacity != 0) || (capacity == 0))
+            return false; // prevent repeated initialization
+        for (unsigned i = 0; i < 2; i ++) {
+            _buffers[i].args = (ArgStruct*)mbed_ualloc(capacity * sizeof(ArgStruct), alloc_traits);
+            if (_buffers[i].args == NULL)
+                return false;
+        }
+        _capacity = capacity;
+        return true;
+    }
+
+    /** Add the arguments of a call to the batch. If the flush Event can't be posted to the
+      * queue, the arguments are kept and the next add() tries again, even if the batch is full.
+      * @returns true for success, false if the batch is full
+      */
+    template <typename... AddArgs>
+    bool add(AddArgs&&... args) {
+        static_assert(sizeof...(AddArgs) == sizeof...(Args), "Wrong number of arguments for add()");
+        bool added = false, post_flush;
+        {
+            CriticalSectionLock lock;
+            buffer& b = _buffers[atomic_load(&_active, atomic_relaxed)];
+            size_t count = atomic_load(&b.count, atomic_relaxed);
+            if (count < _capacity) {
+                new(&b.args[count]) ArgStruct(std::forward<AddArgs>(args)...);
+                atomic_store(&b.count, count + 1, atomic_release);
+                added = true;
+            }
+            post_flush = (_queue != NULL) && !atomic_load(&_posted, atomic_relaxed);
+            atomic_store(&_posted, true, atomic_relaxed);
+        }
+        if (post_flush) {
+            // Count the Event before posting it, since it can be dispatched right away
+            atomic_fetch_add(&_queued_events, 1u);
+            if (!_queue->post(FunctionPointer0<void>(this, &EventBatch::_flush_event).bind())) {
+                atomic_fetch_sub(&_queued_events, 1u);
+                CriticalSectionLock lock;
+                atomic_store(&_posted, false, atomic_relaxed);
+            }
+        }
+        return added;
+    }
+
+    /** Call the batch handler with the arguments collected so far. Nothing is called if the
+      * batch is empty.
+      * @returns the number of calls passed to the handler
+      */
+    size_t flush() {
+        buffer *b;
+        {
+            CriticalSectionLock lock;
+            unsigned active = atomic_load(&_active, atomic_relaxed);
+            b = &_buffers[active];
+            atomic_store(&_active, 1 - active, atomic_relaxed);
+            atomic_store(&_posted, false, atomic_relaxed);
+        }
+        size_t count = atomic_load(&b->count, atomic_acquire);
+        if (count > 0) {
+            _handler.call(b->args, count);
+            _clear(*b);
+        }
+        return count;
+    }
+
+    /** Returns the number of calls collected since the last flush
+      * @returns number of pending calls
+      */
+    size_t get_num_pending() const {
+        return atomic_load(&_buffers[atomic_load(&_active, atomic_relaxed)].count, atomic_relaxed);
+    }
+
+    /** Returns the capacity of the batch
+      * @returns maximum number of calls collected between two flushes
+      */
+    size_t get_capacity() const {
+        return _capacity;
+    }
+
+private:
+    struct buffer {
+        ArgStruct *args;
+        // written in a CriticalSectionLock, read without it by get_num_pending()
+        size_t count;
+    };
+
+    void _flush_event() {
+        flush();
+        atomic_fetch_sub(&_queued_events, 1u);
+    }
+
+    static void _clear(buffer& b) {
+        size_t count = atomic_load(&b.count, atomic_relaxed);
+        for (size_t i = 0; i < count; i ++) {
+            b.args[i].~ArgStruct();
+        }
+        atomic_store(&b.count, (size_t)0, atomic_relaxed);
+    }
+
+    BatchHandler _handler;
+    EventQueue *_queue;
+    size_t _capacity;
+    buffer _buffers[2];
+    unsigned _active;
+    bool _posted;
+    // Number of flush Events in the queue, checked by the destructor
+    unsigned _queued_events;
+};
+
+} // namespace util
+} // namespace mbed
+
+#endif // #ifndef __MBED_UTIL_EVENT_BATCH_H__
@@ -0,0 +1,128 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MBED_UTIL_EVENT_QUEUE_H__
+#define __MBED_UTIL_EVENT_QUEUE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core-util/Event.h"
+#include "core-util/PoolAllocator.h"
+
+namespace mbed {
+namespace util {
+
+/** A queue of Events with any number of producers and a single consumer.
+  *
+  * post() copies or moves the Event into a node allocated from a PoolAllocator and pushes
+  * the node on an intrusive list with atomic_cas, without any lock, so it can be called
+  * from interrupt handlers and from any number of threads at the same time. The consumer
+  * calls dispatch(), which takes the whole list in one operation, restores the posting order
+  * and then calls the events in a batch, returning their nodes to the pool.
+  *
+  * Only one thread (or the main loop) can call dispatch() and the destructor. Events posted
+  * while dispatch() runs (including the ones posted by the dispatched events themselves) are
+  * called by the next dispatch().
+  *
+  * Usage:
+  * @code
+  * const size_t max_events = 16;
+  * EventQueue *queue;
+  *
+  * void irq_handler() {
+  *     queue->post(FunctionPointer0<void>(handle_irq).bind());
+  * }
+  *
+  * int main() {
+  *     UAllocTraits_t traits = {0};
+  *     size_t node_size = EventQueue::get_node_size();
+  *     void *memory = mbed_ualloc(PoolAllocator::get_pool_size(max_events, node_size), traits);
+  *     PoolAllocator pool(memory, max_events, node_size);
+  *     queue = new EventQueue(pool);
+  *     while (true) {
+  *         queue->dispatch();
+  *     }
+  * }
+  * @endcode
+  */
+class EventQueue {
+public:
+    /** Create a new event queue
+      * @param allocator pool for the queue nodes, with elements of at least get_node_size()
+      *        bytes. The queue holds at most as many events as the pool has elements.
+      */
+    EventQueue(PoolAllocator& allocator);
+
+    /* Forbid copy and assignment */
+    EventQueue(const EventQueue&) = delete;
+    EventQueue(EventQueue&&) = delete;
+    EventQueue& operator =(const EventQueue&) = delete;
+    EventQueue& operator =(EventQueue&&) = delete;
+
+    /** Destructor. The events that were not dispatched are destroyed without being called
+      */
+    ~EventQueue();
+
+    /** Add a copy of an event to the queue
+      * @param e the event
+      * @returns true for success, false if the pool is exhausted or 'e' is empty
+      */
+    bool post(const Event& e);
+
+    /** Move an event into the queue. 'e' is left empty if the event was posted
+      * @param e the event
+      * @returns true for success, false if the pool is exhausted or 'e' is empty
+      */
+    bool post(Event&& e);
+
+    /** Call the events that were posted before this call, in the order they were posted
+      * @param max_events maximum number of events to call. The events that are left are
+      *        called by the next dispatch().
+      * @returns the number of events called
+      */
+    size_t dispatch(size_t max_events = SIZE_MAX);
+
+    /** Checks if the queue is empty
+      * Must be called by the consumer. The result is only a snapshot if events are posted
+      * at the same time.
+      * @returns true if there are no events to dispatch, false otherwise
+      */
+    bool is_empty() const;
+
+    /** Returns the element size needed in the pool given to the constructor
+      * @returns size of a queue node in bytes
+      */
+    static size_t get_node_size();
+
+private:
+    struct node;
+
+    bool _post(node *n);
+    void _take_posted();
+    void _free(node *n);
+
+    PoolAllocator& _allocator;
+    // Nodes pushed by post(), newest first
+    node *_posted;
+    // Nodes taken by the consumer, oldest first
+    node *_head, *_tail;
+};
+
+} // namespace util
+} // namespace mbed
+
+#endif // #ifndef __MBED_UTIL_EVENT_QUEUE_H__
@@ -21,546 +21,271 @@
 #include <stddef.h>
 #include <stdarg.h>
 #include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include "core-util/FunctionPointerBase.h"
 #include "core-util/FunctionPointerBind.h"
 
 namespace mbed {
 namespace util {
 
-/** A class for storing and calling a pointer to a static or member void function without arguments
- */
-template <typename R>
-class FunctionPointer0 : public FunctionPointerBase<R>{
-public:
-    typedef R(*static_fp)(void);
-    typedef struct arg_struct{
-    } ArgStruct;
-    /** Create a FunctionPointer, attaching a static function
-     *
-     *  @param function The void static function to attach (default is none)
-     */
-    FunctionPointer0(static_fp function = 0):
-        FunctionPointerBase<R>()
-    {
-        attach(function);
-    }
-
-    /** Create a FunctionPointer, attaching a member function
-     *
-     *  @param object The object pointer to invoke the member function on (i.e. the this pointer)
-     *  @param function The address of the void member function to attach
-     */
-    template<typename T>
-    FunctionPointer0(T *object, R (T::*member)(void)):
-        FunctionPointerBase<R>()
-    {
-        attach(object, member);
-    }
-
-    /** Attach a static function
-     *
-     *  @param function The void static function to attach (default is none)
-     */
-    void attach(static_fp function) {
-        FunctionPointerBase<R>::_object = reinterpret_cast<void*>(function);
-        FunctionPointerBase<R>::_membercaller = &FunctionPointer0::staticcaller;
-    }
-
-    /** Attach a member function
-     *
-     *  @param object The object pointer to invoke the member function on (i.e. the this pointer)
-     *  @param function The address of the void member function to attach
-     */
-    template<typename T>
-    void attach(T *object, R (T::*member)(void)) {
-        FunctionPointerBase<R>::_object = static_cast<void*>(object);
-        *reinterpret_cast<R (T::**)(void)>(FunctionPointerBase<R>::_member) = member;
-        FunctionPointerBase<R>::_membercaller = &FunctionPointer0::membercaller<T>;
-    }
+template <size_t... I>
+struct FunctionPointerIndices {
+};
 
-    /** Call the attached static or member function
-     */
-    R call(){
-        return FunctionPointerBase<R>::call(NULL);
-    }
-    R operator ()(void) {
-        return FunctionPointerBase<R>::call(NULL);
-    }
+template <size_t N, size_t... I>
+struct MakeFunctionPointerIndices : MakeFunctionPointerIndices<N - 1, N - 1, I...> {
+};
 
-    FunctionPointerBind<R> bind() {
-        FunctionPointerBind<R> fp(*this);
-        void * storage = this->pre_bind(fp, (ArgStruct *)NULL, &FunctionPointerBase<R>::_nullops);
-        new(storage) ArgStruct();
-        return fp;
-    }
+template <size_t... I>
+struct MakeFunctionPointerIndices<0, I...> {
+    typedef FunctionPointerIndices<I...> type;
+};
 
-    static_fp get_function()const {
-        return reinterpret_cast<static_fp>(FunctionPointerBase<R>::_object);
+/** Passes a bound argument, stored in a FunctionPointerBind, to the attached function.
+ *  Arguments taken by value are passed as lvalues, so that the parameter is copied once
+ *  from the storage and the FunctionPointerBind can be called again. Reference arguments
+ *  (and arguments that can't be copied, which can't be bound anyway) are forwarded.
+ */
+template <typename A, bool Copy = !std::is_reference<A>::value && std::is_copy_constructible<A>::value>
+struct FunctionPointerBoundArg {
+    static A&& get(typename std::remove_reference<A>::type *arg) {
+        return std::forward<A>(*arg);
     }
+};
 
-
-private:
-    template<typename T>
-    static R membercaller(void *object, char *member, void *arg) {
-        (void) arg;
-        T* o = static_cast<T*>(object);
-        R (T::**m)(void) = reinterpret_cast<R (T::**)(void)>(member);
-        return (o->**m)();
-    }
-    static R staticcaller(void *object, char *member, void *arg) {
-        (void) arg;
-        (void) member;
-        static_fp f = reinterpret_cast<static_fp>(object);
-        return f();
+template <typename A>
+struct FunctionPointerBoundArg<A, true> {
+    static A& get(A *arg) {
+        return *arg;
     }
 };
 
+template <typename Signature>
+class VariadicFunctionPointer;
 
-/* If we had variaditic templates, this wouldn't be a problem, but until C++11 is enabled, we are stuck with multiple classes... */
-
-/** A class for storing and calling a pointer to a static or member void function with one argument
+/** A class for storing and calling a pointer to a static or member function with any number
+ *  of arguments, for example VariadicFunctionPointer<int(const char*, int)>.
+ *
+ *  The arguments of call() are forwarded to the attached function without being copied
+ *  into an argument structure. bind() copies the arguments into a FunctionPointerBind,
+ *  which can be called later without arguments.
+ *
+ *  FunctionPointer0 to FunctionPointer4 are aliases of this class.
  */
-template <typename R, typename A1>
-class FunctionPointer1 : public FunctionPointerBase<R> {
+template <typename R, typename... Args>
+class VariadicFunctionPointer<R(Args...)> : public FunctionPointerBase<R> {
 public:
-    typedef struct arg_struct{
-        A1 a1;
-        arg_struct(const A1 &b1) : a1(b1){}
-    } ArgStruct;
-    typedef R(*static_fp)(A1);
+    // Bound arguments, stored in FunctionPointerBind
+    typedef std::tuple<Args...> ArgStruct;
+    typedef R(*static_fp)(Args...);
+
     /** Create a FunctionPointer, attaching a static function
      *
-     *  @param function The void static function to attach (default is none)
+     *  @param function The static function to attach (default is none)
      */
-    FunctionPointer1(static_fp function = 0) {
+    VariadicFunctionPointer(static_fp function = 0):
+        FunctionPointerBase<R>()
+    {
         attach(function);
     }
 
     /** Create a FunctionPointer, attaching a member function
      *
      *  @param object The object pointer to invoke the member function on (i.e. the this pointer)
-     *  @param function The address of the void member function to attach
+     *  @param function The address of the member function to attach
      */
     template<typename T>
-    FunctionPointer1(T *object, R (T::*member)(A1)) {
+    VariadicFunctionPointer(T *object, R (T::*member)(Args...)):
+        FunctionPointerBase<R>()
+    {
         attach(object, member);
     }
 
     /** Attach a static function
      *
-     *  @param function The void static function to attach (default is none)
+     *  @param function The static function to attach (default is none)
      */
     void attach(static_fp function) {
         FunctionPointerBase<R>::_object = reinterpret_cast<void*>(function);
-        FunctionPointerBase<R>::_membercaller = &FunctionPointer1::staticcaller;
+        FunctionPointerBase<R>::_membercaller = &VariadicFunctionPointer::staticcaller;
     }
 
     /** Attach a member function
      *
      *  @param object The object pointer to invoke the member function on (i.e. the this pointer)
-     *  @param function The address of the void member function to attach
+     *  @param function The address of the member function to attach
      */
     template<typename T>
-    void attach(T *object, R (T::*member)(A1))
-    {
+    void attach(T *object, R (T::*member)(Args...)) {
         FunctionPointerBase<R>::_object = static_cast<void*>(object);
-        *reinterpret_cast<R (T::**)(A1)>(FunctionPointerBase<R>::_member) = member;
-        FunctionPointerBase<R>::_membercaller = &FunctionPointer1::membercaller<T>;
+        *reinterpret_cast<R (T::**)(Args...)>(FunctionPointerBase<R>::_member) = member;
+        FunctionPointerBase<R>::_membercaller = &VariadicFunctionPointer::template membercaller<T>;
     }
 
-    FunctionPointerBind<R> bind(const A1 &a1) {
-        FunctionPointerBind<R> fp(*this);
-        void * storage = this->pre_bind(fp, (ArgStruct *)NULL, &_fp1_ops);
-        new(storage) ArgStruct(a1);
-        return fp;
-    }
-
-
-    /** Call the attached static or member function
-     */
-    R call(A1 a1)
-    {
-        ArgStruct Args(a1);
-        return FunctionPointerBase<R>::call(&Args);
-    }
-    R operator ()(A1 a1) {
-        ArgStruct Args(a1);
-        return FunctionPointerBase<R>::call(&Args);
-    }
-
-    static_fp get_function()const
-    {
-        return reinterpret_cast<static_fp>(FunctionPointerBase<R>::_object);
-    }
-
-
-private:
-    template<typename T>
-    static R membercaller(void *object, char *member, void *arg) {
-        ArgStruct *Args = static_cast<ArgStruct *>(arg);
-        T* o = static_cast<T*>(object);
-        R (T::**m)(A1) = reinterpret_cast<R (T::**)(A1)>(member);
-        return (o->**m)(Args->a1);
-    }
-    static R staticcaller(void *object, char *member, void *arg) {
-        ArgStruct *Args = static_cast<ArgStruct *>(arg);
-        (void) member;
-        static_fp f = reinterpret_cast<static_fp>(object);
-        return f(Args->a1);
-    }
-    static void copy_constructor(void *dest , void* src) {
-        ArgStruct *src_args = static_cast<ArgStruct *>(src);
-        new(dest) ArgStruct(src_args->a1);
-    }
-    static void destructor(void *args) {
-        ArgStruct *argstruct = static_cast<ArgStruct *>(args);
-        argstruct->~arg_struct();
-    }
-
-protected:
-    static const struct FunctionPointerBase<R>::ArgOps _fp1_ops;
-};
-
-template <typename R, typename A1>
-const struct FunctionPointerBase<R>::ArgOps FunctionPointer1<R,A1>::_fp1_ops = {
-    FunctionPointer1<R,A1>::copy_constructor,
-    FunctionPointer1<R,A1>::destructor
-};
-
-
-/** A class for storing and calling a pointer to a static or member void function with two arguments
- */
-template <typename R, typename A1, typename A2>
-class FunctionPointer2 : public FunctionPointerBase<R> {
-public:
-    typedef struct arg_struct{
-        A1 a1;
-        A2 a2;
-        arg_struct(const A1 &b1, const A2 &b2) : a1(b1), a2(b2) {}
-    } ArgStruct;
-    typedef R(*static_fp)(A1, A2);
-    /** Create a FunctionPointer, attaching a static function
-     *
-     *  @param function The void static function to attach (default is none)
-     */
-    FunctionPointer2(static_fp function = 0) {
-        attach(function);
-    }
-
-    /** Create a FunctionPointer, attaching a member function
-     *
-     *  @param object The object pointer to invoke the member function on (i.e. the this pointer)
-     *  @param function The address of the void member function to attach
-     */
-    template<typename T>
-    FunctionPointer2(T *object, R (T::*member)(A1, A2)) {
-        attach(object, member);
-    }
-
-    /** Attach a static function
+    /** Attach a static function known at compile time. The function is called directly by
+     *  a caller generated for it, instead of through the stored function pointer.
      *
-     *  @param function The void static function to attach (default is none)
+     *  Usage: fp.attach<&function>();
      */
-    void attach(static_fp function) {
+    template<R (*function)(Args...)>
+    void attach() {
         FunctionPointerBase<R>::_object = reinterpret_cast<void*>(function);
-        FunctionPointerBase<R>::_membercaller = &FunctionPointer2::staticcaller;
+        memset(FunctionPointerBase<R>::_member, 0, sizeof(FunctionPointerBase<R>::_member));
+        FunctionPointerBase<R>::_membercaller = &VariadicFunctionPointer::template fixedstaticcaller<function>;
     }
 
-    /** Attach a member function
+    /** Attach a member function known at compile time. The member function is called
+     *  directly by a caller generated for it, without loading the stored member pointer.
+     *
+     *  Usage: fp.attach<MyClass, &MyClass::method>(&object);
      *
      *  @param object The object pointer to invoke the member function on (i.e. the this pointer)
-     *  @param function The address of the void member function to attach
      */
-    template<typename T>
-    void attach(T *object, R (T::*member)(A1, A2))
-    {
+    template<typename T, R (T::*member)(Args...)>
+    void attach(T *object) {
         FunctionPointerBase<R>::_object = static_cast<void*>(object);
-        *reinterpret_cast<R (T::**)(A1, A2)>(FunctionPointerBase<R>::_member) = member;
-        FunctionPointerBase<R>::_membercaller = &FunctionPointer2::membercaller<T>;
+        // Stored only so that operator== works like for the other attach()
+        *reinterpret_cast<R (T::**)(Args...)>(FunctionPointerBase<R>::_member) = member;
+        FunctionPointerBase<R>::_membercaller = &VariadicFunctionPointer::template fixedmembercaller<T, member>;
     }
 
-    FunctionPointerBind<R> bind(const A1 &a1, const A2 &a2) {
+    /** Bind the arguments to a FunctionPointerBind, which calls the attached function with
+     *  them. The arguments are forwarded to the bound storage: rvalues are moved there,
+     *  lvalues are copied.
+     */
+    template <typename... BindArgs>
+    FunctionPointerBind<R> bind(BindArgs&&... args) {
+        static_assert(sizeof...(BindArgs) == sizeof...(Args), "Wrong number of arguments for bind()");
         FunctionPointerBind<R> fp(*this);
-        void * storage = this->pre_bind(fp, (ArgStruct *)NULL, &_fp2_ops);
-        new(storage) ArgStruct(a1,a2);
+        void * storage = this->pre_bind(fp, (ArgStruct *)NULL, &_fp_ops);
+        new(storage) ArgStruct(std::forward<BindArgs>(args)...);
         return fp;
     }
 
-
     /** Call the attached static or member function
      */
-    R call(A1 a1, A2 a2)
-    {
-        ArgStruct Args(a1, a2);
-        return FunctionPointerBase<R>::call(&Args);
+    R call(Args... args) {
+        return call_with_args(this, std::forward<Args>(args)...);
     }
-    R operator ()(A1 a1, A2 a2) {
-        ArgStruct Args(a1, a2);
-        return FunctionPointerBase<R>::call(&Args);
+
+    R operator ()(Args... args) {
+        return call_with_args(this, std::forward<Args>(args)...);
     }
 
-    static_fp get_function()const
-    {
+    static_fp get_function()const {
         return reinterpret_cast<static_fp>(FunctionPointerBase<R>::_object);
     }
 
-
 private:
-    template<typename T>
-    static R membercaller(void *object, char *member, void *arg) {
-        ArgStruct *Args = static_cast<ArgStruct *>(arg);
-        T* o = static_cast<T*>(object);
-        R (T::**m)(A1, A2) = reinterpret_cast<R (T::**)(A1, A2)>(member);
-        return (o->**m)(Args->a1, Args->a2);
-    }
-    static R staticcaller(void *object, char *member, void *arg) {
-        ArgStruct *Args = static_cast<ArgStruct *>(arg);
-        (void) member;
-        static_fp f = reinterpret_cast<static_fp>(object);
-        return f(Args->a1, Args->a2);
-    }
-    static void copy_constructor(void *dest , void* src) {
-        ArgStruct *src_args = static_cast<ArgStruct *>(src);
-        new(dest) ArgStruct(src_args->a1, src_args->a2);
-    }
-    static void destructor(void *args) {
-        ArgStruct *argstruct = static_cast<ArgStruct *>(args);
-        argstruct->~arg_struct();
-    }
-
-protected:
-    static const struct FunctionPointerBase<R>::ArgOps _fp2_ops;
-};
-
-template <typename R, typename A1, typename A2>
-const struct FunctionPointerBase<R>::ArgOps FunctionPointer2<R,A1,A2>::_fp2_ops = {
-    FunctionPointer2<R,A1,A2>::copy_constructor,
-    FunctionPointer2<R,A1,A2>::destructor
-};
+    // Pointers to the arguments of a call, passed to the caller functions. The arguments of
+    // call() are forwarded to the attached function; the bound arguments of a
+    // FunctionPointerBind are passed with FunctionPointerBoundArg, so that they stay in the
+    // storage for the next call
+    struct ArgRefs {
+        std::tuple<typename std::remove_reference<Args>::type *...> args;
+        bool bound;
+    };
+    typedef typename MakeFunctionPointerIndices<sizeof...(Args)>::type Indices;
 
-/** A class for storing and calling a pointer to a static or member void function with three arguments
- */
-template <typename R, typename A1, typename A2, typename A3>
-class FunctionPointer3 : public FunctionPointerBase<R> {
-public:
-    typedef struct arg_struct{
-        A1 a1;
-        A2 a2;
-        A3 a3;
-        arg_struct(const A1 &b1, const A2 &b2, const A3 &b3) : a1(b1), a2(b2), a3(b3) {}
-    } ArgStruct;
-    typedef R(*static_fp)(A1, A2, A3);
-    /** Create a FunctionPointer, attaching a static function
-     *
-     *  @param function The void static function to attach (default is none)
-     */
-    FunctionPointer3(static_fp function = 0) {
-        attach(function);
+    static R call_with_args(FunctionPointerBase<R> *fp, Args&&... args) {
+        ArgRefs refs = {std::make_tuple(&args...), false};
+        return fp->call(&refs);
     }
 
-    /** Create a FunctionPointer, attaching a member function
-     *
-     *  @param object The object pointer to invoke the member function on (i.e. the this pointer)
-     *  @param function The address of the void member function to attach
-     */
-    template<typename T>
-    FunctionPointer3(T *object, R (T::*member)(A1, A2, A3)) {
-        attach(object, member);
+    template<typename T, size_t... I>
+    static R membercall(T *o, R (T::*m)(Args...), ArgRefs *refs, FunctionPointerIndices<I...>) {
+        if (refs->bound)
+            return (o->*m)(FunctionPointerBoundArg<Args>::get(std::get<I>(refs->args))...);
+        return (o->*m)(std::forward<Args>(*std::get<I>(refs->args))...);
     }
 
-    /** Attach a static function
-     *
-     *  @param function The void static function to attach (default is none)
-     */
-    void attach(static_fp function) {
-        FunctionPointerBase<R>::_object = reinterpret_cast<void*>(function);
-        FunctionPointerBase<R>::_membercaller = &FunctionPointer3::staticcaller;
-    }
-
-    /** Attach a member function
-     *
-     *  @param object The object pointer to invoke the member function on (i.e. the this pointer)
-     *  @param function The address of the void member function to attach
-     */
-    template<typename T>
-    void attach(T *object, R (T::*member)(A1, A2, A3))
-    {
-        FunctionPointerBase<R>::_object = static_cast<void*>(object);
-        *reinterpret_cast<R (T::**)(A1, A2, A3)>(FunctionPointerBase<R>::_member) = member;
-        FunctionPointerBase<R>::_membercaller = &FunctionPointer3::membercaller<T>;
-    }
-
-    FunctionPointerBind<R> bind(const A1 &a1, const A2 &a2, const A3 &a3) {
-        FunctionPointerBind<R> fp(*this);
-        void * storage = this->pre_bind(fp, (ArgStruct *)NULL, &_fp3_ops);
-        new(storage) ArgStruct(a1,a2,a3);
-        return fp;
-    }
-
-
-    /** Call the attached static or member function
-     */
-    R call(A1 a1, A2 a2, A3 a3)
-    {
-        ArgStruct Args(a1, a2, a3);
-        return FunctionPointerBase<R>::call(&Args);
-    }
-    R operator ()(A1 a1, A2 a2, A3 a3) {
-        ArgStruct Args(a1, a2, a3);
-        return FunctionPointerBase<R>::call(&Args);
+    template<size_t... I>
+    static R staticcall(static_fp f, ArgRefs *refs, FunctionPointerIndices<I...>) {
+        if (refs->bound)
+            return f(FunctionPointerBoundArg<Args>::get(std::get<I>(refs->args))...);
+        return f(std::forward<Args>(*std::get<I>(refs->args))...);
     }
 
-    static_fp get_function()const
-    {
-        return reinterpret_cast<static_fp>(FunctionPointerBase<R>::_object);
+    template<size_t... I>
+    static R boundcall(FunctionPointerBase<R> *fp, ArgStruct *args, FunctionPointerIndices<I...>) {
+        (void) args;
+        ArgRefs refs = {std::make_tuple(&std::get<I>(*args)...), true};
+        return fp->call(&refs);
     }
 
-
-private:
     template<typename T>
     static R membercaller(void *object, char *member, void *arg) {
-        ArgStruct *Args = static_cast<ArgStruct *>(arg);
         T* o = static_cast<T*>(object);
-        R (T::**m)(A1, A2, A3) = reinterpret_cast<R (T::**)(A1, A2, A3)>(member);
-        return (o->**m)(Args->a1, Args->a2, Args->a3);
+        R (T::**m)(Args...) = reinterpret_cast<R (T::**)(Args...)>(member);
+        return membercall(o, *m, static_cast<ArgRefs *>(arg), Indices());
+    }
+    template<typename T, R (T::*member)(Args...)>
+    static R fixedmembercaller(void *object, char *, void *arg) {
+        return membercall(static_cast<T*>(object), member, static_cast<ArgRefs *>(arg), Indices());
+    }
+    template<R (*function)(Args...)>
+    static R fixedstaticcaller(void *, char *, void *arg) {
+        return staticcall(function, static_cast<ArgRefs *>(arg), Indices());
     }
     static R staticcaller(void *object, char *member, void *arg) {
-        ArgStruct *Args = static_cast<ArgStruct *>(arg);
         (void) member;
         static_fp f = reinterpret_cast<static_fp>(object);
-        return f(Args->a1, Args->a2, Args->a3);
+        return staticcall(f, static_cast<ArgRefs *>(arg), Indices());
+    }
+    static R call_args(FunctionPointerBase<R> *fp, void *args) {
+        return boundcall(fp, static_cast<ArgStruct *>(args), Indices());
     }
     static void copy_constructor(void *dest , void* src) {
         ArgStruct *src_args = static_cast<ArgStruct *>(src);
-        new(dest) ArgStruct(src_args->a1, src_args->a2, src_args->a3);
+        new(dest) ArgStruct(*src_args);
+    }
+    static void move_constructor(void *dest , void* src) {
+        ArgStruct *src_args = static_cast<ArgStruct *>(src);
+        new(dest) ArgStruct(std::move(*src_args));
     }
     static void destructor(void *args) {
         ArgStruct *argstruct = static_cast<ArgStruct *>(args);
-        argstruct->~arg_struct();
+        argstruct->~ArgStruct();
     }
 
 protected:
-    static const struct FunctionPointerBase<R>::ArgOps _fp3_ops;
+    static const struct FunctionPointerBase<R>::ArgOps _fp_ops;
 };
 
-template <typename R, typename A1, typename A2, typename A3>
-const struct FunctionPointerBase<R>::ArgOps FunctionPointer3<R,A1,A2,A3>::_fp3_ops = {
-    FunctionPointer3<R,A1,A2,A3>::copy_constructor,
-    FunctionPointer3<R,A1,A2,A3>::destructor
+template <typename R, typename... Args>
+const struct FunctionPointerBase<R>::ArgOps VariadicFunctionPointer<R(Args...)>::_fp_ops = {
+    VariadicFunctionPointer<R(Args...)>::copy_constructor,
+    VariadicFunctionPointer<R(Args...)>::destructor,
+    VariadicFunctionPointer<R(Args...)>::move_constructor,
+    VariadicFunctionPointer<R(Args...)>::call_args
 };
 
-/** A class for storing and calling a pointer to a static or member void function with four arguments
+/** A class for storing and calling a pointer to a static or member function without arguments
  */
-template <typename R, typename A1, typename A2, typename A3, typename A4>
-class FunctionPointer4 : public FunctionPointerBase<R> {
-public:
-    typedef struct arg_struct{
-        A1 a1;
-        A2 a2;
-        A3 a3;
-        A4 a4;
-        arg_struct(const A1 &b1, const A2 &b2, const A3 &b3, const A4 &b4) :
-            a1(b1), a2(b2), a3(b3), a4(b4) {}
-    } ArgStruct;
-    typedef R(*static_fp)(A1, A2, A3, A4);
-    /** Create a FunctionPointer, attaching a static function
-     *
-     *  @param function The void static function to attach (default is none)
-     */
-    FunctionPointer4(static_fp function = 0) {
-        attach(function);
-    }
-
-    /** Create a FunctionPointer, attaching a member function
-     *
-     *  @param object The object pointer to invoke the member function on (i.e. the this pointer)
-     *  @param function The address of the void member function to attach
-     */
-    template<typename T>
-    FunctionPointer4(T *object, R (T::*member)(A1, A2, A3, A4)) {
-        attach(object, member);
-    }
-
-    /** Attach a static function
-     *
-     *  @param function The void static function to attach (default is none)
-     */
-    void attach(static_fp function) {
-        FunctionPointerBase<R>::_object = reinterpret_cast<void*>(function);
-        FunctionPointerBase<R>::_membercaller = &FunctionPointer4::staticcaller;
-    }
-
-    /** Attach a member function
-     *
-     *  @param object The object pointer to invoke the member function on (i.e. the this pointer)
-     *  @param function The address of the void member function to attach
-     */
-    template<typename T>
-    void attach(T *object, R (T::*member)(A1, A2, A3, A4))
-    {
-        FunctionPointerBase<R>::_object = static_cast<void*>(object);
-        *reinterpret_cast<R (T::**)(A1, A2, A3, A4)>(FunctionPointerBase<R>::_member) = member;
-        FunctionPointerBase<R>::_membercaller = &FunctionPointer4::membercaller<T>;
-    }
-
-    FunctionPointerBind<R> bind(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4) {
-        FunctionPointerBind<R> fp(*this);
-        void * storage = this->pre_bind(&fp, (ArgStruct *)NULL, &_fp4_ops);
-        new(storage) ArgStruct(a1,a2,a3,a4);
-        return fp;
-    }
-
-
-    /** Call the attached static or member function
-     */
-    R call(A1 a1, A2 a2, A3 a3, A4 a4)
-    {
-        ArgStruct Args(a1, a2, a3, a4);
-        return FunctionPointerBase<R>::call(&Args);
-    }
-    R operator ()(A1 a1, A2 a2, A3 a3, A4 a4) {
-        ArgStruct Args(a1, a2, a3, a4);
-        return FunctionPointerBase<R>::call(&Args);
-    }
-
-    static_fp get_function()const
-    {
-        return reinterpret_cast<static_fp>(FunctionPointerBase<R>::_object);
-    }
+template <typename R>
+using FunctionPointer0 = VariadicFunctionPointer<R()>;
 
+/** A class for storing and calling a pointer to a static or member function with one argument
+ */
+template <typename R, typename A1>
+using FunctionPointer1 = VariadicFunctionPointer<R(A1)>;
 
-private:
-    template<typename T>
-    static R membercaller(void *object, char *member, void *arg) {
-        ArgStruct *Args = static_cast<ArgStruct *>(arg);
-        T* o = static_cast<T*>(object);
-        R (T::**m)(A1, A2, A3, A4) = reinterpret_cast<R (T::**)(A1, A2, A3, A4)>(member);
-        return (o->**m)(Args->a1, Args->a2, Args->a3, Args->a4);
-    }
-    static R staticcaller(void *object, char *member, void *arg) {
-        ArgStruct *Args = static_cast<ArgStruct *>(arg);
-        (void) member;
-        static_fp f = reinterpret_cast<static_fp>(object);
-        return f(Args->a1, Args->a2, Args->a3, Args->a4);
-    }
-    static void copy_constructor(void *dest , void* src) {
-        ArgStruct *src_args = static_cast<ArgStruct *>(src);
-        new(dest) ArgStruct(src_args->a1, src_args->a2, src_args->a3, src_args->a4);
-    }
-    static void destructor(void *args) {
-        ArgStruct *argstruct = static_cast<ArgStruct *>(args);
-        argstruct->~arg_struct();
-    }
+/** A class for storing and calling a pointer to a static or member function with two arguments
+ */
+template <typename R, typename A1, typename A2>
+using FunctionPointer2 = VariadicFunctionPointer<R(A1, A2)>;
 
-protected:
-    static const struct FunctionPointerBase<R>::ArgOps _fp4_ops;
-};
+/** A class for storing and calling a pointer to a static or member function with three arguments
+ */
+template <typename R, typename A1, typename A2, typename A3>
+using FunctionPointer3 = VariadicFunctionPointer<R(A1, A2, A3)>;
 
+/** A class for storing and calling a pointer to a static or member function with four arguments
+ */
 template <typename R, typename A1, typename A2, typename A3, typename A4>
-const struct FunctionPointerBase<R>::ArgOps FunctionPointer4<R,A1,A2,A3,A4>::_fp4_ops = {
-    FunctionPointer4<R,A1,A2,A3,A4>::copy_constructor,
-    FunctionPointer4<R,A1,A2,A3,A4>::destructor
-};
+using FunctionPointer4 = VariadicFunctionPointer<R(A1, A2, A3, A4)>;
 
 typedef FunctionPointer0<void> FunctionPointer;
 
@@ -51,8 +51,10 @@ public:
     /**
      * Clears the current function pointer assignment
      * After clear(), this instance will point to nothing (NULL)
+     * clear() is not virtual: calling it through a FunctionPointerBase reference to a
+     * FunctionPointerBind doesn't destroy the bound arguments. Call FunctionPointerBind::clear().
      */
-    virtual void clear() {
+    void clear() {
         _membercaller = NULL;
         _object = NULL;
         memset(_member, 0, sizeof(_member));
@@ -76,13 +78,25 @@ public:
     FunctionPointerBase(const FunctionPointerBase<R> & fp) {
         copy(&fp);
     }
-    virtual ~FunctionPointerBase() {
+    /* The destructor is not virtual on purpose: FunctionPointerBase and its subclasses have
+     * no virtual functions, so they don't need a vtable pointer. Never delete a
+     * FunctionPointerBind through a pointer to FunctionPointerBase.
+     */
+    ~FunctionPointerBase() {
 
     }
 protected:
+    /* The entries after 'destructor' were added later. Tables that only initialize the first
+     * two entries still work: FunctionPointerBind copies instead of moving if 'move_args' is
+     * NULL, and calls through _membercaller with the argument storage if 'call_args' is NULL.
+     */
     struct ArgOps {
         void (*copy_args)(void *, void *);
         void (*destructor)(void *);
+        // Move constructs the arguments in the first storage from the ones in the second storage
+        void (*move_args)(void *, void *);
+        // Calls the function pointer with the arguments stored in FunctionPointerBind
+        R (*call_args)(FunctionPointerBase<R> *, void *);
     };
 
     // Forward declaration of an unknown class 
@@ -123,12 +137,15 @@ protected:
 private:
     static void _null_copy_args(void *dest , void* src) {(void) dest; (void) src;}
     static void _null_destructor(void *args) {(void) args;}
+    static R _null_call_args(FunctionPointerBase<R> *fp, void *args) {(void) args; return fp->call(NULL);}
 
 };
 template<typename R>
 const struct FunctionPointerBase<R>::ArgOps FunctionPointerBase<R>::_nullops = {
     FunctionPointerBase<R>::_null_copy_args,
-    FunctionPointerBase<R>::_null_destructor
+    FunctionPointerBase<R>::_null_destructor,
+    FunctionPointerBase<R>::_null_copy_args,
+    FunctionPointerBase<R>::_null_call_args
 };
 
 } /* namespace util */
@@ -21,6 +21,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <assert.h>
+#include <utility>
 #include "core-util/FunctionPointerBase.h"
 
 
@@ -41,13 +42,24 @@ namespace util {
 template <typename R>
 class FunctionPointerBase;
 
+/** A function pointer together with a copy of the arguments it is called with (an Event).
+ *
+ * FunctionPointerBind has no virtual functions: the ArgOps table set by bind() knows how to
+ * copy, destroy and call the bound arguments. If the bound arguments are trivially copyable,
+ * a FunctionPointerBind can be relocated with memcpy (for example into a ring buffer of raw
+ * memory) without calling its copy constructor and destructor.
+ */
 template<typename R>
 class FunctionPointerBind : public FunctionPointerBase<R> {
 friend FunctionPointerBase<R>;
 public:
     // Call the Event
     inline R call() {
-        return FunctionPointerBase<R>::call(static_cast<void *>(_storage));
+        if (_ops->call_args == NULL) {
+            // ArgOps table without a 'call_args' entry, the caller unpacks the arguments itself
+            return FunctionPointerBase<R>::call(static_cast<void *>(_storage));
+        }
+        return _ops->call_args(this, static_cast<void *>(_storage));
     }
     FunctionPointerBind():
         FunctionPointerBase<R>(),
@@ -55,7 +67,8 @@ public:
     {}
 
     FunctionPointerBind(const FunctionPointerBase<R> & fp) :
-        FunctionPointerBase<R>(fp)
+        FunctionPointerBase<R>(fp),
+        _ops(&FunctionPointerBase<R>::_nullops)
     {}
 
     FunctionPointerBind(const FunctionPointerBind<R> & fp):
@@ -64,11 +77,22 @@ public:
         *this = fp;
     }
 
-    virtual ~FunctionPointerBind() {
+    /** Move constructor: the bound arguments are moved, 'fp' is left unbound
+     */
+    FunctionPointerBind(FunctionPointerBind<R> && fp):
+        FunctionPointerBase<R>(),
+        _ops(&FunctionPointerBase<R>::_nullops) {
+        *this = std::move(fp);
+    }
+
+    ~FunctionPointerBind() {
         _ops->destructor(_storage);
     }
 
     FunctionPointerBind<R> & operator=(const FunctionPointerBind<R>& rhs) {
+        if (this == &rhs) {
+            return *this;
+        }
         if (_ops != &FunctionPointerBase<R>::_nullops) {
             _ops->destructor(_storage);
         }
@@ -78,10 +102,31 @@ public:
         return *this;
     }
 
+    /** Move assignment: the bound arguments are moved, 'rhs' is left unbound
+     */
+    FunctionPointerBind<R> & operator=(FunctionPointerBind<R>&& rhs) {
+        if (this == &rhs) {
+            return *this;
+        }
+        if (_ops != &FunctionPointerBase<R>::_nullops) {
+            _ops->destructor(_storage);
+        }
+        FunctionPointerBase<R>::copy(&rhs);
+        _ops = rhs._ops;
+        if (_ops->move_args != NULL) {
+            _ops->move_args(_storage, (void *)rhs._storage);
+        } else {
+            _ops->copy_args(_storage, (void *)rhs._storage);
+        }
+        rhs.clear();
+        return *this;
+    }
+
     /**
      * Clears the current binding, making this instance unbound
+     * This hides FunctionPointerBase::clear(), which doesn't destroy the bound arguments.
      */
-    virtual void clear() {
+    void clear() {
         if (_ops != &FunctionPointerBase<R>::_nullops) {
             _ops->destructor(_storage);
         }
@@ -0,0 +1,395 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MBED_UTIL_INDEXED_BINARY_HEAP_H__
+#define __MBED_UTIL_INDEXED_BINARY_HEAP_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core-util/CriticalSectionLock.h"
+#include "core-util/Array.h"
+#include "core-util/BinaryHeap.h"
+#include "ualloc/ualloc.h"
+
+/** A reentrant, addressable binary heap class.
+  *
+  * It works like BinaryHeap, but insert() returns a handle that can later be used to
+  * remove the element or change its value in O(log n), without searching the heap.
+  * This is useful for timer queues, where cancelling or rescheduling a pending timer
+  * is a frequent operation.
+  *
+  * The position of each element in the heap is tracked in a side index (an Array of
+  * slots, one per live handle). Slots are recycled through a free list and carry a
+  * generation number, so a handle that refers to an element that was already removed
+  * (for example a timer that already expired) is detected and rejected instead of
+  * affecting an unrelated element.
+  *
+  * Usage example:
+  *
+  * @code
+  * #include "core-util/IndexedBinaryHeap.h"
+  *
+  * int main() {
+  *     IndexedBinaryHeap<uint32_t> heap;
+  *     UAllocTraits_t traits = {0};
+  *     heap.init(16, 16, traits);
+  *
+  *     IndexedBinaryHeap<uint32_t>::Handle h = heap.insert(100);
+  *     heap.insert(50);
+  *     heap.update(h, 10); // h is now the root of the heap
+  *     heap.remove(h);     // O(log n), no search
+  * }
+  * @endcode
+  */
+namespace mbed {
+namespace util {
+
+template <typename T, typename Comparator=MinCompare<T> >
+class IndexedBinaryHeap {
+public:
+    /** Opaque reference to an element in the heap, returned by insert()
+      */
+    class Handle {
+    public:
+        /** Create an invalid handle
+          */
+        Handle(): _slot(INVALID_SLOT), _generation(0) {
+        }
+
+        /** Checks if this handle was returned by a successful insert()
+          * @returns true if the handle is valid, false otherwise
+          */
+        bool is_valid() const {
+            return _slot != INVALID_SLOT;
+        }
+
+        bool operator ==(const Handle& other) const {
+            return (_slot == other._slot) && (_generation == other._generation);
+        }
+
+        bool operator !=(const Handle& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        friend class IndexedBinaryHeap;
+
+        Handle(uint32_t slot, uint32_t generation): _slot(slot), _generation(generation) {
+        }
+
+        uint32_t _slot;
+        uint32_t _generation;
+    };
+
+    /** Construct a new indexed binary heap
+      */
+    IndexedBinaryHeap(const Comparator& comparator = Comparator()):
+        _nodes(), _slots(), _comparator(comparator), _elements(0), _free_slot(INVALID_SLOT) {
+    }
+
+    /* Forbid copy and assignment */
+    IndexedBinaryHeap(const IndexedBinaryHeap&) = delete;
+    IndexedBinaryHeap(IndexedBinaryHeap&&) = delete;
+    IndexedBinaryHeap& operator =(const IndexedBinaryHeap&) = delete;
+    IndexedBinaryHeap& operator =(IndexedBinaryHeap&&) = delete;
+
+    /** Initialize the heap
+      * The elements are stored in Arrays, which find an element by walking their zones, so
+      * every access costs O(zones). Size initial_capacity for the expected number of elements.
+      * @param initial_capacity initial capacity of the heap
+      * @param grow_capacity number of elements to add when the heap's capacity is exceeded
+      * @param alloc_traits allocator traits (for mbed_ualloc)
+      * @param alignment alignment of each element in the array
+      * @returns true if the initialization succeeded, false otherwise
+      */
+    bool init(size_t initial_capacity, size_t grow_capacity, UAllocTraits_t alloc_traits, unsigned alignment = MBED_UTIL_POOL_ALLOC_DEFAULT_ALIGN) {
+        _elements = 0;
+        _free_slot = INVALID_SLOT;
+        return _nodes.init(initial_capacity, grow_capacity, alloc_traits, alignment) &&
+               _slots.init(initial_capacity, grow_capacity, alloc_traits, alignment);
+    }
+
+    /** Inserts an element in the heap
+      * @param e the element to insert
+      * @returns a valid handle for success, an invalid handle for failure (out of memory)
+      */
+    Handle insert(const T& e) {
+        CriticalSectionLock lock;
+        uint32_t slot = _alloc_slot();
+        if (slot == INVALID_SLOT)
+            return Handle();
+        if (!_nodes.push_back(node(e, slot))) {
+            _free_slot_entry(slot);
+            return Handle();
+        }
+        _slots[slot].position = _elements;
+        if (++_elements > 1) {
+            _propagate_up(_elements - 1);
+        }
+        return Handle(slot, _slots[slot].generation);
+    }
+
+    /** Returns a copy of the element in the root of the heap
+      * @returns copy of the root
+      */
+    T get_root() const {
+        if (_elements == 0) {
+            CORE_UTIL_RUNTIME_ERROR("get_root() called on an empty IndexedBinaryHeap");
+        }
+        return _nodes[0].value;
+    }
+
+    /** Returns the handle of the element in the root of the heap
+      * @returns handle of the root, or an invalid handle if the heap is empty
+      */
+    Handle get_root_handle() const {
+        CriticalSectionLock lock;
+        if (_elements == 0)
+            return Handle();
+        uint32_t slot = _nodes[0].slot;
+        return Handle(slot, _slots[slot].generation);
+    }
+
+    /** Remove the root of the heap and return a copy of its value
+      * @returns copy of the root
+      */
+    T pop_root() {
+        if (_elements == 0) {
+            CORE_UTIL_RUNTIME_ERROR("pop_root() called on an empty IndexedBinaryHeap");
+        }
+        CriticalSectionLock lock;
+        T temp = _nodes[0].value;
+        _remove_at(0);
+        return temp;
+    }
+
+    /** Removes the element at the root of the heap, possibly re-shaping the heap
+      * to keep it consistent. The handle of the root becomes invalid.
+      */
+    void remove_root() {
+        CriticalSectionLock lock;
+        if (_elements > 0)
+            _remove_at(0);
+    }
+
+    /** Remove an element from the heap using the handle returned by insert()
+      * @param h handle of the element
+      * @returns true if the element was found and removed, false if the handle is
+      *          invalid or the element was already removed
+      */
+    bool remove(const Handle& h) {
+        CriticalSectionLock lock;
+        if (!_is_live(h))
+            return false;
+        _remove_at(_slots[h._slot].position);
+        return true;
+    }
+
+    /** Change the value of an element in the heap (for example decrease its key),
+      * then move it up or down to keep the heap consistent. The handle stays valid.
+      * @param h handle of the element
+      * @param new_value the new value of the element
+      * @returns true if the element was updated, false if the handle is invalid or
+      *          the element was already removed
+      */
+    bool update(const Handle& h, const T& new_value) {
+        CriticalSectionLock lock;
+        if (!_is_live(h))
+            return false;
+        size_t pos = _slots[h._slot].position;
+        _nodes[pos].value = new_value;
+        _restore(pos);
+        return true;
+    }
+
+    /** Checks if the element referenced by a handle is still in the heap
+      * @param h handle of the element
+      * @returns true if the element is in the heap, false otherwise
+      */
+    bool contains(const Handle& h) const {
+        CriticalSectionLock lock;
+        return _is_live(h);
+    }
+
+    /** Returns a copy of the element referenced by a handle
+      * Calling this function with a handle that is not in the heap results in a runtime error.
+      * @param h handle of the element
+      * @returns copy of the element
+      */
+    T get(const Handle& h) const {
+        CriticalSectionLock lock;
+        if (!_is_live(h)) {
+            CORE_UTIL_RUNTIME_ERROR("get() called with a stale handle on IndexedBinaryHeap %p\r\n", this);
+        }
+        return _nodes[_slots[h._slot].position].value;
+    }
+
+    /** Checks if the heap is empty
+      * @returns true if the heap is empty, false otherwise
+      */
+    bool is_empty() const {
+        return _elements == 0;
+    }
+
+    /** Check the heap's consistency by applying the user supplied comparison function to its nodes
+      * and by checking that the side index points back to every node
+      * @returns true if the heap is consistent, false otherwise
+      */
+    bool is_consistent(size_t node = 0) const {
+        if (node >= _elements)
+            return true;
+        if (_slots[_nodes[node].slot].position != node)
+            return false;
+        size_t left = _left(node), right = _right(node);
+        if ((left < _elements) && !_comparator(_nodes[node].value, _nodes[left].value))
+            return false;
+        if ((right < _elements) && !_comparator(_nodes[node].value, _nodes[right].value))
+            return false;
+        return is_consistent(left) && is_consistent(right);
+    }
+
+    /** Returns the number of elements in the heap
+      * @returns number of elements in the heap
+      */
+    size_t get_num_elements() const {
+        return _elements;
+    }
+
+private:
+    static const uint32_t INVALID_SLOT = 0xFFFFFFFFUL;
+
+    struct node {
+        node(const T& _value, uint32_t _slot): value(_value), slot(_slot) {
+        }
+
+        T value;
+        uint32_t slot;
+    };
+
+    struct slot_entry {
+        slot_entry(): position(INVALID_SLOT), generation(0) {
+        }
+
+        // Position of the node in '_nodes' when the slot is in use,
+        // index of the next free slot when the slot is free
+        uint32_t position;
+        uint32_t generation;
+    };
+
+    size_t _left(size_t i) const {
+        return 2 * i + 1;
+    }
+
+    size_t _right(size_t i) const {
+        return 2 * i + 2;
+    }
+
+    size_t _parent(size_t i) const {
+        return (i - 1) / 2;
+    }
+
+    bool _is_live(const Handle& h) const {
+        return (h._slot < _slots.get_num_elements()) && (_slots[h._slot].generation == h._generation);
+    }
+
+    uint32_t _alloc_slot() {
+        if (_free_slot != INVALID_SLOT) {
+            uint32_t slot = _free_slot;
+            _free_slot = _slots[slot].position;
+            return slot;
+        }
+        if (!_slots.push_back(slot_entry()))
+            return INVALID_SLOT;
+        return _slots.get_num_elements() - 1;
+    }
+
+    void _free_slot_entry(uint32_t slot) {
+        // Bumping the generation invalidates all the handles that refer to this slot
+        _slots[slot].generation ++;
+        _slots[slot].position = _free_slot;
+        _free_slot = slot;
+    }
+
+    void _remove_at(size_t pos) {
+        uint32_t slot = _nodes[pos].slot;
+        _swap(pos, --_elements); // element 'pos' will be destroyed by 'pop_back()' below
+        _nodes.pop_back();
+        // Free the slot after the swap, which would overwrite its free list link
+        _free_slot_entry(slot);
+        if (pos < _elements)
+            _restore(pos);
+    }
+
+    void _restore(size_t node) {
+        // The value at 'node' changed (or was replaced with the last node in the heap),
+        // so it might have to move either up or down
+        if ((node > 0) && _comparator(_nodes[node].value, _nodes[_parent(node)].value)) {
+            _propagate_up(node);
+        } else {
+            _propagate_down(node);
+        }
+    }
+
+    void _propagate_up(size_t node) {
+        size_t parent = _parent(node);
+        while ((node > 0) && _comparator(_nodes[node].value, _nodes[parent].value)) {
+            _swap(node, parent);
+            node = parent;
+            parent = _parent(node);
+        }
+    }
+
+    void _propagate_down(size_t node) {
+        while (true) {
+            size_t left = _left(node), right = _right(node), temp;
+            bool change_left = (left < _elements) && !_comparator(_nodes[node].value, _nodes[left].value);
+            bool change_right = (right < _elements) && !_comparator(_nodes[node].value, _nodes[right].value);
+            if (change_left && change_right) {
+                temp = _comparator(_nodes[left].value, _nodes[right].value) ? left : right;
+            } else if (change_left) {
+                temp = left;
+            } else if (change_right) {
+                temp = right;
+            } else {
+                break;
+            }
+            _swap(node, temp);
+            node = temp;
+        }
+    }
+
+    void _swap(size_t pos1, size_t pos2) {
+        if (pos1 != pos2) {
+            node temp = _nodes[pos1];
+            _nodes[pos1] = _nodes[pos2];
+            _nodes[pos2] = temp;
+            _slots[_nodes[pos1].slot].position = pos1;
+            _slots[_nodes[pos2].slot].position = pos2;
+        }
+    }
+
+    Array<node> _nodes;
+    Array<slot_entry> _slots;
+    Comparator _comparator;
+    volatile size_t _elements;
+    uint32_t _free_slot;
+};
+
+} // namespace util
+} // namespace mbed
+
+#endif // #ifndef __MBED_UTIL_INDEXED_BINARY_HEAP_H__
@@ -0,0 +1,281 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CORE_UTIL_INTRUSIVEPOINTER_H__
+#define __CORE_UTIL_INTRUSIVEPOINTER_H__
+
+#include "core-util/SharedPointer.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace mbed {
+namespace util {
+
+/** Base class for objects managed by IntrusivePointer. It holds the reference counter
+  * inside the object. RefCount is the counting policy: SharedPointerPlainCount (default)
+  * or SharedPointerAtomicCount for objects shared between threads.
+  *
+  * Any class that provides use_count(), add_ref() and release_ref() with the same meaning can be used
+  * with IntrusivePointer instead of deriving from RefCounted.
+  */
+template <class RefCount = SharedPointerPlainCount>
+class RefCounted {
+public:
+    /**
+     * @brief Reference count accessor.
+     * @return Number of IntrusivePointers to this object.
+     */
+    uint32_t use_count() const {
+        return RefCount::load(&_ref_count);
+    }
+
+    /**
+     * @brief Add a reference to this object.
+     */
+    void add_ref() {
+        RefCount::increment(&_ref_count);
+    }
+
+    /**
+     * @brief Remove a reference to this object.
+     * @return The new reference count. The caller must destroy the object if it is zero.
+     */
+    uint32_t release_ref() {
+        return RefCount::decrement(&_ref_count);
+    }
+
+protected:
+    RefCounted(): _ref_count(0) {
+    }
+
+    /* Copies of the object start without references */
+    RefCounted(const RefCounted&): _ref_count(0) {
+    }
+
+    RefCounted& operator=(const RefCounted&) {
+        return *this;
+    }
+
+private:
+    uint32_t _ref_count;
+};
+
+/** Deletion policy for IntrusivePointer: objects allocated with new.
+  */
+class IntrusiveDelete {
+public:
+    template <class T>
+    static void destroy(T* pointer) {
+        delete pointer;
+    }
+};
+
+/** Deletion policy for IntrusivePointer: objects constructed in memory allocated from
+  * 'allocator' (a PoolAllocator or ExtendablePoolAllocator with static storage duration).
+  * The object is destroyed and its memory is returned to the allocator.
+  */
+template <class Allocator, Allocator* allocator>
+class IntrusivePoolDelete {
+public:
+    template <class T>
+    static void destroy(T* pointer) {
+        pointer->~T();
+        allocator->free(pointer);
+    }
+};
+
+/** Intrusive pointer class.
+  *
+  * Like SharedPointer, but the reference counter is kept in the object itself (by deriving
+  * from RefCounted), so an IntrusivePointer is a single word and creating one doesn't
+  * allocate any memory. A new IntrusivePointer can be created at any time from a raw pointer
+  * to an object that is already managed by other IntrusivePointers, for example from 'this'.
+  *
+  * The object is destroyed by the Deleter policy when the last IntrusivePointer to it is
+  * destroyed: IntrusiveDelete (default) calls delete, IntrusivePoolDelete returns the object
+  * to a pool.
+  *
+  * Usage:
+  * @code
+  * class Message : public RefCounted<SharedPointerAtomicCount> {
+  *     ...
+  * };
+  *
+  * PoolAllocator message_pool(memory, elements, sizeof(Message));
+  * typedef IntrusivePointer<Message, IntrusivePoolDelete<PoolAllocator, &message_pool> > MessagePointer;
+  *
+  * MessagePointer msg(new(message_pool.alloc()) Message());
+  * @endcode
+  */
+template <class T, class Deleter = IntrusiveDelete>
+class IntrusivePointer {
+public:
+    /**
+     * @brief Create empty IntrusivePointer not pointing to anything.
+     */
+    IntrusivePointer(): pointer(NULL) {
+    }
+
+    /**
+     * @brief Create new IntrusivePointer.
+     * @param _pointer Pointer to the object (can be NULL).
+     */
+    IntrusivePointer(T* _pointer): pointer(_pointer) {
+        if (pointer) {
+            pointer->add_ref();
+        }
+    }
+
+    /**
+     * @brief Copy constructor.
+     * @param source Object being copied from.
+     */
+    IntrusivePointer(const IntrusivePointer& source): pointer(source.pointer) {
+        if (pointer) {
+            pointer->add_ref();
+        }
+    }
+
+    /**
+     * @brief Move constructor.
+     * @details 'source' is left empty.
+     * @param source Object being moved from.
+     */
+    IntrusivePointer(IntrusivePointer&& source): pointer(source.pointer) {
+        source.pointer = NULL;
+    }
+
+    /**
+     * @brief Destructor.
+     * @details Decrement reference counter and destroy object if no longer pointed to.
+     */
+    ~IntrusivePointer() {
+        release();
+    }
+
+    /**
+     * @brief Assignment operator.
+     * @details The old reference is released last, so 'source' can be owned by the
+     *          object being released (p = p->next).
+     * @param source Object being assigned from.
+     * @return Object being assigned.
+     */
+    IntrusivePointer& operator=(const IntrusivePointer& source) {
+        IntrusivePointer(source).swap(*this);
+        return *this;
+    }
+
+    /**
+     * @brief Move assignment operator.
+     * @details 'source' is left empty. The old reference is released last, so 'source' can
+     *          be owned by the object being released (p = std::move(p->next)).
+     * @param source Object being moved from.
+     * @return Object being assigned.
+     */
+    IntrusivePointer& operator=(IntrusivePointer&& source) {
+        IntrusivePointer(std::move(source)).swap(*this);
+        return *this;
+    }
+
+    /**
+     * @brief Exchange the objects pointed to by two IntrusivePointers.
+     * @param other IntrusivePointer to swap with.
+     */
+    void swap(IntrusivePointer& other) {
+        T* temp = pointer;
+        pointer = other.pointer;
+        other.pointer = temp;
+    }
+
+    /**
+     * @brief Release the reference and make this IntrusivePointer empty.
+     */
+    void reset() {
+        release();
+        pointer = NULL;
+    }
+
+    /**
+     * @brief Raw pointer accessor.
+     * @return Pointer.
+     */
+    T* get() const {
+        return pointer;
+    }
+
+    /**
+     * @brief Reference count accessor.
+     * @return Reference count.
+     */
+    uint32_t use_count() const {
+        return pointer ? pointer->use_count() : 0;
+    }
+
+    /**
+     * @brief Dereference object operator.
+     */
+    T& operator*() const {
+        CORE_UTIL_ASSERT(pointer);
+
+        return *pointer;
+    }
+
+    /**
+     * @brief Dereference object member operator.
+     */
+    T* operator->() const {
+        CORE_UTIL_ASSERT(pointer);
+
+        return pointer;
+    }
+
+    /**
+     * @brief Boolean conversion operator.
+     * @return Whether or not the pointer is NULL.
+     */
+    operator bool() const {
+        return (pointer != 0);
+    }
+
+private:
+    void release() {
+        if (pointer && (pointer->release_ref() == 0)) {
+            Deleter::destroy(pointer);
+        }
+    }
+
+    // pointer to the object, which holds the reference counter
+    T* pointer;
+};
+
+/** Non-member relational operators.
+  */
+template <class T, class D, class U, class E>
+bool operator== (const IntrusivePointer<T, D>& lhs, const IntrusivePointer<U, E>& rhs) {
+    return (lhs.get() == rhs.get());
+}
+
+template <class T, class D, class U, class E>
+bool operator!= (const IntrusivePointer<T, D>& lhs, const IntrusivePointer<U, E>& rhs) {
+    return (lhs.get() != rhs.get());
+}
+
+} // namespace util
+} // namespace mbed
+
+#endif // __CORE_UTIL_INTRUSIVEPOINTER_H__
@@ -0,0 +1,233 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MBED_UTIL_PAIRING_HEAP_H__
+#define __MBED_UTIL_PAIRING_HEAP_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core-util/CriticalSectionLock.h"
+#include "core-util/ExtendablePoolAllocator.h"
+#include "core-util/BinaryHeap.h"
+#include "core-util/assert.h"
+#include "ualloc/ualloc.h"
+
+/** A reentrant pairing heap class (https://en.wikipedia.org/wiki/Pairing_heap)
+  *
+  * Like BinaryHeap, it can hold elements of any type ordered by a comparator class
+  * (MinCompare or MaxCompare), but insert() is O(1): the new element is simply linked
+  * with the current root. The work is done when the root is removed, by merging its
+  * children in pairs (amortized O(log n)). This works well when many elements are inserted
+  * and only some of them reach the root, for example timers that are often cancelled.
+  *
+  * The elements are stored in tree nodes allocated from an ExtendablePoolAllocator.
+  *
+  * Usage example:
+  *
+  * @code
+  * #include "core-util/PairingHeap.h"
+  *
+  * int main() {
+  *     PairingHeap<int> minh; // implicit MinCompare (min-heap)
+  *     PairingHeap<int, MaxCompare<int> > maxh; // explicit MaxCompare (max-heap)
+  * }
+  * @endcode
+  */
+namespace mbed {
+namespace util {
+
+template <typename T, typename Comparator=MinCompare<T>, typename Lock=CriticalSectionLock>
+class PairingHeap {
+public:
+    /** Construct a new pairing heap
+      */
+    PairingHeap(const Comparator& comparator = Comparator()): _comparator(comparator), _root(NULL), _elements(0) {
+    }
+
+    /* Forbid copy and assignment */
+    PairingHeap(const PairingHeap&) = delete;
+    PairingHeap(PairingHeap&&) = delete;
+    PairingHeap& operator =(const PairingHeap&) = delete;
+    PairingHeap& operator =(PairingHeap&&) = delete;
+
+    /** Destructor. It destroys all the elements still in the heap
+      */
+    ~PairingHeap() {
+        // Walk the tree without recursion by splicing the children of each node
+        // into the list of siblings that still have to be visited
+        node *crt = _root, *next;
+        while (crt != NULL) {
+            if (crt->child != NULL) {
+                node *last = crt->child;
+                while (last->sibling != NULL) {
+                    last = last->sibling;
+                }
+                last->sibling = crt->sibling;
+                crt->sibling = crt->child;
+            }
+            next = crt->sibling;
+            _free_node(crt);
+            crt = next;
+        }
+    }
+
+    /** Initialize the heap
+      * @param initial_capacity initial capacity of the heap
+      * @param grow_capacity number of elements to add when the heap's capacity is exceeded
+      * @param alloc_traits allocator traits (for mbed_ualloc)
+      * @param alignment alignment of each element in the heap
+      * @returns true if the initialization succeeded, false otherwise
+      */
+    bool init(size_t initial_capacity, size_t grow_capacity, UAllocTraits_t alloc_traits, unsigned alignment = MBED_UTIL_POOL_ALLOC_DEFAULT_ALIGN) {
+        _elements = 0;
+        return _allocator.init(initial_capacity, grow_capacity, sizeof(node), alloc_traits, alignment);
+    }
+
+    /** Inserts an element in the heap
+      * @param e the element to insert
+      * @returns true for success, false for failure (out of memory)
+      */
+    bool insert(const T& e) {
+        Lock lock;
+        void *p = _allocator.alloc();
+        if (p == NULL)
+            return false;
+        node *n = new(p) node(e);
+        _root = (_root == NULL) ? n : _meld(_root, n);
+        _elements ++;
+        return true;
+    }
+
+    /** Returns a copy of the element in the root of the heap
+      * @returns copy of the root
+      */
+    T get_root() const {
+        if (_elements == 0) {
+            CORE_UTIL_RUNTIME_ERROR("get_root() called on an empty PairingHeap");
+        }
+        return _root->value;
+    }
+
+    /** Remove the root of the heap and return a copy of its value
+      * @returns copy of the root
+      */
+    T pop_root() {
+        if (_elements == 0) {
+            CORE_UTIL_RUNTIME_ERROR("pop_root() called on an empty PairingHeap");
+        }
+        Lock lock;
+        T temp = _root->value;
+        remove_root();
+        return temp;
+    }
+
+    /** Removes the element at the root of the heap, merging its children into a new root
+      */
+    void remove_root() {
+        Lock lock;
+        if (_elements == 0)
+            return;
+        node *old_root = _root;
+        _root = _merge_pairs(old_root->child);
+        _free_node(old_root);
+        _elements --;
+    }
+
+    /** Checks if the heap is empty
+      * @returns true if the heap is empty, false otherwise
+      */
+    bool is_empty() const {
+        return _elements == 0;
+    }
+
+    /** Returns the number of elements in the heap
+      * @returns number of elements in the heap
+      */
+    size_t get_num_elements() const {
+        return _elements;
+    }
+
+private:
+    struct node {
+        node(const T& _value): value(_value), child(NULL), sibling(NULL) {
+        }
+
+        T value;
+        node *child;
+        node *sibling;
+    };
+
+    void _free_node(node *n) {
+        n->~node();
+        _allocator.free(n);
+    }
+
+    node *_meld(node *a, node *b) const {
+        // Both 'a' and 'b' are roots without siblings. The root that loses the comparison
+        // becomes the first child of the other one.
+        if (!_comparator(a->value, b->value)) {
+            node *temp = a;
+            a = b;
+            b = temp;
+        }
+        b->sibling = a->child;
+        a->child = b;
+        return a;
+    }
+
+    node *_merge_pairs(node *first) const {
+        if (first == NULL)
+            return NULL;
+        // First pass: meld the siblings in pairs, from left to right. The results are
+        // chained (in reverse order) using their 'sibling' pointer.
+        node *pairs = NULL;
+        while (first != NULL) {
+            node *a = first, *b = first->sibling;
+            if (b == NULL) {
+                a->sibling = pairs;
+                pairs = a;
+                break;
+            }
+            first = b->sibling;
+            a->sibling = b->sibling = NULL;
+            a = _meld(a, b);
+            a->sibling = pairs;
+            pairs = a;
+        }
+        // Second pass: meld the results from right to left into a single tree
+        node *res = pairs;
+        pairs = pairs->sibling;
+        res->sibling = NULL;
+        while (pairs != NULL) {
+            node *next = pairs->sibling;
+            pairs->sibling = NULL;
+            res = _meld(res, pairs);
+            pairs = next;
+        }
+        return res;
+    }
+
+    ExtendablePoolAllocator _allocator;
+    Comparator _comparator;
+    node *_root;
+    volatile size_t _elements;
+};
+
+} // namespace util
+} // namespace mbed
+
+#endif // #ifndef __MBED_UTIL_PAIRING_HEAP_H__
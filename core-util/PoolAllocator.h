@@ -20,6 +20,8 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <type_traits>
+#include "core-util/atomic_ops.h"
 
 #ifndef YOTTA_CFG_CORE_UTIL_POOL_ALLOC_DEFAULT_ALIGN
 #define YOTTA_CFG_CORE_UTIL_POOL_ALLOC_DEFAULT_ALIGN 8
@@ -33,12 +35,20 @@ namespace util {
 /** A simple pool allocator class. It can allocate one elements oe 'element_size' bytes at a time.
   * alloc() and free() operations are synchronized, they can be used safely from both user
   * and interrupt context.
+  *
+  * The free elements are linked by index, and the head of the list carries a tag that is
+  * changed by every alloc(), so an alloc() that was interrupted while other alloc() and
+  * free() calls took and returned its element can't install a stale link (the ABA problem).
+  * The index and the tag share one word that the target can update with a single native
+  * atomic_cas: 32 bits each where 64 bit atomics are native, 16 bits each otherwise (like
+  * on Cortex-M, where the 32 bit word is updated with load/store-exclusive).
   */
 class PoolAllocator {
 public:
     /** Create a new pool allocator
       * @param start pool start address
-      * @param elements the size of pool in elements (each of element_size bytes)
+      * @param elements the size of pool in elements (each of element_size bytes), at most
+      *        get_max_elements(). Larger pools assert, and only use get_max_elements() elements.
       * @param element_size size of each pool element in bytes (this might be rounded up
                to satisfy the 'alignment' argument)
       * @param alignment allocation alignment in bytes (must be a power of 2, at least 4)
@@ -75,6 +85,12 @@ public:
       */
     static size_t get_pool_size(size_t elements, size_t element_size, unsigned alignment = MBED_UTIL_POOL_ALLOC_DEFAULT_ALIGN);
 
+    /** Returns the maximum number of elements in a pool: 2^32 - 1 where 64 bit atomics
+      * are native, 2^16 - 1 otherwise (see the class description)
+      * @returns maximum number of elements
+      */
+    static size_t get_max_elements();
+
     /** Check if this pool owns a pointer
       * @param p the pointer to check
       * @returns true if the pointer is inside this pool, false otherwise
@@ -82,11 +98,11 @@ public:
     bool owns(const void *p) const;
 
     /** Aligns a quantity up to the given alignment (which must be a power of 2)
-      * @param n the quantity to align
+      * @param n the quantity to align (a size or an address, so it is pointer sized)
       * @param alignment the alignment
       * @returns the aligned quantity
       */
-    static uint32_t align_up(uint32_t n, uint32_t alignment);
+    static uintptr_t align_up(uintptr_t n, uintptr_t alignment);
 
     /** Returns the start address of the pool
       * @returns start address
@@ -95,8 +111,16 @@ public:
 
 private:
     void _init();
+    uint32_t *_link(uint32_t index) const;
+
+    typedef std::conditional<atomic_is_native<uint64_t>::value, uint64_t, uint32_t>::type head_t;
+    static const unsigned head_index_bits = sizeof(head_t) * 4;
+    static const head_t head_index_mask = ((head_t)1 << head_index_bits) - 1;
 
-    void *_start, *_free_block, *_end;
+    void *_start, *_end;
+    // Index of the first free element plus one (0 if the pool is exhausted) in the low
+    // half, tag in the high half
+    head_t _free_head;
     size_t _element_size;
 };
 
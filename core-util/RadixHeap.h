@@ -0,0 +1,283 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MBED_UTIL_RADIX_HEAP_H__
+#define __MBED_UTIL_RADIX_HEAP_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core-util/CriticalSectionLock.h"
+#include "core-util/ExtendablePoolAllocator.h"
+#include "core-util/assert.h"
+#include "ualloc/ualloc.h"
+
+/** A reentrant radix heap class (a monotone min-heap for unsigned integer keys).
+  *
+  * A radix heap can only be used when the popped keys never decrease, which is the case for
+  * timer queues and event schedulers: an element can't be inserted with a key smaller than the
+  * key of the last root returned by get_root() or pop_root(). In exchange, insert() is O(1)
+  * and the removal of the root is amortized O(number of bits in the key), with very small
+  * constants.
+  *
+  * The elements are kept in buckets: bucket 0 holds the elements with the same key as the last
+  * root, bucket i holds the elements whose key differs from it first in bit (i - 1).
+  * The elements are stored in nodes allocated from an ExtendablePoolAllocator.
+  *
+  * The key of an element is obtained using a key extractor class. By default the element is
+  * its own key (RadixIdentityKey), which works for all unsigned integer types.
+  *
+  * Usage example:
+  *
+  * @code
+  * #include "core-util/RadixHeap.h"
+  *
+  * struct Timer {
+  *     uint32_t deadline;
+  *     void *data;
+  * };
+  *
+  * struct TimerKey {
+  *     uint32_t operator ()(const Timer& t) const {
+  *         return t.deadline;
+  *     }
+  * };
+  *
+  * int main() {
+  *     RadixHeap<uint32_t> h1;
+  *     RadixHeap<Timer, uint32_t, TimerKey> h2;
+  * }
+  * @endcode
+  */
+namespace mbed {
+namespace util {
+
+/** Key extractor for RadixHeap: the element is its own key
+  */
+template<typename T>
+class RadixIdentityKey {
+public:
+    /** Function call operator used for getting the key of an element
+      * @param e the element
+      * @returns the key of the element (the element itself)
+      */
+    T operator ()(const T& e) const {
+        return e;
+    }
+};
+
+template <typename T, typename Key = T, typename KeyOf = RadixIdentityKey<T>, typename Lock = CriticalSectionLock>
+class RadixHeap {
+public:
+    /** Construct a new radix heap
+      */
+    RadixHeap(const KeyOf& key_of = KeyOf()): _key_of(key_of), _last(0), _elements(0) {
+        for (unsigned i = 0; i < NUM_BUCKETS; i ++) {
+            _buckets[i] = NULL;
+        }
+    }
+
+    /* Forbid copy and assignment */
+    RadixHeap(const RadixHeap&) = delete;
+    RadixHeap(RadixHeap&&) = delete;
+    RadixHeap& operator =(const RadixHeap&) = delete;
+    RadixHeap& operator =(RadixHeap&&) = delete;
+
+    /** Destructor. It destroys all the elements still in the heap
+      */
+    ~RadixHeap() {
+        for (unsigned i = 0; i < NUM_BUCKETS; i ++) {
+            node *crt = _buckets[i], *next;
+            while (crt != NULL) {
+                next = crt->next;
+                _free_node(crt);
+                crt = next;
+            }
+        }
+    }
+
+    /** Initialize the heap
+      * @param initial_capacity initial capacity of the heap
+      * @param grow_capacity number of elements to add when the heap's capacity is exceeded
+      * @param alloc_traits allocator traits (for mbed_ualloc)
+      * @param alignment alignment of each element in the heap
+      * @returns true if the initialization succeeded, false otherwise
+      */
+    bool init(size_t initial_capacity, size_t grow_capacity, UAllocTraits_t alloc_traits, unsigned alignment = MBED_UTIL_POOL_ALLOC_DEFAULT_ALIGN) {
+        _elements = 0;
+        _last = 0;
+        return _allocator.init(initial_capacity, grow_capacity, sizeof(node), alloc_traits, alignment);
+    }
+
+    /** Inserts an element in the heap
+      * @param e the element to insert. Its key must not be smaller than get_min_key().
+      * @returns true for success, false for failure (out of memory or key smaller than
+      *          get_min_key())
+      */
+    bool insert(const T& e) {
+        Lock lock;
+        Key key = _key_of(e);
+        if (key < _last)
+            return false;
+        void *p = _allocator.alloc();
+        if (p == NULL)
+            return false;
+        node *n = new(p) node(e);
+        _push(_bucket_index(key), n);
+        _elements ++;
+        return true;
+    }
+
+    /** Returns a copy of the element in the root of the heap
+      * @returns copy of the root
+      */
+    T get_root() const {
+        Lock lock;
+        if (_elements == 0) {
+            CORE_UTIL_RUNTIME_ERROR("get_root() called on an empty RadixHeap");
+        }
+        return _root()->value;
+    }
+
+    /** Remove the root of the heap and return a copy of its value
+      * @returns copy of the root
+      */
+    T pop_root() {
+        Lock lock;
+        if (_elements == 0) {
+            CORE_UTIL_RUNTIME_ERROR("pop_root() called on an empty RadixHeap");
+        }
+        T temp = _root()->value;
+        remove_root();
+        return temp;
+    }
+
+    /** Removes the element at the root of the heap
+      */
+    void remove_root() {
+        Lock lock;
+        if (_elements == 0)
+            return;
+        node *n = _root();
+        _buckets[0] = n->next;
+        _free_node(n);
+        _elements --;
+    }
+
+    /** Checks if the heap is empty
+      * @returns true if the heap is empty, false otherwise
+      */
+    bool is_empty() const {
+        return _elements == 0;
+    }
+
+    /** Returns the number of elements in the heap
+      * @returns number of elements in the heap
+      */
+    size_t get_num_elements() const {
+        return _elements;
+    }
+
+    /** Returns the key of the last root returned by get_root() or pop_root() (initially 0)
+      * New elements can't have a smaller key than this.
+      * @returns the smallest key that can be inserted in the heap
+      */
+    Key get_min_key() const {
+        return _last;
+    }
+
+private:
+    static const unsigned NUM_BUCKETS = sizeof(Key) * 8 + 1;
+
+    struct node {
+        node(const T& _value): value(_value), next(NULL) {
+        }
+
+        T value;
+        node *next;
+    };
+
+    unsigned _bucket_index(Key key) const {
+        Key diff = key ^ _last;
+        if (diff == 0)
+            return 0;
+#if defined(__GNUC__)
+        if (sizeof(Key) <= sizeof(unsigned)) {
+            return sizeof(unsigned) * 8 - __builtin_clz((unsigned)diff);
+        } else {
+            return sizeof(unsigned long long) * 8 - __builtin_clzll((unsigned long long)diff);
+        }
+#else
+        unsigned idx = 0;
+        while (diff != 0) {
+            idx ++;
+            diff >>= 1;
+        }
+        return idx;
+#endif
+    }
+
+    void _push(unsigned bucket, node *n) const {
+        n->next = _buckets[bucket];
+        _buckets[bucket] = n;
+    }
+
+    void _free_node(node *n) {
+        n->~node();
+        _allocator.free(n);
+    }
+
+    node *_root() const {
+        // Called with a non-empty heap. If bucket 0 is empty, find the first non-empty bucket,
+        // make its smallest key the new '_last' and redistribute the bucket. All its elements
+        // go to lower buckets and at least one of them (the smallest) goes to bucket 0.
+        if (_buckets[0] == NULL) {
+            unsigned i = 1;
+            while (_buckets[i] == NULL) {
+                i ++;
+            }
+            node *crt = _buckets[i], *next;
+            Key min_key = _key_of(crt->value);
+            for (crt = crt->next; crt != NULL; crt = crt->next) {
+                Key key = _key_of(crt->value);
+                if (key < min_key)
+                    min_key = key;
+            }
+            _last = min_key;
+            crt = _buckets[i];
+            _buckets[i] = NULL;
+            while (crt != NULL) {
+                next = crt->next;
+                _push(_bucket_index(_key_of(crt->value)), crt);
+                crt = next;
+            }
+        }
+        return _buckets[0];
+    }
+
+    // The buckets are reorganized lazily when looking for the root, which doesn't change the
+    // contents of the heap, so they can be modified from const member functions
+    mutable node *_buckets[NUM_BUCKETS];
+    ExtendablePoolAllocator _allocator;
+    KeyOf _key_of;
+    mutable Key _last;
+    volatile size_t _elements;
+};
+
+} // namespace util
+} // namespace mbed
+
+#endif // #ifndef __MBED_UTIL_RADIX_HEAP_H__
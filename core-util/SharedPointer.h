@@ -18,21 +18,147 @@
 #define __CORE_UTIL_SHAREDPOINTER_H__
 
 #include "core-util/assert.h"
+#include "core-util/atomic_ops.h"
+#include "core-util/PoolAllocator.h"
+#include "core-util/SharedPointerTrace.h"
 #include "ualloc/ualloc.h"
 
 #include <stdint.h>
 #include <stddef.h>
-
-#ifndef NDEBUG
-#include <stdio.h>
-#define CORE_UTIL_SHAREDPOINTER_DEBUG(...) { printf(__VA_ARGS__); }
-#else
-#define CORE_UTIL_SHAREDPOINTER_DEBUG(...) /* nothing */
-#endif
+#include <new>
+#include <utility>
+#include <type_traits>
 
 namespace mbed {
 namespace util {
 
+/** Reference counters shared by all the SharedPointer and WeakPointer instances that point
+  * to the same object. It is allocated either separately from the object (SharedPointer(T*))
+  * or in the same memory block as the object (make_shared(), allocate_shared()). 'dispose'
+  * and 'destroy' know how to destroy the object and free the memory in each case.
+  */
+struct SharedPointerControlBlock {
+    typedef void (*release_function_t)(SharedPointerControlBlock *block);
+
+    SharedPointerControlBlock(release_function_t _dispose, release_function_t _destroy):
+        count(1), weak_count(1), dispose(_dispose), destroy(_destroy) {
+    }
+
+    // Number of SharedPointers
+    uint32_t count;
+    // Number of WeakPointers, plus one for all the SharedPointers together
+    uint32_t weak_count;
+    // Called when 'count' reaches zero, destroys the object
+    release_function_t dispose;
+    // Called when 'weak_count' reaches zero, frees the control block
+    release_function_t destroy;
+};
+
+/** Reference counting policy for SharedPointers that are only used from one thread
+  * (or are protected by an external lock). The counter is updated with plain
+  * increments and decrements.
+  */
+class SharedPointerPlainCount {
+public:
+    static uint32_t load(const uint32_t *count) {
+        return *count;
+    }
+
+    static void increment(uint32_t *count) {
+        (*count)++;
+    }
+
+    /**
+     * @return The new value of the counter.
+     */
+    static uint32_t decrement(uint32_t *count) {
+        return --(*count);
+    }
+
+    /**
+     * @return true if the counter was incremented, false if it was zero.
+     */
+    static bool increment_if_not_zero(uint32_t *count) {
+        if (*count == 0) {
+            return false;
+        }
+        (*count)++;
+        return true;
+    }
+};
+
+/** Reference counting policy for SharedPointers that are copied and destroyed
+  * concurrently by different threads or interrupt handlers. The counter is only
+  * accessed with the atomic operations of atomic_ops.h, so the thread that drops the
+  * last reference is the only one that sees the counter reach zero and destroys the
+  * object.
+  */
+class SharedPointerAtomicCount {
+public:
+    // the value can change at any time, so it doesn't need to be ordered with anything
+    static uint32_t load(const uint32_t *count) {
+        return atomic_load(count, atomic_relaxed);
+    }
+
+    // a new reference is made from an existing one, so nothing needs to be ordered
+    static void increment(uint32_t *count) {
+        atomic_fetch_add(count, (uint32_t)1, atomic_relaxed);
+    }
+
+    /**
+     * @return The new value of the counter.
+     */
+    static uint32_t decrement(uint32_t *count) {
+        // the uses of the object through this reference happen before its destruction
+        return atomic_fetch_sub(count, (uint32_t)1, atomic_acq_rel) - 1;
+    }
+
+    /**
+     * @return true if the counter was incremented, false if it was zero.
+     */
+    static bool increment_if_not_zero(uint32_t *count) {
+        uint32_t current = atomic_load(count, atomic_relaxed);
+        while (current != 0) {
+            if (atomic_cas_weak(count, &current, current + 1, atomic_acq_rel)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/** Deleter for SharedPointers to objects constructed in memory allocated from a
+  * PoolAllocator or an ExtendablePoolAllocator: the object is destroyed and its memory
+  * is returned to the allocator.
+  */
+template <class Allocator>
+class PoolDeleter {
+public:
+    PoolDeleter(Allocator& _allocator): allocator(&_allocator) {
+    }
+
+    template <class T>
+    void operator()(T* pointer) const {
+        pointer->~T();
+        allocator->free(pointer);
+    }
+
+private:
+    Allocator* allocator;
+};
+
+template <class T, class RefCount = SharedPointerPlainCount>
+class SharedPointer;
+
+template <class T, class RefCount = SharedPointerPlainCount>
+class WeakPointer;
+
+template <class T, class RefCount = SharedPointerPlainCount, typename... Args>
+SharedPointer<T, RefCount> make_shared(Args&&... args);
+
+template <class T, class RefCount = SharedPointerPlainCount, typename... Args>
+SharedPointer<T, RefCount> allocate_shared(PoolAllocator& pool, Args&&... args);
+
 /** Shared pointer class.
   *
   * Similar to std::shared_ptr in C++11.
@@ -43,11 +169,35 @@ namespace util {
   * destructor counts the number of references to the original object.
   * If the counter reaches zero, delete is called on the object pointed to.
   *
-  * To avoid loops, "weak" references should be used by calling the original
-  * pointer directly through POINTER.get().
+  * To avoid loops, "weak" references should be kept in a WeakPointer, which doesn't keep
+  * the object alive and can tell whether the object still exists.
+  *
+  * SharedPointer(new class()) needs two allocations: one for the object and one for the
+  * reference counter. make_shared<class>(args) and allocate_shared<class>(pool, args)
+  * construct the object and the reference counter in a single allocation (from the heap or
+  * from a PoolAllocator respectively), which is faster and keeps the counter next to the
+  * object in memory.
+  *
+  * Objects that must not be released with delete can be given a deleter, a function or
+  * function object that is called with the pointer when the last reference is gone:
+  * SharedPointer<class>(pointer, deleter). The deleter is kept in the control block, which
+  * can also be allocated from a pool: SharedPointer<class>(pointer, deleter, pool). Use
+  * PoolDeleter for objects that were allocated from a PoolAllocator or an
+  * ExtendablePoolAllocator:
+  *
+  * @code
+  * SharedPointer<Message> msg(new(msg_pool.alloc()) Message(), PoolDeleter<PoolAllocator>(msg_pool), counter_pool);
+  * @endcode
+  *
+  * Reference counting activity can be traced per type with
+  * CORE_UTIL_SHAREDPOINTER_ENABLE_TRACE(class), see SharedPointerTrace.
+  *
+  * The reference counter is not thread safe by default. SharedPointers that are copied or
+  * destroyed concurrently from different threads must use the atomic counting policy:
+  * SharedPointer<class, SharedPointerAtomicCount> (and make_shared<class, SharedPointerAtomicCount>).
   */
 
-template <class T>
+template <class T, class RefCount>
 class SharedPointer {
 public:
     /**
@@ -55,7 +205,6 @@ public:
      * @details Used for variable declaration.
      */
     SharedPointer(): pointer(NULL), counter(NULL) {
-        CORE_UTIL_SHAREDPOINTER_DEBUG("SP: %p [%p: %p]\r\n", this, pointer, counter);
     }
 
     /**
@@ -67,13 +216,61 @@ public:
 
         // allocate counter on the heap so it can be shared
         UAllocTraits_t traits = {0};
-        counter = (uint32_t*) mbed_ualloc(sizeof(uint32_t), traits);
+        separate_block *block = (separate_block*) mbed_ualloc(sizeof(separate_block), traits);
 
         // initialize counter to 1
-        CORE_UTIL_ASSERT(counter);
-        *counter = 1;
+        CORE_UTIL_ASSERT(block);
+        counter = new(block) separate_block(pointer);
+
+        trace(SHAREDPOINTER_TRACE_CREATE, 1);
+    }
+
+    /**
+     * @brief Create new SharedPointer with a custom deleter.
+     * @details The control block is allocated with mbed_ualloc. If that fails, the
+     *          object is released with 'deleter' and the SharedPointer is empty.
+     * @param _pointer Pointer to take control over
+     * @param deleter Called with '_pointer' when the last reference is gone
+     */
+    template <class Deleter>
+    SharedPointer(T* _pointer, Deleter deleter): pointer(NULL), counter(NULL) {
+        UAllocTraits_t traits = {0};
+        void *mem = mbed_ualloc(sizeof(deleter_block<Deleter, PoolAllocator>), traits);
+        init_with_deleter<Deleter, PoolAllocator>(_pointer, deleter, NULL, mem);
+    }
 
-        CORE_UTIL_SHAREDPOINTER_DEBUG("SP: %p [%p: %p = %lu]\r\n", this, pointer, counter, *counter);
+    /**
+     * @brief Create new SharedPointer with a custom deleter and a pooled control block.
+     * @details If 'allocator' is empty, the object is released with 'deleter' and
+     *          the SharedPointer is empty.
+     * @param _pointer Pointer to take control over
+     * @param deleter Called with '_pointer' when the last reference is gone
+     * @param allocator PoolAllocator or ExtendablePoolAllocator for the control block,
+     *        with elements of at least get_control_block_size<Deleter>() bytes
+     */
+    template <class Deleter, class Allocator>
+    SharedPointer(T* _pointer, Deleter deleter, Allocator& allocator): pointer(NULL), counter(NULL) {
+        init_with_deleter<Deleter, Allocator>(_pointer, deleter, &allocator, allocator.alloc());
+    }
+
+    /**
+     * @brief Size of the control blocks used with a custom deleter.
+     * @details Use this as the element size of the allocator passed to
+     *          SharedPointer(pointer, deleter, allocator).
+     * @return Size in bytes of the control block.
+     */
+    template <class Deleter>
+    static size_t get_control_block_size() {
+        return sizeof(deleter_block<Deleter, PoolAllocator>);
+    }
+
+    /**
+     * @brief Size of the memory blocks used by allocate_shared().
+     * @details Use this as the element size of a PoolAllocator that is passed to allocate_shared().
+     * @return Size in bytes of the object plus its reference counter.
+     */
+    static size_t get_inplace_size() {
+        return sizeof(inplace_block);
     }
 
     /**
@@ -93,38 +290,69 @@ public:
     SharedPointer(const SharedPointer& source): pointer(source.pointer), counter(source.counter) {
         // increment reference counter
         if (counter) {
-            (*counter)++;
+            RefCount::increment(&counter->count);
         }
 
-        CORE_UTIL_SHAREDPOINTER_DEBUG("SP&: %p = %p [%p: %p = %lu]\r\n", this, &source, pointer, counter, *counter);
+        trace(SHAREDPOINTER_TRACE_COPY, use_count());
     }
 
     /**
      * @brief Assignment operator.
-     * @details Cleanup previous reference and assign new pointer and counter.
+     * @details Take a new reference to the object of 'source', then release the previous one.
+     *          'source' can be owned by the object being released (p = p->next).
      * @param source Object being assigned from.
      * @return Object being assigned.
      */
-    SharedPointer operator=(const SharedPointer& source) {
+    SharedPointer& operator=(const SharedPointer& source) {
         if (this != &source) {
-            // clean up by decrementing counter
-            decrementCounter();
+            SharedPointer(source).swap(*this);
 
-            // assign new values
-            pointer = source.get();
-            counter = source.getCounter();
+            trace(SHAREDPOINTER_TRACE_ASSIGN, use_count());
+        }
 
-            // increment new counter
-            if (counter) {
-                (*counter)++;
-            }
+        return *this;
+    }
 
-            CORE_UTIL_SHAREDPOINTER_DEBUG("SP=: %p = %p [%p: %p = %lu]\r\n", this, &source, pointer, counter, *counter);
-        }
+    /**
+     * @brief Move constructor.
+     * @details Take over the reference held by 'source' without touching the counter.
+     *          'source' is left empty.
+     * @param source Object being moved from.
+     */
+    SharedPointer(SharedPointer&& source): pointer(source.pointer), counter(source.counter) {
+        source.pointer = NULL;
+        source.counter = NULL;
 
+        trace(SHAREDPOINTER_TRACE_MOVE, 0);
+    }
+
+    /**
+     * @brief Move assignment operator.
+     * @details Take over the reference held by 'source' without touching its counter, then
+     *          release the previous reference. 'source' is left empty. 'source' can be owned
+     *          by the object being released (p = std::move(p->next)).
+     * @param source Object being moved from.
+     * @return Object being assigned.
+     */
+    SharedPointer& operator=(SharedPointer&& source) {
+        SharedPointer(std::move(source)).swap(*this);
         return *this;
     }
 
+    /**
+     * @brief Exchange the objects pointed to by two SharedPointers.
+     * @details The reference counters are not modified.
+     * @param other SharedPointer to swap with.
+     */
+    void swap(SharedPointer& other) {
+        T* temp_pointer = pointer;
+        SharedPointerControlBlock* temp_counter = counter;
+        pointer = other.pointer;
+        counter = other.counter;
+        other.pointer = temp_pointer;
+        other.counter = temp_counter;
+    }
+
     /**
      * @brief Raw pointer accessor.
      * @details Get raw pointer to object pointed to.
@@ -140,7 +368,7 @@ public:
      */
     uint32_t use_count() const {
         if (counter) {
-            return *counter;
+            return RefCount::load(&counter->count);
         } else {
             return 0;
         }
@@ -171,36 +399,186 @@ public:
      * @return Whether or not the pointer is NULL.
      */
     operator bool() const {
-        CORE_UTIL_SHAREDPOINTER_DEBUG("bool: %p\r\n", pointer);
-
         return (pointer != 0);
     }
 
 private:
+    friend class WeakPointer<T, RefCount>;
+
+    template <class U, class C, typename... Args>
+    friend SharedPointer<U, C> make_shared(Args&&... args);
+
+    template <class U, class C, typename... Args>
+    friend SharedPointer<U, C> allocate_shared(PoolAllocator& pool, Args&&... args);
+
+    /**
+     * @brief Reference counter allocated separately from the object.
+     */
+    struct separate_block : public SharedPointerControlBlock {
+        separate_block(T* _pointer):
+            SharedPointerControlBlock(&separate_block::dispose_object, &separate_block::destroy_block), pointer(_pointer) {
+        }
+
+        static void dispose_object(SharedPointerControlBlock *block) {
+            delete static_cast<separate_block*>(block)->pointer;
+        }
+
+        static void destroy_block(SharedPointerControlBlock *block) {
+            separate_block *self = static_cast<separate_block*>(block);
+            self->~separate_block();
+            mbed_ufree(self);
+        }
+
+        T* pointer;
+    };
+
+    /**
+     * @brief Reference counter with a custom deleter, allocated from 'allocator' or
+     *        from the heap if 'allocator' is NULL.
+     */
+    template <class Deleter, class Allocator>
+    struct deleter_block : public SharedPointerControlBlock {
+        deleter_block(T* _pointer, const Deleter& _deleter, Allocator *_allocator):
+            SharedPointerControlBlock(&deleter_block::dispose_object, &deleter_block::destroy_block),
+            pointer(_pointer), deleter(_deleter), allocator(_allocator) {
+        }
+
+        static void dispose_object(SharedPointerControlBlock *block) {
+            deleter_block *self = static_cast<deleter_block*>(block);
+            self->deleter(self->pointer);
+        }
+
+        static void destroy_block(SharedPointerControlBlock *block) {
+            deleter_block *self = static_cast<deleter_block*>(block);
+            Allocator *allocator = self->allocator;
+            self->~deleter_block();
+            if (allocator) {
+                allocator->free(self);
+            } else {
+                mbed_ufree(self);
+            }
+        }
+
+        T* pointer;
+        Deleter deleter;
+        Allocator *allocator;
+    };
+
+    /**
+     * @brief Reference counter and object in the same memory block.
+     */
+    struct inplace_block : public SharedPointerControlBlock {
+        inplace_block(PoolAllocator *_pool):
+            SharedPointerControlBlock(&inplace_block::dispose_object, &inplace_block::destroy_block), pool(_pool) {
+        }
+
+        static void dispose_object(SharedPointerControlBlock *block) {
+            static_cast<inplace_block*>(block)->get_object()->~T();
+        }
+
+        static void destroy_block(SharedPointerControlBlock *block) {
+            inplace_block *self = static_cast<inplace_block*>(block);
+            PoolAllocator *pool = self->pool;
+            self->~inplace_block();
+            if (pool) {
+                pool->free(self);
+            } else {
+                mbed_ufree(self);
+            }
+        }
+
+        T* get_object() {
+            return reinterpret_cast<T*>(&storage);
+        }
+
+        PoolAllocator *pool;
+        typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+    };
+
+    /**
+     * @brief Construct the object and its reference counter in a single memory block.
+     * @param mem Memory block of at least sizeof(inplace_block) bytes, or NULL.
+     * @param pool Pool that owns 'mem', or NULL if 'mem' was allocated with mbed_ualloc.
+     * @return SharedPointer to the new object, or an empty SharedPointer if 'mem' is NULL.
+     */
+    template <typename... Args>
+    static SharedPointer create_inplace(void *mem, PoolAllocator *pool, Args&&... args) {
+        SharedPointer res;
+        if (mem != NULL) {
+            inplace_block *block = new(mem) inplace_block(pool);
+            new(block->get_object()) T(std::forward<Args>(args)...);
+            res.pointer = block->get_object();
+            res.counter = block;
+            res.trace(SHAREDPOINTER_TRACE_CREATE, 1);
+        }
+        return res;
+    }
+
+    /**
+     * @brief Take control over '_pointer' using a control block with a custom deleter.
+     * @param mem Memory for the control block, or NULL if the allocation failed.
+     */
+    template <class Deleter, class Allocator>
+    void init_with_deleter(T* _pointer, const Deleter& deleter, Allocator *allocator, void *mem) {
+        if (mem == NULL) {
+            // nobody else can release the object
+            if (_pointer) {
+                Deleter release = deleter;
+                release(_pointer);
+            }
+        } else {
+            pointer = _pointer;
+            counter = new(mem) deleter_block<Deleter, Allocator>(_pointer, deleter, allocator);
+            trace(SHAREDPOINTER_TRACE_CREATE, 1);
+        }
+    }
+
+    /**
+     * @brief Record an event in the SharedPointerTrace buffer if tracing is enabled for T.
+     * @details Resolved at compile time, so it costs nothing when tracing is disabled.
+     */
+    void trace(SharedPointerTraceEvent event, uint32_t count) const {
+        trace(event, count, std::integral_constant<bool, SharedPointerTraceEnabled<T>::value>());
+    }
+
+    void trace(SharedPointerTraceEvent event, uint32_t count, std::true_type) const {
+        SharedPointerTrace::record(event, this, pointer, count);
+    }
+
+    void trace(SharedPointerTraceEvent, uint32_t, std::false_type) const {
+    }
+
     /**
      * @brief Get pointer to reference counter.
      * @return Pointer to reference counter.
      */
-    uint32_t* getCounter() const {
+    SharedPointerControlBlock* getCounter() const {
         return counter;
     }
 
+    /**
+     * @brief Create a SharedPointer that shares an already counted reference.
+     * @details Used by WeakPointer::lock() after incrementing the counter.
+     */
+    SharedPointer(T* _pointer, SharedPointerControlBlock* _counter): pointer(_pointer), counter(_counter) {
+    }
+
     /**
      * @brief Decrement reference counter.
-     * @details If count reaches zero, free counter and delete object pointed to.
+     * @details If count reaches zero, delete object pointed to, then free the counter
+     *          if there are no WeakPointers left.
      */
     void decrementCounter() {
         if (counter) {
-            if (*counter == 1) {
-                mbed_ufree(counter);
-                delete pointer;
-
-                CORE_UTIL_SHAREDPOINTER_DEBUG("~SP: %p [%p: %p = 0]\r\n", this, pointer, counter);
-            } else {
-                (*counter)--;
-
-                CORE_UTIL_SHAREDPOINTER_DEBUG("~SP: %p [%p: %p = %lu]\r\n", this, pointer, counter, *counter);
+            uint32_t count = RefCount::decrement(&counter->count);
+            if (count == 0) {
+                counter->dispose(counter);
+                if (RefCount::decrement(&counter->weak_count) == 0) {
+                    counter->destroy(counter);
+                }
             }
+
+            trace(SHAREDPOINTER_TRACE_RELEASE, count);
         }
     }
 
@@ -209,40 +587,69 @@ private:
     T* pointer;
 
     // pointer to shared reference counter
-    uint32_t* counter;
+    SharedPointerControlBlock* counter;
 };
 
+/** Create an object and a SharedPointer to it, using a single allocation for both the
+  * object and the reference counter.
+  *
+  * Usage: SharedPointer<class> POINTER = make_shared<class>(constructor arguments)
+  *
+  * @param args Arguments forwarded to the constructor of T.
+  * @return SharedPointer to the new object, or an empty SharedPointer if out of memory.
+  */
+template <class T, class RefCount, typename... Args>
+SharedPointer<T, RefCount> make_shared(Args&&... args) {
+    UAllocTraits_t traits = {0};
+    void *mem = mbed_ualloc(SharedPointer<T, RefCount>::get_inplace_size(), traits);
+    return SharedPointer<T, RefCount>::create_inplace(mem, NULL, std::forward<Args>(args)...);
+}
+
+/** Create an object and a SharedPointer to it in a single element allocated from a
+  * PoolAllocator. The element is returned to the pool when the object is destroyed.
+  *
+  * The element size of the pool must be at least SharedPointer<T>::get_inplace_size().
+  *
+  * @param pool The pool used for the allocation.
+  * @param args Arguments forwarded to the constructor of T.
+  * @return SharedPointer to the new object, or an empty SharedPointer if the pool is empty.
+  */
+template <class T, class RefCount, typename... Args>
+SharedPointer<T, RefCount> allocate_shared(PoolAllocator& pool, Args&&... args) {
+    return SharedPointer<T, RefCount>::create_inplace(pool.alloc(), &pool, std::forward<Args>(args)...);
+}
+
 /** Non-member relational operators.
   */
-template <class T, class U>
-bool operator== (const SharedPointer<T>& lhs, const SharedPointer<U>& rhs) {
+template <class T, class C, class U, class D>
+bool operator== (const SharedPointer<T, C>& lhs, const SharedPointer<U, D>& rhs) {
     return (lhs.get() == rhs.get());
 }
 
-template <class T, typename U>
-bool operator== (const SharedPointer<T>& lhs, U rhs) {
+template <class T, class C, typename U>
+bool operator== (const SharedPointer<T, C>& lhs, U rhs) {
     return (lhs.get() == (T*) rhs);
 }
 
-template <class T, typename U>
-bool operator== (U lhs, const SharedPointer<T>& rhs) {
+template <class T, class C, typename U>
+bool operator== (U lhs, const SharedPointer<T, C>& rhs) {
     return ((T*) lhs == rhs.get());
 }
 
 /** Non-member relational operators.
   */
-template <class T, class U>
-bool operator!= (const SharedPointer<T>& lhs, const SharedPointer<U>& rhs) {
+template <class T, class C, class U, class D>
+bool operator!= (const SharedPointer<T, C>& lhs, const SharedPointer<U, D>& rhs) {
     return (lhs.get() != rhs.get());
 }
 
-template <class T, typename U>
-bool operator!= (const SharedPointer<T>& lhs, U rhs) {
+template <class T, class C, typename U>
+bool operator!= (const SharedPointer<T, C>& lhs, U rhs) {
     return (lhs.get() != (T*) rhs);
 }
 
-template <class T, typename U>
-bool operator!= (U lhs, const SharedPointer<T>& rhs) {
+template <class T, class C, typename U>
+bool operator!= (U lhs, const SharedPointer<T, C>& rhs) {
     return ((T*) lhs != rhs.get());
 }
 
@@ -0,0 +1,153 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CORE_UTIL_SHAREDPOINTERTRACE_H__
+#define __CORE_UTIL_SHAREDPOINTERTRACE_H__
+
+#include "core-util/atomic_ops.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef YOTTA_CFG_UTIL_SHAREDPOINTER_TRACE_SIZE
+#define CORE_UTIL_SHAREDPOINTER_TRACE_SIZE YOTTA_CFG_UTIL_SHAREDPOINTER_TRACE_SIZE
+#else
+#define CORE_UTIL_SHAREDPOINTER_TRACE_SIZE 64
+#endif
+
+/** Enable tracing of the SharedPointers to objects of type TYPE.
+  * Must be used at global scope in the header that declares TYPE, right after the declaration.
+  * Every translation unit that uses SharedPointer<TYPE> must see it: a translation unit
+  * that doesn't would instantiate different SharedPointer<TYPE> members, which violates the
+  * one definition rule.
+  */
+#define CORE_UTIL_SHAREDPOINTER_ENABLE_TRACE(TYPE)          \
+    namespace mbed {                                        \
+    namespace util {                                        \
+    template <>                                             \
+    struct SharedPointerTraceEnabled<TYPE> {                \
+        static const bool value = true;                     \
+    };                                                      \
+    }                                                       \
+    }
+
+namespace mbed {
+namespace util {
+
+/** Selects the types whose SharedPointers are traced. Tracing is off for all types by
+  * default, and then it costs nothing. Enable it for a type with
+  * CORE_UTIL_SHAREDPOINTER_ENABLE_TRACE(type).
+  */
+template <class T>
+struct SharedPointerTraceEnabled {
+    static const bool value = false;
+};
+
+enum SharedPointerTraceEvent {
+    SHAREDPOINTER_TRACE_CREATE,     // new reference counter
+    SHAREDPOINTER_TRACE_COPY,       // copy construction
+    SHAREDPOINTER_TRACE_ASSIGN,     // copy assignment
+    SHAREDPOINTER_TRACE_MOVE,       // move construction or assignment
+    SHAREDPOINTER_TRACE_RELEASE     // reference dropped
+};
+
+/** One entry in the trace buffer.
+  */
+struct SharedPointerTraceRecord {
+    // address of the SharedPointer
+    const void *shared_pointer;
+    // object pointed to
+    const void *object;
+    // reference count after the operation (0 for moves, which don't change it)
+    uint32_t count;
+    // SharedPointerTraceEvent
+    uint8_t event;
+};
+
+/** Ring buffer of SharedPointer trace records.
+  *
+  * Recording an event stores a few words in the buffer, without formatting or I/O, so
+  * it can be left on in load tests. When the buffer is full the oldest records are
+  * overwritten. The size of the buffer (in records, a power of two) can be set with
+  * yotta config: "util": {"sharedPointer": {"trace-size": <records>}}. The buffer is
+  * only allocated if tracing is enabled for at least one type.
+  */
+class SharedPointerTrace {
+    // the index of the next record wraps around at 2^32, which must also be a multiple of the size
+    static_assert((CORE_UTIL_SHAREDPOINTER_TRACE_SIZE > 0) &&
+                  ((CORE_UTIL_SHAREDPOINTER_TRACE_SIZE & (CORE_UTIL_SHAREDPOINTER_TRACE_SIZE - 1)) == 0),
+                  "The SharedPointer trace size must be a power of two");
+
+public:
+    static void record(SharedPointerTraceEvent event, const void *shared_pointer, const void *object, uint32_t count) {
+        buffer& b = get_buffer();
+        uint32_t index = atomic_incr(&b.next, (uint32_t)1) - 1;
+        SharedPointerTraceRecord& r = b.records[index % CORE_UTIL_SHAREDPOINTER_TRACE_SIZE];
+        r.shared_pointer = shared_pointer;
+        r.object = object;
+        r.count = count;
+        r.event = (uint8_t)event;
+    }
+
+    /**
+     * @return Number of records that can be read with get_record().
+     */
+    static uint32_t get_num_records() {
+        uint32_t next = atomic_load(&get_buffer().next, atomic_relaxed);
+        return next < CORE_UTIL_SHAREDPOINTER_TRACE_SIZE ? next : CORE_UTIL_SHAREDPOINTER_TRACE_SIZE;
+    }
+
+    /**
+     * @brief Read a record, starting with the oldest one still in the buffer.
+     * @param n Index of the record, less than get_num_records().
+     * @param r Receives the record.
+     * @return true if the record exists, false otherwise.
+     */
+    static bool get_record(uint32_t n, SharedPointerTraceRecord& r) {
+        buffer& b = get_buffer();
+        uint32_t available = get_num_records();
+        if (n >= available) {
+            return false;
+        }
+        r = b.records[(atomic_load(&b.next, atomic_relaxed) - available + n) % CORE_UTIL_SHAREDPOINTER_TRACE_SIZE];
+        return true;
+    }
+
+    /**
+     * @brief Discard all the records.
+     */
+    static void clear() {
+        atomic_store(&get_buffer().next, (uint32_t)0, atomic_relaxed);
+    }
+
+private:
+    struct buffer {
+        SharedPointerTraceRecord records[CORE_UTIL_SHAREDPOINTER_TRACE_SIZE];
+        uint32_t next;
+    };
+
+    static buffer& get_buffer() {
+        // zero initialized, no construction needed
+        static buffer b;
+        return b;
+    }
+};
+
+} // namespace util
+} // namespace mbed
+
+#endif // __CORE_UTIL_SHAREDPOINTERTRACE_H__
@@ -0,0 +1,90 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MBED_UTIL_SPIN_LOCK_H__
+#define __MBED_UTIL_SPIN_LOCK_H__
+
+#include <stdint.h>
+#include "core-util/atomic_ops.h"
+
+namespace mbed {
+namespace util {
+
+/** A simple test-and-set spin lock built on the atomic operations in atomic_ops.h.
+  *
+  * Unlike CriticalSectionLock, a SpinLock only excludes the other users of the same
+  * SpinLock instance, so independent data structures can be accessed in parallel.
+  * It must not be used from interrupt context to protect data that is also accessed
+  * from thread context with interrupts enabled, since the interrupt handler would spin
+  * forever waiting for the interrupted code to release the lock.
+  *
+  * Usage:
+  * @code
+  *
+  * SpinLock l;
+  *
+  * void f() {
+  *     l.lock();
+  *     // only one thread at a time runs here
+  *     l.unlock();
+  * }
+  * @endcode
+  */
+class SpinLock {
+public:
+    SpinLock(): _locked(0) {
+    }
+
+    /* Forbid copy and assignment */
+    SpinLock(const SpinLock&) = delete;
+    SpinLock(SpinLock&&) = delete;
+    SpinLock& operator =(const SpinLock&) = delete;
+    SpinLock& operator =(SpinLock&&) = delete;
+
+    /** Try to acquire the lock without waiting
+      * @returns true if the lock was acquired, false if it is held by someone else
+      */
+    bool try_lock() {
+        // acquire: the accesses protected by the lock can't move before it
+        return atomic_exchange(&_locked, (uint32_t)1, atomic_acquire) == 0;
+    }
+
+    /** Acquire the lock, waiting for it to become free if needed
+      */
+    void lock() {
+        while (!try_lock()) {
+            // Spin on a relaxed load so that waiters don't keep the location busy
+            while (atomic_load(&_locked, atomic_relaxed) != 0) {
+            }
+        }
+    }
+
+    /** Release the lock
+      */
+    void unlock() {
+        // release: the accesses protected by the lock can't move after it
+        atomic_store(&_locked, (uint32_t)0, atomic_release);
+    }
+
+private:
+    uint32_t _locked;
+};
+
+} // namespace util
+} // namespace mbed
+
+#endif // #ifndef __MBED_UTIL_SPIN_LOCK_H__
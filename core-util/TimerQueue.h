@@ -0,0 +1,203 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MBED_UTIL_TIMER_QUEUE_H__
+#define __MBED_UTIL_TIMER_QUEUE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core-util/Event.h"
+#include "core-util/IndexedBinaryHeap.h"
+#include "core-util/PoolAllocator.h"
+#include "ualloc/ualloc.h"
+
+namespace mbed {
+namespace util {
+
+/** A scheduler for Events that must be called at a given time.
+  *
+  * post_at() and post_in() copy or move the Event into a node allocated from a PoolAllocator
+  * and insert a small (deadline, node) entry in an IndexedBinaryHeap, so the Events themselves
+  * are never copied while the heap is reshaped. They return a handle that can be used to
+  * cancel the timer in O(log n). Handles of timers that were already dispatched or cancelled
+  * are detected and rejected, like the handles of IndexedBinaryHeap.
+  *
+  * The time is an unsigned 32 bit tick count supplied by the caller, which wraps around:
+  * all the pending deadlines must be less than 2^31 ticks away from the current time.
+  * dispatch() advances the current time and calls all the expired timers in deadline order
+  * (timers with the same deadline are called in the order they were posted). The expired
+  * timers are removed from the heap as one batch before being called, so a timer posted
+  * or cancelled by a dispatched Event doesn't affect the current batch.
+  *
+  * All the operations except dispatch() can be called from interrupt handlers, as long as
+  * the heap doesn't need to grow (see init()). Only one thread can call dispatch().
+  *
+  * Usage:
+  * @code
+  * TimerQueue timers(pool);
+  * timers.init(16, 16, traits);
+  *
+  * TimerQueue::Handle h = timers.post_in(FunctionPointer0<void>(timeout).bind(), 100);
+  * ...
+  * timers.cancel(h);
+  * ...
+  * // in the main loop
+  * timers.dispatch(get_ticks());
+  * @endcode
+  */
+class TimerQueue {
+private:
+    struct node;
+
+    struct entry {
+        uint32_t deadline;
+        uint32_t sequence;
+        node *n;
+    };
+
+    // Orders the entries by deadline, then by posting order, allowing for wraparound
+    struct entry_compare {
+        bool operator ()(const entry& e1, const entry& e2) const {
+            int32_t diff = (int32_t)(e1.deadline - e2.deadline);
+            if (diff != 0)
+                return diff < 0;
+            return (int32_t)(e1.sequence - e2.sequence) <= 0;
+        }
+    };
+
+    typedef IndexedBinaryHeap<entry, entry_compare> heap_t;
+
+public:
+    /** Reference to a pending timer, returned by post_at() and post_in()
+      */
+    typedef heap_t::Handle Handle;
+
+    /** Create a new timer queue
+      * @param allocator pool for the timer nodes, with elements of at least get_node_size()
+      *        bytes. The queue holds at most as many timers as the pool has elements.
+      */
+    TimerQueue(PoolAllocator& allocator);
+
+    /* Forbid copy and assignment */
+    TimerQueue(const TimerQueue&) = delete;
+    TimerQueue(TimerQueue&&) = delete;
+    TimerQueue& operator =(const TimerQueue&) = delete;
+    TimerQueue& operator =(TimerQueue&&) = delete;
+
+    /** Destructor. The pending timers are destroyed without being called
+      */
+    ~TimerQueue();
+
+    /** Initialize the queue
+      * @param initial_capacity initial capacity of the heap. Posting more timers than this
+      *        grows the heap with mbed_ualloc, which can't be done from interrupt handlers.
+      *        Each new zone also makes every heap access slower (see IndexedBinaryHeap::init()),
+      *        so this should be the expected number of pending timers.
+      * @param grow_capacity number of elements to add when the heap's capacity is exceeded
+      * @param alloc_traits allocator traits (for mbed_ualloc)
+      * @returns true if the initialization succeeded, false otherwise
+      */
+    bool init(size_t initial_capacity, size_t grow_capacity, UAllocTraits_t alloc_traits);
+
+    /** Schedule a copy of an event at an absolute time
+      * @param e the event
+      * @param deadline the time when the event must be called
+      * @returns a valid handle for success, an invalid handle if the pool or the heap is
+      *          exhausted or 'e' is empty
+      */
+    Handle post_at(const Event& e, uint32_t deadline);
+
+    /** Move an event into the queue, scheduling it at an absolute time.
+      * 'e' is left empty if the event was scheduled, and unchanged otherwise.
+      * @param e the event
+      * @param deadline the time when the event must be called
+      * @returns a valid handle for success, an invalid handle if the pool or the heap is
+      *          exhausted or 'e' is empty
+      */
+    Handle post_at(Event&& e, uint32_t deadline);
+
+    /** Schedule a copy of an event relative to the current time (the time of the last dispatch())
+      * @param e the event
+      * @param delay the number of ticks to wait
+      * @returns a valid handle for success, an invalid handle for failure
+      */
+    Handle post_in(const Event& e, uint32_t delay);
+
+    /** Move an event into the queue, scheduling it relative to the current time
+      * 'e' is left empty if the event was scheduled, and unchanged otherwise.
+      * @param e the event
+      * @param delay the number of ticks to wait
+      * @returns a valid handle for success, an invalid handle for failure
+      */
+    Handle post_in(Event&& e, uint32_t delay);
+
+    /** Cancel a pending timer. Its event is destroyed without being called
+      * @param h handle of the timer
+      * @returns true if the timer was cancelled, false if the handle is invalid or the timer
+      *          was already dispatched or cancelled
+      */
+    bool cancel(const Handle& h);
+
+    /** Checks if a timer is still pending
+      * @param h handle of the timer
+      * @returns true if the timer is waiting to be dispatched, false otherwise
+      */
+    bool is_pending(const Handle& h) const;
+
+    /** Set the current time and call the expired timers
+      * @param now the current time
+      * @param max_events maximum number of events to call. The other expired timers are
+      *        called by the next dispatch().
+      * @returns the number of events called
+      */
+    size_t dispatch(uint32_t now, size_t max_events = SIZE_MAX);
+
+    /** Returns the deadline of the first pending timer
+      * @param deadline will be set to the deadline of the first timer
+      * @returns true if there is a pending timer, false otherwise
+      */
+    bool get_next_deadline(uint32_t& deadline) const;
+
+    /** Returns the current time
+      * @returns the time given to the last dispatch()
+      */
+    uint32_t get_time() const;
+
+    /** Returns the number of pending timers
+      * @returns number of pending timers
+      */
+    size_t get_num_pending() const;
+
+    /** Returns the element size needed in the pool given to the constructor
+      * @returns size of a timer node in bytes
+      */
+    static size_t get_node_size();
+
+private:
+    Handle _insert(node *n, uint32_t deadline);
+    void _free(node *n);
+
+    PoolAllocator& _allocator;
+    heap_t _heap;
+    uint32_t _now;
+    uint32_t _sequence;
+};
+
+} // namespace util
+} // namespace mbed
+
+#endif // #ifndef __MBED_UTIL_TIMER_QUEUE_H__
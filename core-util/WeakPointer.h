@@ -0,0 +1,214 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CORE_UTIL_WEAKPOINTER_H__
+#define __CORE_UTIL_WEAKPOINTER_H__
+
+#include "core-util/SharedPointer.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace mbed {
+namespace util {
+
+/** Weak pointer class.
+  *
+  * A WeakPointer refers to an object owned by SharedPointers without keeping it alive.
+  * It is used to break reference loops and for caches and observer lists that must not
+  * pin the objects they refer to.
+  *
+  * The object can't be accessed directly through a WeakPointer: lock() returns a
+  * SharedPointer to the object if it still exists, or an empty SharedPointer if the
+  * last SharedPointer to it is already gone.
+  *
+  * The reference counters are kept alive until the last WeakPointer is destroyed. For objects
+  * created with make_shared() or allocate_shared() this means that the memory of the object
+  * (but not the object itself) stays allocated as long as there are WeakPointers to it.
+  *
+  * Usage:
+  * @code
+  * SharedPointer<Cache> cache = make_shared<Cache>();
+  * WeakPointer<Cache> observer(cache);
+  *
+  * SharedPointer<Cache> locked = observer.lock();
+  * if (locked) {
+  *     // the object is alive and can't be destroyed while 'locked' exists
+  * }
+  * @endcode
+  *
+  * The RefCount policy must match the one of the SharedPointers.
+  */
+template <class T, class RefCount>
+class WeakPointer {
+public:
+    /**
+     * @brief Create empty WeakPointer not pointing to anything.
+     */
+    WeakPointer(): pointer(NULL), counter(NULL) {
+    }
+
+    /**
+     * @brief Create a WeakPointer to the object owned by a SharedPointer.
+     * @param source SharedPointer that owns the object.
+     */
+    WeakPointer(const SharedPointer<T, RefCount>& source): pointer(source.pointer), counter(source.counter) {
+        incrementWeakCounter();
+    }
+
+    /**
+     * @brief Copy constructor.
+     * @param source Object being copied from.
+     */
+    WeakPointer(const WeakPointer& source): pointer(source.pointer), counter(source.counter) {
+        incrementWeakCounter();
+    }
+
+    /**
+     * @brief Move constructor.
+     * @details 'source' is left empty.
+     * @param source Object being moved from.
+     */
+    WeakPointer(WeakPointer&& source): pointer(source.pointer), counter(source.counter) {
+        source.pointer = NULL;
+        source.counter = NULL;
+    }
+
+    /**
+     * @brief Destructor.
+     * @details Free the reference counters if this is the last reference to them.
+     */
+    ~WeakPointer() {
+        decrementWeakCounter();
+    }
+
+    /**
+     * @brief Assignment operator.
+     * @param source Object being assigned from.
+     * @return Object being assigned.
+     */
+    WeakPointer& operator=(const WeakPointer& source) {
+        if (this != &source) {
+            decrementWeakCounter();
+            pointer = source.pointer;
+            counter = source.counter;
+            incrementWeakCounter();
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief Move assignment operator.
+     * @details 'source' is left empty.
+     * @param source Object being moved from.
+     * @return Object being assigned.
+     */
+    WeakPointer& operator=(WeakPointer&& source) {
+        if (this != &source) {
+            decrementWeakCounter();
+            pointer = source.pointer;
+            counter = source.counter;
+            source.pointer = NULL;
+            source.counter = NULL;
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief Assignment from SharedPointer.
+     * @param source SharedPointer that owns the object.
+     * @return Object being assigned.
+     */
+    WeakPointer& operator=(const SharedPointer<T, RefCount>& source) {
+        decrementWeakCounter();
+        pointer = source.pointer;
+        counter = source.counter;
+        incrementWeakCounter();
+
+        return *this;
+    }
+
+    /**
+     * @brief Get a SharedPointer to the object.
+     * @return SharedPointer to the object, or an empty SharedPointer if the object
+     *         was already destroyed.
+     */
+    SharedPointer<T, RefCount> lock() const {
+        if (counter && RefCount::increment_if_not_zero(&counter->count)) {
+            return SharedPointer<T, RefCount>(pointer, counter);
+        }
+
+        return SharedPointer<T, RefCount>();
+    }
+
+    /**
+     * @brief Check whether the object was destroyed.
+     * @return true if there are no SharedPointers to the object left (or this WeakPointer is empty).
+     */
+    bool expired() const {
+        return use_count() == 0;
+    }
+
+    /**
+     * @brief Reference count accessor.
+     * @return Number of SharedPointers to the object.
+     */
+    uint32_t use_count() const {
+        if (counter) {
+            return RefCount::load(&counter->count);
+        } else {
+            return 0;
+        }
+    }
+
+    /**
+     * @brief Release the reference and make this WeakPointer empty.
+     */
+    void reset() {
+        decrementWeakCounter();
+        pointer = NULL;
+        counter = NULL;
+    }
+
+private:
+    void incrementWeakCounter() {
+        if (counter) {
+            RefCount::increment(&counter->weak_count);
+        }
+    }
+
+    void decrementWeakCounter() {
+        if (counter) {
+            if (RefCount::decrement(&counter->weak_count) == 0) {
+                counter->destroy(counter);
+            }
+        }
+    }
+
+    // pointer to shared object
+    T* pointer;
+
+    // pointer to shared reference counters
+    SharedPointerControlBlock* counter;
+};
+
+} // namespace util
+} // namespace mbed
+
+#endif // __CORE_UTIL_WEAKPOINTER_H__
@@ -0,0 +1,194 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MBED_UTIL_WORK_STEALING_DEQUE_H__
+#define __MBED_UTIL_WORK_STEALING_DEQUE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include "core-util/atomic_ops.h"
+#include "ualloc/ualloc.h"
+
+/** A fixed capacity work-stealing deque (Chase-Lev).
+  *
+  * The deque has a single owner, which pushes and pops elements at the bottom (in LIFO order)
+  * without contention. Any number of thieves can steal elements from the top (in FIFO order)
+  * at the same time. Thieves only compete with each other (and with the owner, for the last
+  * element) through atomic_cas on the top index. The memory orders follow the C11 version
+  * of the algorithm by Le, Pop, Cohen and Zappa Nardelli, with sequentially consistent
+  * accesses where it uses a fence.
+  *
+  * The elements are copied with relaxed atomic_load and atomic_store, because a thief can
+  * read an element that the owner overwrites once the thief lost the race for it. T must be
+  * trivially copyable, and should be a type for which atomic_is_native is true, like a
+  * pointer to a task; other types are copied in a CriticalSectionLock.
+  * The capacity is fixed by init(); push() fails when the deque is full.
+  *
+  * Usage example:
+  *
+  * @code
+  * #include "core-util/WorkStealingDeque.h"
+  *
+  * WorkStealingDeque<Task*> deque;
+  *
+  * void owner() {
+  *     Task *t;
+  *     deque.push(new_task);
+  *     if (deque.pop(t))
+  *         t->run();
+  * }
+  *
+  * void thief() {
+  *     Task *t;
+  *     if (deque.steal(t))
+  *         t->run();
+  * }
+  * @endcode
+  */
+namespace mbed {
+namespace util {
+
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque elements must be trivially copyable");
+
+public:
+    /** Construct a new deque
+      */
+    WorkStealingDeque(): _elements(NULL), _mask(0), _top(0), _bottom(0) {
+    }
+
+    /* Forbid copy and assignment */
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque(WorkStealingDeque&&) = delete;
+    WorkStealingDeque& operator =(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator =(WorkStealingDeque&&) = delete;
+
+    /** Destructor. It frees the element storage
+      */
+    ~WorkStealingDeque() {
+        if (_elements != NULL)
+            mbed_ufree(_elements);
+    }
+
+    /** Initialize the deque
+      * @param capacity maximum number of elements (must be a power of 2)
+      * @param alloc_traits allocator traits (for mbed_ualloc)
+      * @returns true if the initialization succeeded, false otherwise
+      */
+    bool init(size_t capacity, UAllocTraits_t alloc_traits) {
+        if ((_elements != NULL) || (capacity == 0) || ((capacity & (capacity - 1)) != 0))
+            return false; // prevent repeated initialization
+        _elements = (T*)mbed_ualloc(capacity * sizeof(T), alloc_traits);
+        if (_elements == NULL)
+            return false;
+        _mask = capacity - 1;
+        return true;
+    }
+
+    /** Add an element at the bottom of the deque. Must only be called by the owner.
+      * @param e the element
+      * @returns true for success, false if the deque is full
+      */
+    bool push(const T& e) {
+        uint32_t b = atomic_load(&_bottom, atomic_relaxed);
+        uint32_t t = atomic_load(&_top, atomic_acquire);
+        if ((int32_t)(b - t) > (int32_t)_mask)
+            return false;
+        atomic_store(&_elements[b & _mask], e, atomic_relaxed);
+        // Publish the element with the new bottom
+        atomic_store(&_bottom, b + 1, atomic_release);
+        return true;
+    }
+
+    /** Remove the element at the bottom of the deque (the last one pushed).
+      * Must only be called by the owner.
+      * @param e will be set to the removed element
+      * @returns true if an element was removed, false if the deque is empty
+      */
+    bool pop(T& e) {
+        uint32_t b = atomic_load(&_bottom, atomic_relaxed) - 1;
+        // Claim the bottom element before looking at the top, so a thief can't take it unseen.
+        // Both accesses are sequentially consistent, so they can't be reordered.
+        atomic_store(&_bottom, b, atomic_seq_cst);
+        uint32_t t = atomic_load(&_top, atomic_seq_cst);
+        int32_t size = (int32_t)(b - t);
+        if (size < 0) {
+            atomic_store(&_bottom, b + 1, atomic_relaxed);
+            return false;
+        }
+        e = atomic_load(&_elements[b & _mask], atomic_relaxed);
+        if (size > 0)
+            return true;
+        // Last element: race with the thieves for it
+        bool won = atomic_cas(&_top, &t, t + 1);
+        atomic_store(&_bottom, b + 1, atomic_relaxed);
+        return won;
+    }
+
+    /** Remove the element at the top of the deque (the oldest one).
+      * Can be called by any thread, including the owner.
+      * @param e will be set to the removed element
+      * @returns true if an element was removed, false if the deque is empty or another
+      *          thread took the element first
+      */
+    bool steal(T& e) {
+        // Read the top before the bottom, pairing with the accesses in pop()
+        uint32_t t = atomic_load(&_top, atomic_seq_cst);
+        uint32_t b = atomic_load(&_bottom, atomic_seq_cst);
+        if ((int32_t)(b - t) <= 0)
+            return false;
+        e = atomic_load(&_elements[t & _mask], atomic_relaxed);
+        return atomic_cas(&_top, &t, t + 1);
+    }
+
+    /** Checks if the deque is empty
+      * The result is only a snapshot if other threads are using the deque at the same time.
+      * @returns true if the deque is empty, false otherwise
+      */
+    bool is_empty() const {
+        return get_num_elements() == 0;
+    }
+
+    /** Returns the number of elements in the deque
+      * The result is only a snapshot if other threads are using the deque at the same time.
+      * @returns number of elements in the deque
+      */
+    size_t get_num_elements() const {
+        int32_t size = (int32_t)(atomic_load(&_bottom, atomic_relaxed) - atomic_load(&_top, atomic_relaxed));
+        return size > 0 ? size : 0;
+    }
+
+    /** Returns the capacity of the deque
+      * @returns maximum number of elements
+      */
+    size_t get_capacity() const {
+        return _elements == NULL ? 0 : _mask + 1;
+    }
+
+private:
+    T *_elements;
+    uint32_t _mask;
+    uint32_t _top;
+    uint32_t _bottom;
+};
+
+} // namespace util
+} // namespace mbed
+
+#endif // #ifndef __MBED_UTIL_WORK_STEALING_DEQUE_H__
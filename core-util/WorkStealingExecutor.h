@@ -0,0 +1,171 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MBED_UTIL_WORK_STEALING_EXECUTOR_H__
+#define __MBED_UTIL_WORK_STEALING_EXECUTOR_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core-util/Event.h"
+#include "core-util/FunctionPointer.h"
+#include "core-util/PoolAllocator.h"
+#include "core-util/WorkStealingDeque.h"
+#include "ualloc/ualloc.h"
+
+namespace mbed {
+namespace util {
+
+/** Runs Events on a number of workers that balance the load by stealing work from each other.
+  *
+  * core-util doesn't create threads: the platform starts one thread (or core) per worker,
+  * and each of them calls run_one() with its own worker index in a loop. Each Event is copied
+  * or moved into a task node from a PoolAllocator. Every worker owns a WorkStealingDeque of
+  * tasks: the Events it posts with post(worker, e) go to its own deque and are run in LIFO
+  * order, which keeps fork-join work local. Events posted from anywhere else with post(e)
+  * (including interrupt handlers) go to a global lock-free overflow list, which is also used
+  * when a worker's deque is full.
+  *
+  * run_one() runs a task from the worker's own deque; if it is empty, it takes the whole
+  * overflow list, keeping the tasks it can fit in its deque (where other workers can steal
+  * them) and the rest in a private list that it empties before taking the overflow list
+  * again, and otherwise it tries to steal the oldest task of another worker. When run_one()
+  * returns false the worker can park until the wakeup handler is called by the next post().
+  *
+  * The executor doesn't keep track of the parked workers: every post() calls the wakeup
+  * handler once, whether a worker is parked or not, and an Event can be posted between a
+  * failed run_one() and the moment the worker parks. The handler must therefore remember its
+  * calls, like releasing a counting semaphore that the workers wait on. A flag or a
+  * condition variable signalled without a predicate would lose that wakeup and leave the
+  * Event pending until the next post(). Extra wakeups are harmless: the worker calls
+  * run_one() again and parks when it returns false.
+  *
+  * Usage:
+  * @code
+  * // the wakeup handler releases 'work_available', a counting semaphore
+  * // in each worker thread
+  * while (true) {
+  *     if (!executor.run_one(my_index))
+  *         work_available.wait();
+  * }
+  * @endcode
+  */
+class WorkStealingExecutor {
+public:
+    /** Create a new executor
+      * @param allocator pool for the task nodes, with elements of at least get_node_size()
+      *        bytes. The executor holds at most as many Events as the pool has elements.
+      */
+    WorkStealingExecutor(PoolAllocator& allocator);
+
+    /* Forbid copy and assignment */
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor(WorkStealingExecutor&&) = delete;
+    WorkStealingExecutor& operator =(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator =(WorkStealingExecutor&&) = delete;
+
+    /** Destructor. The Events that were not run are destroyed without being called.
+      * No worker can be running when the executor is destroyed.
+      */
+    ~WorkStealingExecutor();
+
+    /** Initialize the executor
+      * @param num_workers number of workers (at least 1)
+      * @param deque_capacity capacity of the deque of each worker (a power of 2)
+      * @param alloc_traits allocator traits (for mbed_ualloc)
+      * @returns true if the initialization succeeded, false otherwise
+      */
+    bool init(size_t num_workers, size_t deque_capacity, UAllocTraits_t alloc_traits);
+
+    /** Set the function called after each Event is posted, to wake up a parked worker.
+      * It is called once per post(), from the posting thread or interrupt handler, and must
+      * count its calls (e.g. release a counting semaphore) so that a worker that parks after
+      * the call still wakes up
+      * @param handler the wakeup handler
+      */
+    void set_wakeup_handler(const FunctionPointer& handler);
+
+    /** Post a copy of an Event. Can be called from any thread or interrupt handler
+      * @param e the event
+      * @returns true for success, false if the pool is exhausted or 'e' is empty
+      */
+    bool post(const Event& e);
+
+    /** Move an Event into the executor. Can be called from any thread or interrupt handler
+      * @param e the event
+      * @returns true for success, false if the pool is exhausted or 'e' is empty
+      */
+    bool post(Event&& e);
+
+    /** Post a copy of an Event to the deque of a worker. Must be called by that worker
+      * @param worker index of the calling worker
+      * @param e the event
+      * @returns true for success, false if the pool is exhausted or 'e' is empty
+      */
+    bool post(size_t worker, const Event& e);
+
+    /** Move an Event to the deque of a worker. Must be called by that worker
+      * @param worker index of the calling worker
+      * @param e the event
+      * @returns true for success, false if the pool is exhausted or 'e' is empty
+      */
+    bool post(size_t worker, Event&& e);
+
+    /** Run one Event. Must be called by the worker
+      * @param worker index of the calling worker
+      * @returns true if an Event was run, false if no work was found. The worker can then
+      *          park until the wakeup handler is called; see set_wakeup_handler()
+      */
+    bool run_one(size_t worker);
+
+    /** Returns the number of workers
+      * @returns number of workers
+      */
+    size_t get_num_workers() const;
+
+    /** Returns the element size needed in the pool given to the constructor
+      * @returns size of a task node in bytes
+      */
+    static size_t get_node_size();
+
+private:
+    struct task;
+
+    task *_new_task(const Event& e);
+    task *_new_task(Event&& e);
+    bool _post(task *t);
+    bool _post(size_t worker, task *t);
+    bool _take_overflow(size_t worker, task *&t);
+    bool _steal(size_t worker, task *&t);
+    void _run(task *t);
+    void _free(task *t);
+    size_t _random_index();
+
+    PoolAllocator& _allocator;
+    WorkStealingDeque<task*> *_deques;
+    // Per worker: tasks taken from the overflow list that didn't fit in its deque, oldest first
+    task **_backlogs;
+    size_t _num_workers;
+    // Tasks posted with post(e), newest first
+    task *_overflow;
+    FunctionPointer _wakeup;
+    uint32_t _seed;
+};
+
+} // namespace util
+} // namespace mbed
+
+#endif // #ifndef __MBED_UTIL_WORK_STEALING_EXECUTOR_H__
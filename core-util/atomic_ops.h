@@ -18,12 +18,75 @@
 #ifndef __MBED_UTIL_ATOMIC_OPS_H__
 #define __MBED_UTIL_ATOMIC_OPS_H__
 
+#include <stddef.h>
 #include <stdint.h>
+#include <type_traits>
 #include "core-util/CriticalSectionLock.h"
 
+/* Compilers that provide the __atomic builtins (GCC and clang) implement atomic_cas,
+ * atomic_incr and atomic_decr with them for all the types that the target can handle
+ * without a lock, including 64 bit integers and pointers on 64 bit hosts. The other types
+ * (and the other compilers) use a CriticalSectionLock, which is not thread safe on POSIX.
+ * The load/store-exclusive specializations below are still used on ARMv7-M and above.
+ */
+#if defined(__GNUC__) && defined(__ATOMIC_SEQ_CST)
+#define MBED_UTIL_ATOMIC_NATIVE 1
+#else
+#define MBED_UTIL_ATOMIC_NATIVE 0
+#endif
+
 namespace mbed {
 namespace util {
 
+/** Checks if atomic operations on T use the native atomic instructions of the target
+  * instead of a CriticalSectionLock
+  */
+template<typename T>
+struct atomic_is_native : public std::integral_constant<bool,
+#if MBED_UTIL_ATOMIC_NATIVE
+    (std::is_integral<T>::value || std::is_pointer<T>::value) && __atomic_always_lock_free(sizeof(T), 0)
+#else
+    false
+#endif
+    > {
+};
+
+namespace detail {
+
+template<typename T>
+bool atomic_cas_locked(T *ptr, T *expectedCurrentValue, T desiredValue)
+{
+    bool rc = true;
+
+    CriticalSectionLock lock;
+
+    T currentValue = *ptr;
+    if (currentValue == *expectedCurrentValue) {
+        *ptr = desiredValue;
+    } else {
+        *expectedCurrentValue = currentValue;
+        rc = false;
+    }
+
+    return rc;
+}
+
+#if MBED_UTIL_ATOMIC_NATIVE
+template<typename T>
+inline bool atomic_cas_dispatch(T *ptr, T *expectedCurrentValue, T desiredValue, std::true_type)
+{
+    return __atomic_compare_exchange_n(ptr, expectedCurrentValue, desiredValue, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+#endif
+
+template<typename T>
+inline bool atomic_cas_dispatch(T *ptr, T *expectedCurrentValue, T desiredValue, std::false_type)
+{
+    return atomic_cas_locked(ptr, expectedCurrentValue, desiredValue);
+}
+
+} // namespace detail
+
 /**
  * Atomic compare and set. It compares the contents of a memory location to a
  * given value and, only if they are the same, modifies the contents of that
@@ -75,29 +138,59 @@ namespace util {
  *     return value + a
  * }
  *
- * The following is the generic implementation. It can be specialized using
- * load-store-exclusive primitives for architectures offering appropriate
- * instructions. The generic implementation applies for architectures lacking
- * load-store-exclusive primitives, or when matching against target types larger
- * than the word-size.
+ * The following is the generic implementation. It uses the __atomic builtins of
+ * the compiler when atomic_is_native<T> is true, and a CriticalSectionLock
+ * otherwise. It can be specialized using load-store-exclusive primitives for
+ * architectures offering appropriate instructions.
  */
 template<typename T>
 bool atomic_cas(T *ptr, T *expectedCurrentValue, T desiredValue)
 {
-    bool rc = true;
+    return detail::atomic_cas_dispatch(ptr, expectedCurrentValue, desiredValue,
+        std::integral_constant<bool, atomic_is_native<T>::value>());
+}
 
-    CriticalSectionLock lock;
+namespace detail {
 
-    T currentValue = *ptr;
-    if (currentValue == *expectedCurrentValue) {
-        *ptr = desiredValue;
-    } else {
-        *expectedCurrentValue = currentValue;
-        rc = false;
+template<typename T>
+T atomic_incr_dispatch(T *valuePtr, T delta, std::false_type)
+{
+    T oldValue = *valuePtr;
+    while (true) {
+        const T newValue = oldValue + delta;
+        if (atomic_cas(valuePtr, &oldValue, newValue)) {
+            return newValue;
+        }
     }
+}
 
-    return rc;
+template<typename T>
+T atomic_decr_dispatch(T *valuePtr, T delta, std::false_type)
+{
+    T oldValue = *valuePtr;
+    while (true) {
+        const T newValue = oldValue - delta;
+        if (atomic_cas(valuePtr, &oldValue, newValue)) {
+            return newValue;
+        }
+    }
+}
+
+#if MBED_UTIL_ATOMIC_NATIVE
+template<typename T>
+inline T atomic_incr_dispatch(T *valuePtr, T delta, std::true_type)
+{
+    return __atomic_add_fetch(valuePtr, delta, __ATOMIC_SEQ_CST);
+}
+
+template<typename T>
+inline T atomic_decr_dispatch(T *valuePtr, T delta, std::true_type)
+{
+    return __atomic_sub_fetch(valuePtr, delta, __ATOMIC_SEQ_CST);
 }
+#endif
+
+} // namespace detail
 
 /**
  * Atomic increment.
@@ -108,13 +201,8 @@ bool atomic_cas(T *ptr, T *expectedCurrentValue, T desiredValue)
 template<typename T>
 T atomic_incr(T *valuePtr, T delta)
 {
-    T oldValue = *valuePtr;
-    while (true) {
-        const T newValue = oldValue + delta;
-        if (atomic_cas(valuePtr, &oldValue, newValue)) {
-            return newValue;
-        }
-    }
+    return detail::atomic_incr_dispatch(valuePtr, delta,
+        std::integral_constant<bool, atomic_is_native<T>::value>());
 }
 /**
  * Atomic decrement.
@@ -125,13 +213,310 @@ T atomic_incr(T *valuePtr, T delta)
 template<typename T>
 T atomic_decr(T *valuePtr, T delta)
 {
-    T oldValue = *valuePtr;
-    while (true) {
-        const T newValue = oldValue - delta;
-        if (atomic_cas(valuePtr, &oldValue, newValue)) {
-            return newValue;
-        }
+    return detail::atomic_decr_dispatch(valuePtr, delta,
+        std::integral_constant<bool, atomic_is_native<T>::value>());
+}
+
+/**
+ * Memory ordering of the atomic operations below, with the same meaning as the
+ * C++11 memory orders. atomic_cas, atomic_incr and atomic_decr always use
+ * atomic_seq_cst. Weaker orders are only cheaper with the native backend; the
+ * CriticalSectionLock backend ignores them.
+ */
+enum atomic_order {
+#if MBED_UTIL_ATOMIC_NATIVE
+    atomic_relaxed = __ATOMIC_RELAXED,
+    atomic_acquire = __ATOMIC_ACQUIRE,
+    atomic_release = __ATOMIC_RELEASE,
+    atomic_acq_rel = __ATOMIC_ACQ_REL,
+    atomic_seq_cst = __ATOMIC_SEQ_CST
+#else
+    atomic_relaxed,
+    atomic_acquire,
+    atomic_release,
+    atomic_acq_rel,
+    atomic_seq_cst
+#endif
+};
+
+namespace detail {
+
+// The order of a failed compare and set can't include a release
+inline atomic_order atomic_failure_order(atomic_order order)
+{
+    return order == atomic_acq_rel ? atomic_acquire : (order == atomic_release ? atomic_relaxed : order);
+}
+
+template<typename T>
+T atomic_load_dispatch(const T *ptr, atomic_order, std::false_type)
+{
+    CriticalSectionLock lock;
+    return *ptr;
+}
+
+template<typename T>
+void atomic_store_dispatch(T *ptr, T value, atomic_order, std::false_type)
+{
+    CriticalSectionLock lock;
+    *ptr = value;
+}
+
+template<typename T>
+T atomic_exchange_dispatch(T *ptr, T value, atomic_order, std::false_type)
+{
+    CriticalSectionLock lock;
+    T oldValue = *ptr;
+    *ptr = value;
+    return oldValue;
+}
+
+template<typename T>
+bool atomic_cas_weak_dispatch(T *ptr, T *expectedCurrentValue, T desiredValue, atomic_order, std::false_type)
+{
+    return atomic_cas(ptr, expectedCurrentValue, desiredValue);
+}
+
+template<typename T>
+T atomic_fetch_add_dispatch(T *ptr, T delta, atomic_order, std::false_type)
+{
+    T oldValue = *ptr;
+    while (!atomic_cas(ptr, &oldValue, (T)(oldValue + delta))) {
     }
+    return oldValue;
+}
+
+template<typename T>
+T atomic_fetch_sub_dispatch(T *ptr, T delta, atomic_order, std::false_type)
+{
+    T oldValue = *ptr;
+    while (!atomic_cas(ptr, &oldValue, (T)(oldValue - delta))) {
+    }
+    return oldValue;
+}
+
+template<typename T>
+T atomic_fetch_or_dispatch(T *ptr, T bits, atomic_order, std::false_type)
+{
+    T oldValue = *ptr;
+    while (!atomic_cas(ptr, &oldValue, (T)(oldValue | bits))) {
+    }
+    return oldValue;
+}
+
+template<typename T>
+T atomic_fetch_and_dispatch(T *ptr, T bits, atomic_order, std::false_type)
+{
+    T oldValue = *ptr;
+    while (!atomic_cas(ptr, &oldValue, (T)(oldValue & bits))) {
+    }
+    return oldValue;
+}
+
+#if MBED_UTIL_ATOMIC_NATIVE
+template<typename T>
+inline T atomic_load_dispatch(const T *ptr, atomic_order order, std::true_type)
+{
+    return __atomic_load_n(ptr, order);
+}
+
+template<typename T>
+inline void atomic_store_dispatch(T *ptr, T value, atomic_order order, std::true_type)
+{
+    __atomic_store_n(ptr, value, order);
+}
+
+template<typename T>
+inline T atomic_exchange_dispatch(T *ptr, T value, atomic_order order, std::true_type)
+{
+    return __atomic_exchange_n(ptr, value, order);
+}
+
+template<typename T>
+inline bool atomic_cas_weak_dispatch(T *ptr, T *expectedCurrentValue, T desiredValue, atomic_order order, std::true_type)
+{
+    return __atomic_compare_exchange_n(ptr, expectedCurrentValue, desiredValue, true, order, atomic_failure_order(order));
+}
+
+template<typename T>
+inline T atomic_fetch_add_dispatch(T *ptr, T delta, atomic_order order, std::true_type)
+{
+    return __atomic_fetch_add(ptr, delta, order);
+}
+
+template<typename T>
+inline T atomic_fetch_sub_dispatch(T *ptr, T delta, atomic_order order, std::true_type)
+{
+    return __atomic_fetch_sub(ptr, delta, order);
+}
+
+template<typename T>
+inline T atomic_fetch_or_dispatch(T *ptr, T bits, atomic_order order, std::true_type)
+{
+    return __atomic_fetch_or(ptr, bits, order);
+}
+
+template<typename T>
+inline T atomic_fetch_and_dispatch(T *ptr, T bits, atomic_order order, std::true_type)
+{
+    return __atomic_fetch_and(ptr, bits, order);
+}
+#endif
+
+} // namespace detail
+
+/**
+ * Atomic load.
+ * @param  ptr   The memory location being read.
+ * @param  order atomic_relaxed, atomic_acquire or atomic_seq_cst.
+ * @return       The value at 'ptr'.
+ */
+template<typename T>
+T atomic_load(const T *ptr, atomic_order order = atomic_seq_cst)
+{
+    return detail::atomic_load_dispatch(ptr, order,
+        std::integral_constant<bool, atomic_is_native<T>::value>());
+}
+
+/**
+ * Atomic store.
+ * @param  ptr   The memory location being written.
+ * @param  value The new value.
+ * @param  order atomic_relaxed, atomic_release or atomic_seq_cst.
+ */
+template<typename T>
+void atomic_store(T *ptr, T value, atomic_order order = atomic_seq_cst)
+{
+    detail::atomic_store_dispatch(ptr, value, order,
+        std::integral_constant<bool, atomic_is_native<T>::value>());
+}
+
+/**
+ * Atomic exchange.
+ * @param  ptr   The memory location being written.
+ * @param  value The new value.
+ * @param  order The memory order.
+ * @return       The previous value at 'ptr'.
+ */
+template<typename T>
+T atomic_exchange(T *ptr, T value, atomic_order order = atomic_seq_cst)
+{
+    return detail::atomic_exchange_dispatch(ptr, value, order,
+        std::integral_constant<bool, atomic_is_native<T>::value>());
+}
+
+/**
+ * Weak atomic compare and set. Like atomic_cas, but it can fail spuriously
+ * (returning false and updating *expectedCurrentValue with a value that is still
+ * the same), which makes it cheaper on load-link/store-conditional architectures.
+ * Use it in loops that retry anyway.
+ * @param  ptr                  The target memory location.
+ * @param[in,out] expectedCurrentValue The expected current value, updated on failure.
+ * @param  desiredValue         The new value.
+ * @param  order                The memory order of a successful exchange. A failure
+ *                              uses the same order without the release part.
+ * @return                      true if the memory location was updated, false otherwise.
+ */
+template<typename T>
+bool atomic_cas_weak(T *ptr, T *expectedCurrentValue, T desiredValue, atomic_order order = atomic_seq_cst)
+{
+    return detail::atomic_cas_weak_dispatch(ptr, expectedCurrentValue, desiredValue, order,
+        std::integral_constant<bool, atomic_is_native<T>::value>());
+}
+
+/**
+ * Atomic addition.
+ * @param  ptr   The target memory location.
+ * @param  delta The amount being added.
+ * @param  order The memory order.
+ * @return       The value before the addition (atomic_incr returns the new value).
+ */
+template<typename T>
+T atomic_fetch_add(T *ptr, T delta, atomic_order order = atomic_seq_cst)
+{
+    return detail::atomic_fetch_add_dispatch(ptr, delta, order,
+        std::integral_constant<bool, atomic_is_native<T>::value>());
+}
+
+/**
+ * Atomic subtraction.
+ * @param  ptr   The target memory location.
+ * @param  delta The amount being subtracted.
+ * @param  order The memory order.
+ * @return       The value before the subtraction (atomic_decr returns the new value).
+ */
+template<typename T>
+T atomic_fetch_sub(T *ptr, T delta, atomic_order order = atomic_seq_cst)
+{
+    return detail::atomic_fetch_sub_dispatch(ptr, delta, order,
+        std::integral_constant<bool, atomic_is_native<T>::value>());
+}
+
+/**
+ * Atomic bitwise or.
+ * @param  ptr   The target memory location.
+ * @param  bits  The bits being set.
+ * @param  order The memory order.
+ * @return       The value before the operation.
+ */
+template<typename T>
+T atomic_fetch_or(T *ptr, T bits, atomic_order order = atomic_seq_cst)
+{
+    return detail::atomic_fetch_or_dispatch(ptr, bits, order,
+        std::integral_constant<bool, atomic_is_native<T>::value>());
+}
+
+/**
+ * Atomic bitwise and.
+ * @param  ptr   The target memory location.
+ * @param  bits  The bits being kept.
+ * @param  order The memory order.
+ * @return       The value before the operation.
+ */
+template<typename T>
+T atomic_fetch_and(T *ptr, T bits, atomic_order order = atomic_seq_cst)
+{
+    return detail::atomic_fetch_and_dispatch(ptr, bits, order,
+        std::integral_constant<bool, atomic_is_native<T>::value>());
+}
+
+namespace detail {
+
+template<typename T>
+T *atomic_ptr_add_dispatch(T * volatile *ptr, ptrdiff_t bytes, atomic_order, std::false_type)
+{
+    CriticalSectionLock lock;
+    T *newValue = (T *)((uintptr_t)*ptr + (uintptr_t)bytes);
+    *ptr = newValue;
+    return newValue;
+}
+
+#if MBED_UTIL_ATOMIC_NATIVE
+template<typename T>
+inline T *atomic_ptr_add_dispatch(T * volatile *ptr, ptrdiff_t bytes, atomic_order order, std::true_type)
+{
+    // The __atomic builtins don't scale the addend by the size of T
+    return __atomic_add_fetch(ptr, bytes, order);
+}
+#endif
+
+} // namespace detail
+
+/**
+ * Atomically move a pointer by a number of bytes. Useful for bump allocators
+ * like mbed_sbrk. The pointer can be volatile, and it is updated in place
+ * rather than through an integer alias. The pointers themselves can be read,
+ * written and compared with atomic_load, atomic_store, atomic_exchange and
+ * atomic_cas.
+ * @param  ptr   The pointer being moved.
+ * @param  bytes The number of bytes to add (can be negative).
+ * @param  order The memory order.
+ * @return       The new value of the pointer.
+ */
+template<typename T>
+T *atomic_ptr_add(T * volatile *ptr, ptrdiff_t bytes, atomic_order order = atomic_seq_cst)
+{
+    return detail::atomic_ptr_add_dispatch(ptr, bytes, order,
+        std::integral_constant<bool, atomic_is_native<T *>::value>());
 }
 
 /* For ARMv7-M and above, we use the load/store-exclusive instructions to
@@ -0,0 +1,132 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core-util/EventQueue.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <utility>
+
+#include "core-util/atomic_ops.h"
+
+namespace mbed {
+namespace util {
+
+struct EventQueue::node {
+    node(const Event& e): next(NULL), event(e) {
+    }
+
+    node(Event&& e): next(NULL), event(std::move(e)) {
+    }
+
+    node *next;
+    Event event;
+};
+
+EventQueue::EventQueue(PoolAllocator& allocator):
+    _allocator(allocator), _posted(NULL), _head(NULL), _tail(NULL) {
+}
+
+EventQueue::~EventQueue() {
+    _take_posted();
+    while (_head != NULL) {
+        node *n = _head;
+        _head = n->next;
+        _free(n);
+    }
+}
+
+bool EventQueue::post(const Event& e) {
+    if (!e)
+        return false;
+    void *mem = _allocator.alloc();
+    if (NULL == mem)
+        return false;
+    return _post(new(mem) node(e));
+}
+
+bool EventQueue::post(Event&& e) {
+    if (!e)
+        return false;
+    void *mem = _allocator.alloc();
+    if (NULL == mem)
+        return false;
+    return _post(new(mem) node(std::move(e)));
+}
+
+size_t EventQueue::dispatch(size_t max_events) {
+    _take_posted();
+    size_t called = 0;
+    while ((_head != NULL) && (called < max_events)) {
+        node *n = _head;
+        _head = n->next;
+        if (NULL == _head)
+            _tail = NULL;
+        n->event.call();
+        _free(n);
+        called ++;
+    }
+    return called;
+}
+
+bool EventQueue::is_empty() const {
+    return (NULL == _head) && (NULL == atomic_load(&_posted, atomic_relaxed));
+}
+
+size_t EventQueue::get_node_size() {
+    return sizeof(node);
+}
+
+bool EventQueue::_post(node *n) {
+    node *posted = atomic_load(&_posted, atomic_relaxed);
+    while (true) {
+        n->next = posted;
+        if (atomic_cas(&_posted, &posted, n)) {
+            return true;
+        }
+    }
+}
+
+void EventQueue::_take_posted() {
+    // Detach the whole list at once; producers only ever push, so there is no ABA problem
+    node *posted = atomic_load(&_posted, atomic_relaxed);
+    while ((posted != NULL) && !atomic_cas(&_posted, &posted, (node*)NULL)) {
+    }
+    if (NULL == posted)
+        return;
+    // Reverse the list (newest first) to get the posting order
+    node *list = posted, *first = NULL, *last = list;
+    while (list != NULL) {
+        node *next = list->next;
+        list->next = first;
+        first = list;
+        list = next;
+    }
+    if (NULL == _tail)
+        _head = first;
+    else
+        _tail->next = first;
+    _tail = last;
+}
+
+void EventQueue::_free(node *n) {
+    n->~node();
+    _allocator.free(n);
+}
+
+} // namespace util
+} // namespace mbed
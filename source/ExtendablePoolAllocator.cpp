@@ -22,6 +22,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <new>
 
 namespace mbed {
@@ -89,12 +90,11 @@ void* ExtendablePoolAllocator::alloc() {
 }
 
 void *ExtendablePoolAllocator::calloc() {
-    uint32_t *blk = (uint32_t*)alloc();
+    void *blk = alloc();
 
     if (blk == NULL)
         return NULL;
-    for (unsigned i = 0; i < _element_size / 4; i ++, blk ++)
-        *blk = 0;
+    memset(blk, 0, _element_size);
     return blk;
 }
 
@@ -19,7 +19,9 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
+#include "core-util/assert.h"
 #include "core-util/atomic_ops.h"
 
 namespace mbed {
@@ -27,35 +29,71 @@ namespace util {
 
 PoolAllocator::PoolAllocator(void *start, size_t elements, size_t element_size, unsigned alignment):
     _start(start), _element_size(align_up(element_size, alignment)) {
+    // The free list links are indexes that fit in half of the head
+    CORE_UTIL_ASSERT_MSG(elements <= get_max_elements(), "Too many elements in the pool");
+    if (elements > get_max_elements())
+        elements = get_max_elements();
     _end = (void*)((uint8_t*)start + _element_size * elements);
     _init();
 }
 
+// The link of the head element can be read after another thread allocated that element and
+// started writing to it. The value read is then discarded, because the tag of the head
+// changed and the atomic_cas below fails. ThreadSanitizer can't know that, so it is told not
+// to instrument alloc(). It still instruments atomic operations and the functions alloc()
+// calls, so in that case the link is read with a plain load, in alloc() itself.
+#if defined(__SANITIZE_THREAD__)
+#define POOL_ALLOC_TSAN 1
+#define POOL_ALLOC_NO_TSAN __attribute__((no_sanitize_thread))
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define POOL_ALLOC_TSAN 1
+#define POOL_ALLOC_NO_TSAN __attribute__((no_sanitize("thread")))
+#endif
+#endif
+#ifndef POOL_ALLOC_NO_TSAN
+#define POOL_ALLOC_TSAN 0
+#define POOL_ALLOC_NO_TSAN
+#endif
+
+POOL_ALLOC_NO_TSAN
 void* PoolAllocator::alloc() {
-    uintptr_t prev_free = reinterpret_cast<uintptr_t>(_free_block);
+    head_t head = atomic_load(&_free_head, atomic_acquire);
     while (true) {
-        if (0 == prev_free)
+        uint32_t index = (uint32_t)(head & head_index_mask);
+        if (0 == index)
             return NULL;
-        void **const new_free = (void **)(*((void **)prev_free));
-        if (atomic_cas((uintptr_t*)&_free_block, &prev_free, (uintptr_t)new_free)) {
-            return (void*)prev_free;
+#if POOL_ALLOC_TSAN
+        uint32_t next = *(volatile uint32_t*)_link(index - 1);
+#else
+        uint32_t next = atomic_load(_link(index - 1), atomic_relaxed);
+#endif
+        head_t new_head = (head_t)((((head >> head_index_bits) + 1) << head_index_bits) | next);
+        if (atomic_cas(&_free_head, &head, new_head)) {
+            return (uint8_t*)_start + (index - 1) * _element_size;
         }
     }
 }
 
 void PoolAllocator::free(void* p) {
     if (owns(p)) {
+        uint32_t index = (uint32_t)(((uint8_t*)p - (uint8_t*)_start) / _element_size);
+        head_t head = atomic_load(&_free_head, atomic_relaxed);
         while (true) {
-            uintptr_t prev_free = reinterpret_cast<uintptr_t>(_free_block);
-
-            *((void**)p) = (void*)prev_free;
-            if (atomic_cas((uintptr_t*)&_free_block, &prev_free, (uintptr_t)p)) {
+            atomic_store(_link(index), (uint32_t)(head & head_index_mask), atomic_relaxed);
+            // The tag is only changed by alloc(): pushing can't suffer from ABA
+            head_t new_head = (head & ~head_index_mask) | (index + 1);
+            if (atomic_cas(&_free_head, &head, new_head)) {
                 break;
             }
         }
     }
 }
 
+size_t PoolAllocator::get_max_elements() {
+    return (size_t)head_index_mask;
+}
+
 bool PoolAllocator::owns(const void *p) const {
     return (p >= _start) && (p < _end);
 }
@@ -66,16 +104,15 @@ size_t PoolAllocator::get_pool_size(size_t elements, size_t element_size, unsign
 }
 
 void* PoolAllocator::calloc() {
-    uint32_t *blk = (uint32_t*)alloc();
+    void *blk = alloc();
 
     if (NULL == blk)
         return NULL;
-    for(unsigned i = 0; i < _element_size / 4; i ++, blk ++)
-        *blk = 0;
+    memset(blk, 0, _element_size);
     return blk;
 }
 
-uint32_t PoolAllocator:: align_up(uint32_t n, uint32_t alignment) {
+uintptr_t PoolAllocator::align_up(uintptr_t n, uintptr_t alignment) {
     return (n + alignment - 1) & ~(alignment - 1);
 }
 
@@ -83,23 +120,18 @@ void* PoolAllocator::get_start_address() const {
     return _start;
 }
 
+uint32_t *PoolAllocator::_link(uint32_t index) const {
+    return (uint32_t*)((uint8_t*)_start + (uintptr_t)index * _element_size);
+}
+
 void PoolAllocator::_init() {
-    _free_block = _start;
-
-    // Link all free blocks using offsets.
-    void* next;
-    void* blk = _free_block;
-
-    while(true) {
-        next = ((uint8_t *) blk) + _element_size;
-        if(next > _end)
-            break;
-        *((void **)blk) = next;
-        blk = next;
+    uint32_t elements = (uint32_t)(((uint8_t*)_end - (uint8_t*)_start) / _element_size);
+
+    // Link all free blocks using indexes plus one, 0 marks the last one
+    for (uint32_t i = 0; i < elements; i ++) {
+        *_link(i) = (i + 1 < elements) ? i + 2 : 0;
     }
-    // count back one block and mark it as the last one
-    blk = ((uint8_t *) blk) - _element_size;
-    *((void **)blk) = 0;
+    _free_head = elements > 0 ? 1 : 0;
 }
 
 } // namespace util
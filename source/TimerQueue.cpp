@@ -0,0 +1,171 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core-util/TimerQueue.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <utility>
+
+#include "core-util/CriticalSectionLock.h"
+
+namespace mbed {
+namespace util {
+
+struct TimerQueue::node {
+    node(const Event& e): next(NULL), event(e) {
+    }
+
+    node(Event&& e): next(NULL), event(std::move(e)) {
+    }
+
+    // links the expired timers during dispatch()
+    node *next;
+    Event event;
+};
+
+TimerQueue::TimerQueue(PoolAllocator& allocator):
+    _allocator(allocator), _heap(), _now(0), _sequence(0) {
+}
+
+TimerQueue::~TimerQueue() {
+    while (!_heap.is_empty()) {
+        _free(_heap.pop_root().n);
+    }
+}
+
+bool TimerQueue::init(size_t initial_capacity, size_t grow_capacity, UAllocTraits_t alloc_traits) {
+    return _heap.init(initial_capacity, grow_capacity, alloc_traits);
+}
+
+TimerQueue::Handle TimerQueue::post_at(const Event& e, uint32_t deadline) {
+    if (!e)
+        return Handle();
+    void *mem = _allocator.alloc();
+    if (NULL == mem)
+        return Handle();
+    node *n = new(mem) node(e);
+    Handle h = _insert(n, deadline);
+    if (!h.is_valid())
+        _free(n);
+    return h;
+}
+
+TimerQueue::Handle TimerQueue::post_at(Event&& e, uint32_t deadline) {
+    if (!e)
+        return Handle();
+    void *mem = _allocator.alloc();
+    if (NULL == mem)
+        return Handle();
+    node *n = new(mem) node(std::move(e));
+    Handle h = _insert(n, deadline);
+    if (!h.is_valid()) {
+        // The heap is full: give the event back to the caller
+        e = std::move(n->event);
+        _free(n);
+    }
+    return h;
+}
+
+TimerQueue::Handle TimerQueue::post_in(const Event& e, uint32_t delay) {
+    return post_at(e, _now + delay);
+}
+
+TimerQueue::Handle TimerQueue::post_in(Event&& e, uint32_t delay) {
+    return post_at(std::move(e), _now + delay);
+}
+
+bool TimerQueue::cancel(const Handle& h) {
+    node *n;
+    {
+        CriticalSectionLock lock;
+        if (!_heap.contains(h))
+            return false;
+        n = _heap.get(h).n;
+        _heap.remove(h);
+    }
+    _free(n);
+    return true;
+}
+
+bool TimerQueue::is_pending(const Handle& h) const {
+    return _heap.contains(h);
+}
+
+size_t TimerQueue::dispatch(uint32_t now, size_t max_events) {
+    node *first = NULL, *last = NULL;
+    size_t expired = 0;
+    {
+        // Take all the expired timers out of the heap in one batch
+        CriticalSectionLock lock;
+        _now = now;
+        while ((expired < max_events) && !_heap.is_empty()) {
+            entry e = _heap.get_root();
+            if ((int32_t)(now - e.deadline) < 0)
+                break;
+            _heap.remove_root();
+            e.n->next = NULL;
+            if (NULL == last)
+                first = e.n;
+            else
+                last->next = e.n;
+            last = e.n;
+            expired ++;
+        }
+    }
+    while (first != NULL) {
+        node *n = first;
+        first = n->next;
+        n->event.call();
+        _free(n);
+    }
+    return expired;
+}
+
+bool TimerQueue::get_next_deadline(uint32_t& deadline) const {
+    CriticalSectionLock lock;
+    if (_heap.is_empty())
+        return false;
+    deadline = _heap.get_root().deadline;
+    return true;
+}
+
+uint32_t TimerQueue::get_time() const {
+    return _now;
+}
+
+size_t TimerQueue::get_num_pending() const {
+    return _heap.get_num_elements();
+}
+
+size_t TimerQueue::get_node_size() {
+    return sizeof(node);
+}
+
+TimerQueue::Handle TimerQueue::_insert(node *n, uint32_t deadline) {
+    CriticalSectionLock lock;
+    entry e = {deadline, _sequence ++, n};
+    return _heap.insert(e);
+}
+
+void TimerQueue::_free(node *n) {
+    n->~node();
+    _allocator.free(n);
+}
+
+} // namespace util
+} // namespace mbed
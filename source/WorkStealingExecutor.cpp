@@ -0,0 +1,233 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core-util/WorkStealingExecutor.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <utility>
+
+#include "core-util/atomic_ops.h"
+
+namespace mbed {
+namespace util {
+
+struct WorkStealingExecutor::task {
+    task(const Event& e): next(NULL), event(e) {
+    }
+
+    task(Event&& e): next(NULL), event(std::move(e)) {
+    }
+
+    // links the tasks in the overflow list
+    task *next;
+    Event event;
+};
+
+WorkStealingExecutor::WorkStealingExecutor(PoolAllocator& allocator):
+    _allocator(allocator), _deques(NULL), _backlogs(NULL), _num_workers(0), _overflow(NULL), _wakeup(),
+    _seed(0x9E3779B9UL) {
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+    task *t;
+    for (size_t i = 0; i < _num_workers; i ++) {
+        while (_deques[i].pop(t)) {
+            _free(t);
+        }
+        _deques[i].~WorkStealingDeque();
+        while (_backlogs[i] != NULL) {
+            t = _backlogs[i];
+            _backlogs[i] = t->next;
+            _free(t);
+        }
+    }
+    if (_deques != NULL)
+        mbed_ufree(_deques);
+    if (_backlogs != NULL)
+        mbed_ufree(_backlogs);
+    while (_overflow != NULL) {
+        t = _overflow;
+        _overflow = t->next;
+        _free(t);
+    }
+}
+
+bool WorkStealingExecutor::init(size_t num_workers, size_t deque_capacity, UAllocTraits_t alloc_traits) {
+    if ((_deques != NULL) || (num_workers == 0))
+        return false; // prevent repeated initialization
+    _deques = (WorkStealingDeque<task*>*)mbed_ualloc(num_workers * sizeof(WorkStealingDeque<task*>), alloc_traits);
+    if (_deques == NULL)
+        return false;
+    _backlogs = (task**)mbed_ualloc(num_workers * sizeof(task*), alloc_traits);
+    if (_backlogs == NULL)
+        return false;
+    for (size_t i = 0; i < num_workers; i ++) {
+        _backlogs[i] = NULL;
+        new(&_deques[i]) WorkStealingDeque<task*>();
+        _num_workers = i + 1;
+        if (!_deques[i].init(deque_capacity, alloc_traits))
+            return false;
+    }
+    return true;
+}
+
+void WorkStealingExecutor::set_wakeup_handler(const FunctionPointer& handler) {
+    _wakeup = handler;
+}
+
+bool WorkStealingExecutor::post(const Event& e) {
+    return _post(_new_task(e));
+}
+
+bool WorkStealingExecutor::post(Event&& e) {
+    return _post(_new_task(std::move(e)));
+}
+
+bool WorkStealingExecutor::post(size_t worker, const Event& e) {
+    return _post(worker, _new_task(e));
+}
+
+bool WorkStealingExecutor::post(size_t worker, Event&& e) {
+    return _post(worker, _new_task(std::move(e)));
+}
+
+bool WorkStealingExecutor::run_one(size_t worker) {
+    task *t;
+    if (_deques[worker].pop(t) || _take_overflow(worker, t) || _steal(worker, t)) {
+        _run(t);
+        return true;
+    }
+    return false;
+}
+
+size_t WorkStealingExecutor::get_num_workers() const {
+    return _num_workers;
+}
+
+size_t WorkStealingExecutor::get_node_size() {
+    return sizeof(task);
+}
+
+WorkStealingExecutor::task *WorkStealingExecutor::_new_task(const Event& e) {
+    if (!e)
+        return NULL;
+    void *mem = _allocator.alloc();
+    return mem == NULL ? NULL : new(mem) task(e);
+}
+
+WorkStealingExecutor::task *WorkStealingExecutor::_new_task(Event&& e) {
+    if (!e)
+        return NULL;
+    void *mem = _allocator.alloc();
+    return mem == NULL ? NULL : new(mem) task(std::move(e));
+}
+
+bool WorkStealingExecutor::_post(task *t) {
+    if (NULL == t)
+        return false;
+    task *overflow = atomic_load(&_overflow, atomic_relaxed);
+    while (true) {
+        t->next = overflow;
+        if (atomic_cas(&_overflow, &overflow, t)) {
+            break;
+        }
+    }
+    if (_wakeup) {
+        _wakeup.call();
+    }
+    return true;
+}
+
+bool WorkStealingExecutor::_post(size_t worker, task *t) {
+    if (NULL == t)
+        return false;
+    if (!_deques[worker].push(t))
+        return _post(t);
+    if (_wakeup) {
+        _wakeup.call();
+    }
+    return true;
+}
+
+bool WorkStealingExecutor::_take_overflow(size_t worker, task *&t) {
+    // The tasks that didn't fit in the deque last time are older than anything still in the
+    // overflow list, so they go first
+    task *first = _backlogs[worker];
+    if (NULL == first) {
+        // Detach the whole list at once; tasks are never removed from it one by one, so there
+        // is no ABA problem
+        task *overflow = atomic_load(&_overflow, atomic_relaxed);
+        while ((overflow != NULL) && !atomic_cas(&_overflow, &overflow, (task*)NULL)) {
+        }
+        if (NULL == overflow)
+            return false;
+        // Reverse the list (newest first) to get the posting order
+        while (overflow != NULL) {
+            task *next = overflow->next;
+            overflow->next = first;
+            first = overflow;
+            overflow = next;
+        }
+    }
+    // Run the oldest task and move the others to this worker's deque, where they can be stolen
+    t = first;
+    first = first->next;
+    while (first != NULL) {
+        // read the link first: once pushed, the task can be stolen and run at any time
+        task *next = first->next;
+        if (!_deques[worker].push(first))
+            break;
+        first = next;
+    }
+    // The deque is full: keep the rest, still oldest first, until the deque is empty again
+    _backlogs[worker] = first;
+    return true;
+}
+
+bool WorkStealingExecutor::_steal(size_t worker, task *&t) {
+    size_t victim = _random_index();
+    for (size_t i = 0; i < _num_workers; i ++, victim = (victim + 1) % _num_workers) {
+        if ((victim != worker) && _deques[victim].steal(t))
+            return true;
+    }
+    return false;
+}
+
+void WorkStealingExecutor::_run(task *t) {
+    t->event.call();
+    _free(t);
+}
+
+void WorkStealingExecutor::_free(task *t) {
+    t->~task();
+    _allocator.free(t);
+}
+
+size_t WorkStealingExecutor::_random_index() {
+    // xorshift32. Concurrent callers may race on '_seed'; that only makes the choice of
+    // victim less random. Relaxed atomics make the race well defined.
+    uint32_t x = atomic_load(&_seed, atomic_relaxed);
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    atomic_store(&_seed, x, atomic_relaxed);
+    return x % _num_workers;
+}
+
+} // namespace util
+} // namespace mbed
@@ -17,11 +17,11 @@
 #include "core-util/atomic_ops.h"
 #include "core-util/sbrk.h"
 
-#include <stdlib.h>
+#include <stdint.h>
 
 void * volatile mbed_krbs_ptr     = MBED_KRBS_START;
 void * volatile mbed_sbrk_ptr     = MBED_SBRK_START;
-volatile ptrdiff_t mbed_sbrk_diff = MBED_HEAP_SIZE;
+ptrdiff_t mbed_sbrk_diff          = MBED_HEAP_SIZE;
 
 void * mbed_sbrk(ptrdiff_t size)
 {
@@ -30,28 +30,29 @@ void * mbed_sbrk(ptrdiff_t size)
     }
 
     // align absolute size requested
-    ptrdiff_t size_internal = abs(size);
+    ptrdiff_t size_internal = size < 0 ? -size : size;
     if ((uintptr_t)size_internal < SBRK_INC_MIN) {
             size_internal = SBRK_INC_MIN;
     }
-    size_internal = ( size_internal + SBRK_ALIGN - 1) & ~(SBRK_ALIGN - 1);
+    // the mask is pointer sized, or it would clear the upper bits of large sizes
+    size_internal = ( size_internal + SBRK_ALIGN - 1) & ~(ptrdiff_t)(SBRK_ALIGN - 1);
     // it's min sized plus aligned, assign back the sign
     if (size < 0) {
         size_internal = -size_internal;
     }
 
     /* Decrement mbed_sbrk_diff by the size being allocated. */
-    ptrdiff_t ptr_diff = mbed_sbrk_diff;
+    ptrdiff_t ptr_diff = mbed::util::atomic_load(&mbed_sbrk_diff, mbed::util::atomic_relaxed);
     while (1) {
         if (size_internal > ptr_diff) {
             return (void *) -1;
         }
-        if (mbed::util::atomic_cas((uint32_t *)&mbed_sbrk_diff, (uint32_t *)&ptr_diff, (uint32_t)(ptr_diff - size_internal))) {
+        if (mbed::util::atomic_cas(&mbed_sbrk_diff, &ptr_diff, ptr_diff - size_internal)) {
             break;
         }
     }
 
-    uintptr_t new_sbrk_ptr = mbed::util::atomic_incr((uint32_t *)&mbed_sbrk_ptr, (uint32_t)size_internal);
+    uint8_t *new_sbrk_ptr = (uint8_t *)mbed::util::atomic_ptr_add(&mbed_sbrk_ptr, size_internal);
     return (void *)(new_sbrk_ptr - size_internal);
 }
 
@@ -75,18 +76,18 @@ void * mbed_krbs_ex(const ptrdiff_t size, ptrdiff_t *actual)
     if (size_internal < KRBS_INC_MIN) {
         size_internal = KRBS_INC_MIN;
     }
-    size_internal = (size_internal + KRBS_ALIGN - 1) & ~(KRBS_ALIGN - 1);
+    size_internal = (size_internal + KRBS_ALIGN - 1) & ~(uintptr_t)(KRBS_ALIGN - 1);
 
     /* Decrement mbed_sbrk_diff by the size being allocated. */
-    ptrdiff_t ptr_diff = mbed_sbrk_diff;
+    ptrdiff_t ptr_diff = mbed::util::atomic_load(&mbed_sbrk_diff, mbed::util::atomic_relaxed);
     while (1) {
         if ((size_internal > (uintptr_t)ptr_diff) && (actual == NULL)) {
             return (void *) -1;
         }
-        if (mbed::util::atomic_cas((uint32_t *)&mbed_sbrk_diff, (uint32_t *)&ptr_diff, (uint32_t)(ptr_diff - size_internal))) {
+        if (mbed::util::atomic_cas(&mbed_sbrk_diff, &ptr_diff, ptr_diff - (ptrdiff_t)size_internal)) {
             break;
         }
     }
 
-    return (void *)mbed::util::atomic_decr((uint32_t *)&mbed_krbs_ptr, (uint32_t)size_internal);
+    return mbed::util::atomic_ptr_add(&mbed_krbs_ptr, -(ptrdiff_t)size_internal);
 }
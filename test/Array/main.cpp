@@ -150,6 +150,72 @@ static void test_non_pod() {
     TEST_ASSERT_EQUAL(0, Test::inst_count);
 }
 
+struct IsMultipleOf {
+    IsMultipleOf(unsigned n): _n(n) {}
+
+    bool operator ()(const Test& t) const {
+        return (t._a % _n) == 0;
+    }
+
+    unsigned _n;
+};
+
+// Only copy constructible, like the types Array is documented to hold
+struct CopyOnly {
+    CopyOnly(unsigned a): _a(a) {
+    }
+
+    CopyOnly(const CopyOnly& c): _a(c._a) {
+    }
+
+    CopyOnly& operator =(const CopyOnly&) = delete;
+
+    unsigned _a;
+};
+
+static void test_find_remove_if() {
+    {
+    Array<Test> array;
+
+    const size_t initial_capacity = 4, grow_capacity = 3, total = 20;
+    UAllocTraits_t traits = {0};
+    TEST_ASSERT_TRUE(array.init(initial_capacity, grow_capacity, traits));
+
+    for (unsigned idx = 0; idx < total; idx ++) {
+        array.push_back(Test(idx, 'a'));
+    }
+    TEST_ASSERT_TRUE(array.get_num_zones() > 1);
+
+    // find_if returns the last matching element, or the number of elements if not found
+    TEST_ASSERT_EQUAL(15, array.find_if(IsMultipleOf(5)));
+    TEST_ASSERT_EQUAL(total - 1, array.find_if(IsMultipleOf(1)));
+
+    // Remove all multiples of 3 (0, 3, 6, ... 18)
+    TEST_ASSERT_EQUAL(7, array.remove_if(IsMultipleOf(3)));
+    TEST_ASSERT_EQUAL(total - 7, array.get_num_elements());
+    TEST_ASSERT_EQUAL(total - 7, (unsigned)Test::inst_count);
+    unsigned sum = 0;
+    for (unsigned idx = 0; idx < array.get_num_elements(); idx ++) {
+        TEST_ASSERT_TRUE(array[idx]._a % 3 != 0);
+        sum += array[idx]._a;
+    }
+    TEST_ASSERT_EQUAL(190 - 63, sum);
+    TEST_ASSERT_EQUAL(array.get_num_elements(), array.find_if(IsMultipleOf(3)));
+    }
+    TEST_ASSERT_EQUAL(0, Test::inst_count);
+
+    Array<CopyOnly> copy_only;
+    UAllocTraits_t traits = {0};
+    TEST_ASSERT_TRUE(copy_only.init(4, 4, traits));
+    for (unsigned idx = 0; idx < 10; idx ++) {
+        copy_only.push_back(CopyOnly(idx));
+    }
+    TEST_ASSERT_EQUAL(5, copy_only.remove_if([](const CopyOnly& c) { return (c._a & 1) == 0; }));
+    for (unsigned idx = 0; idx < copy_only.get_num_elements(); idx ++) {
+        TEST_ASSERT_EQUAL(1, copy_only[idx]._a & 1);
+    }
+}
+
 static status_t test_setup(const size_t number_of_cases) {
     GREENTEA_SETUP(5, "default_auto");
 
@@ -163,7 +229,8 @@ status_t greentea_failure_handler(const Case *const source, const failure_t reas
 
 static Case cases[] = {
     Case("Array  - test with plain old data", test_pod, greentea_failure_handler),
-    Case("Array  - test with complex data", test_non_pod, greentea_failure_handler)
+    Case("Array  - test with complex data", test_non_pod, greentea_failure_handler),
+    Case("Array  - test find_if and remove_if", test_find_remove_if, greentea_failure_handler)
 };
 
 static Specification specification(test_setup, cases, greentea_test_teardown_handler);
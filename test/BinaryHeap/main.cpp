@@ -164,6 +164,163 @@ static void test_max_heap_non_pod() {
     printf("********** Ending test_max_heap_non_pod()\r\n");
 }
 
+static void test_remove_propagate_up() {
+    // Layout after insertion: [0, 10, 1, 11, 12, 2, 3]
+    // Removing 11 moves 3 under 10, so 3 has to move up, not down
+    int data[] = {0, 10, 1, 11, 12, 2, 3};
+    int sorted_after_remove[] = {0, 1, 2, 3, 10, 12};
+    BinaryHeap<int> heap;
+    UAllocTraits_t traits = {0};
+
+    printf("********** Starting test_remove_propagate_up()\r\n");
+    TEST_ASSERT_TRUE(heap.init(4, 4, traits));
+    for (unsigned i = 0; i < sizeof(data)/sizeof(int); i ++) {
+        heap.insert(data[i]);
+    }
+    TEST_ASSERT_TRUE(heap.remove(11));
+    TEST_ASSERT_TRUE(heap.is_consistent());
+    for (unsigned i = 0; i < sizeof(sorted_after_remove)/sizeof(int); i ++) {
+        TEST_ASSERT_EQUAL(sorted_after_remove[i], heap.pop_root());
+    }
+    TEST_ASSERT_TRUE(heap.is_empty());
+    printf("********** Ending test_remove_propagate_up()\r\n");
+}
+
+struct IsEven {
+    bool operator ()(const Test& t) const {
+        return (t._a % 2) == 0;
+    }
+};
+
+static void test_remove_if() {
+    {
+    Test data[] = {291, 62, 364, 63, 753, 325, -382, -736, -930, -927, 734, -591, 136, 753, 576, -59, -930, -700, -380, 764};
+    Test sorted_after_remove[] = {-927, -591, -59, 63, 291, 325, 753, 753};
+    const unsigned data_size = sizeof(data)/sizeof(Test);
+    const unsigned remaining = sizeof(sorted_after_remove)/sizeof(Test);
+    BinaryHeap<Test, MinCompare<Test> > heap;
+    UAllocTraits_t traits = {0};
+
+    printf("********** Starting test_remove_if()\r\n");
+    // Use a small grow capacity to spread the elements over multiple zones
+    TEST_ASSERT_TRUE(heap.init(3, 3, traits));
+    for (unsigned i = 0; i < data_size; i ++) {
+        heap.insert(data[i]);
+    }
+    TEST_ASSERT_EQUAL(data_size - remaining, heap.remove_if(IsEven()));
+    TEST_ASSERT_TRUE(heap.is_consistent());
+    TEST_ASSERT_EQUAL(remaining, heap.get_num_elements());
+    TEST_ASSERT_EQUAL(0, heap.remove_if(IsEven()));
+    for (unsigned i = 0; i < remaining; i ++) {
+        TEST_ASSERT_TRUE(heap.pop_root() == sorted_after_remove[i]);
+        TEST_ASSERT_TRUE(heap.is_consistent());
+    }
+    TEST_ASSERT_TRUE(heap.is_empty());
+    }
+    TEST_ASSERT_EQUAL(0, Test::inst_count);
+    printf("********** Ending test_remove_if()\r\n");
+}
+
+struct LessThan {
+    LessThan(int limit): _limit(limit) {}
+
+    bool operator ()(const Test& t) const {
+        return t._a < _limit;
+    }
+
+    int _limit;
+};
+
+static void test_batch_pop() {
+    {
+    Test data[] = {291, 62, 364, 63, 753, 325, -382, -736, -930, -927, 734, -591, 136, 753, 576, -59, -930, -700, -380, 764};
+    Test sorted_data[] = {-930, -930, -927, -736, -700, -591, -382, -380, -59, 62, 63, 136, 291, 325, 364, 576, 734, 753, 753, 764};
+    const unsigned data_size = sizeof(data)/sizeof(Test);
+    Test out[data_size];
+    size_t frontier[data_size + 5];
+    BinaryHeap<Test, MinCompare<Test> > heap;
+    UAllocTraits_t traits = {0};
+
+    printf("********** Starting test_batch_pop()\r\n");
+    TEST_ASSERT_TRUE(heap.init(4, 4, traits));
+    for (unsigned i = 0; i < data_size; i ++) {
+        heap.insert(data[i]);
+    }
+
+    // top_k() copies the best elements without changing the heap
+    TEST_ASSERT_EQUAL(0, heap.top_k(0, out, frontier));
+    TEST_ASSERT_EQUAL(7, heap.top_k(7, out, frontier));
+    for (unsigned i = 0; i < 7; i ++) {
+        TEST_ASSERT_TRUE(out[i] == sorted_data[i]);
+    }
+    TEST_ASSERT_EQUAL(data_size, heap.top_k(data_size + 5, out, frontier));
+    for (unsigned i = 0; i < data_size; i ++) {
+        TEST_ASSERT_TRUE(out[i] == sorted_data[i]);
+    }
+    TEST_ASSERT_EQUAL(data_size, heap.get_num_elements());
+    TEST_ASSERT_TRUE(heap.is_consistent());
+
+    // pop_n() removes the first elements in order
+    TEST_ASSERT_EQUAL(3, heap.pop_n(3, out));
+    for (unsigned i = 0; i < 3; i ++) {
+        TEST_ASSERT_TRUE(out[i] == sorted_data[i]);
+    }
+    TEST_ASSERT_TRUE(heap.is_consistent());
+
+    // pop_while() stops at the first element that doesn't satisfy the predicate
+    TEST_ASSERT_EQUAL(6, heap.pop_while(LessThan(62), out, data_size));
+    for (unsigned i = 0; i < 6; i ++) {
+        TEST_ASSERT_TRUE(out[i] == sorted_data[i + 3]);
+    }
+    TEST_ASSERT_TRUE(heap.is_consistent());
+    // ... or when the output buffer is full
+    TEST_ASSERT_EQUAL(2, heap.pop_while(LessThan(1000), out, 2));
+    TEST_ASSERT_TRUE(out[0] == sorted_data[9]);
+    TEST_ASSERT_TRUE(out[1] == sorted_data[10]);
+
+    TEST_ASSERT_EQUAL(data_size - 11, heap.pop_n(data_size, out));
+    for (unsigned i = 0; i < data_size - 11; i ++) {
+        TEST_ASSERT_TRUE(out[i] == sorted_data[i + 11]);
+    }
+    TEST_ASSERT_TRUE(heap.is_empty());
+    TEST_ASSERT_EQUAL(0, heap.pop_n(1, out));
+    }
+    TEST_ASSERT_EQUAL(0, Test::inst_count);
+    printf("********** Ending test_batch_pop()\r\n");
+}
+
+// MaxCompare that counts its calls
+static unsigned comparisons;
+
+class CountingMaxCompare {
+public:
+    bool operator ()(unsigned e1, unsigned e2) const {
+        comparisons ++;
+        return e1 >= e2;
+    }
+};
+
+static void test_top_k_max_heap() {
+    BinaryHeap<unsigned, CountingMaxCompare> heap;
+    UAllocTraits_t traits = {0};
+    unsigned out[10];
+    size_t frontier[10];
+
+    TEST_ASSERT_TRUE(heap.init(64, 64, traits));
+    for (unsigned i = 0; i < 1000; i ++) {
+        heap.insert((i * 7919) % 1000);
+    }
+    // the cost depends on k, not on the size of the heap
+    comparisons = 0;
+    TEST_ASSERT_EQUAL(10, heap.top_k(10, out, frontier));
+    TEST_ASSERT_TRUE(comparisons <= 100);
+    for (unsigned i = 0; i < 10; i ++) {
+        TEST_ASSERT_EQUAL(999 - i, out[i]);
+    }
+    TEST_ASSERT_EQUAL(1000, heap.get_num_elements());
+    TEST_ASSERT_TRUE(heap.is_consistent());
+}
+
 static status_t test_setup(const size_t number_of_cases) {
     GREENTEA_SETUP(5, "default_auto");
 
@@ -179,7 +336,11 @@ static Case cases[] = {
     Case("BinaryHeap  - test_min_heap_pod", test_min_heap_pod, greentea_failure_handler),
     Case("BinaryHeap  - test_max_heap_pod", test_max_heap_pod, greentea_failure_handler),
     Case("BinaryHeap  - test_min_heap_non_pod", test_min_heap_non_pod, greentea_failure_handler),
-    Case("BinaryHeap  - test_max_heap_non_pod", test_max_heap_non_pod, greentea_failure_handler)
+    Case("BinaryHeap  - test_max_heap_non_pod", test_max_heap_non_pod, greentea_failure_handler),
+    Case("BinaryHeap  - test_remove_propagate_up", test_remove_propagate_up, greentea_failure_handler),
+    Case("BinaryHeap  - test_remove_if", test_remove_if, greentea_failure_handler),
+    Case("BinaryHeap  - test_batch_pop", test_batch_pop, greentea_failure_handler),
+    Case("BinaryHeap  - test_top_k_max_heap", test_top_k_max_heap, greentea_failure_handler)
 };
 
 static Specification specification(test_setup, cases, greentea_test_teardown_handler);
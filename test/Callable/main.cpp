@@ -0,0 +1,294 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core-util/Callable.h"
+#include "core-util/FunctionPointer.h"
+#include "core-util/ExtendablePoolAllocator.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+#if defined(TARGET_LIKE_POSIX)
+#include <stdio.h>
+#include <time.h>
+#endif
+
+using namespace utest::v1;
+using namespace mbed::util;
+
+static int add(int a, int b) {
+    return a + b;
+}
+
+// Function object that counts its live copies
+class Counter {
+public:
+    Counter(): count(0) {
+        instances++;
+    }
+
+    Counter(const Counter& other): count(other.count) {
+        instances++;
+        copies++;
+    }
+
+    ~Counter() {
+        instances--;
+    }
+
+    int operator()(int delta) {
+        count += delta;
+        return count;
+    }
+
+    int count;
+
+    static int instances;
+    static int copies;
+};
+
+int Counter::instances = 0;
+int Counter::copies = 0;
+
+// Function object that doesn't fit in the inline buffer
+class BigCounter : public Counter {
+public:
+    uint32_t padding[16];
+};
+
+static void test_static_and_lambda() {
+    Callable<int(int, int)> empty;
+    TEST_ASSERT_FALSE(empty);
+
+    Callable<int(int, int)> c1(add);
+    TEST_ASSERT_TRUE(c1);
+    TEST_ASSERT_EQUAL(5, c1(2, 3));
+
+    int total = 0;
+    Callable<void(int)> c2([&total](int x) { total += x; });
+    TEST_ASSERT_TRUE(Callable<void(int)>::is_inline<int*>());
+    c2(5);
+    c2.call(6);
+    TEST_ASSERT_EQUAL(11, total);
+
+    c2.clear();
+    TEST_ASSERT_FALSE(c2);
+
+    // the stored target can be replaced
+    c1 = Callable<int(int, int)>([](int a, int b) { return a * b; });
+    TEST_ASSERT_EQUAL(6, c1(2, 3));
+}
+
+static void test_function_pointer_target() {
+    FunctionPointer2<int, int, int> fp(add);
+    Callable<int(int, int)> c(fp);
+    TEST_ASSERT_EQUAL(7, c(3, 4));
+}
+
+static void check_copy_and_move(Callable<int(int)>& c) {
+    const int instances = Counter::instances;
+    TEST_ASSERT_EQUAL(1, c(1));
+
+    // copies have their own state
+    Callable<int(int)> copy = c;
+    TEST_ASSERT_EQUAL(instances + 1, Counter::instances);
+    TEST_ASSERT_EQUAL(2, copy(1));
+    TEST_ASSERT_EQUAL(2, c(1));
+
+    // moving leaves the source empty and doesn't add instances
+    Callable<int(int)> moved(std::move(copy));
+    TEST_ASSERT_FALSE(copy);
+    TEST_ASSERT_EQUAL(instances + 1, Counter::instances);
+    TEST_ASSERT_EQUAL(3, moved(1));
+
+    moved = c;
+    TEST_ASSERT_EQUAL(instances + 1, Counter::instances);
+    TEST_ASSERT_EQUAL(3, moved(1));
+    moved.clear();
+    TEST_ASSERT_EQUAL(instances, Counter::instances);
+}
+
+static void test_inline_functor() {
+    TEST_ASSERT_TRUE(Callable<int(int)>::is_inline<Counter>());
+    {
+        Callable<int(int)> c((Counter()));
+        TEST_ASSERT_EQUAL(1, Counter::instances);
+        check_copy_and_move(c);
+    }
+    TEST_ASSERT_EQUAL(0, Counter::instances);
+}
+
+static void test_large_functor() {
+    TEST_ASSERT_FALSE(Callable<int(int)>::is_inline<BigCounter>());
+    {
+        Callable<int(int)> c((BigCounter()));
+        TEST_ASSERT_TRUE(c);
+        TEST_ASSERT_EQUAL(1, Counter::instances);
+        check_copy_and_move(c);
+    }
+    TEST_ASSERT_EQUAL(0, Counter::instances);
+
+    // a bigger inline buffer avoids the allocation
+    TEST_ASSERT_TRUE((Callable<int(int), sizeof(BigCounter)>::is_inline<BigCounter>()));
+}
+
+static void test_pool_fallback() {
+    UAllocTraits_t traits = {0};
+    ExtendablePoolAllocator pool;
+    TEST_ASSERT_TRUE(pool.init(1, 1, Callable<int(int)>::get_allocation_size<BigCounter>(), traits));
+    {
+        Callable<int(int)> c(BigCounter(), pool);
+        TEST_ASSERT_TRUE(c);
+        check_copy_and_move(c);
+    }
+    TEST_ASSERT_EQUAL(0, Counter::instances);
+
+    // if the allocation fails the Callable is empty
+    uint64_t memory[32];
+    TEST_ASSERT_TRUE(Callable<int(int)>::get_allocation_size<BigCounter>() <= sizeof(memory));
+    PoolAllocator small_pool(memory, 1, sizeof(memory));
+    Callable<int(int)> c1(BigCounter(), small_pool);
+    TEST_ASSERT_TRUE(c1);
+    Callable<int(int)> c2(BigCounter(), small_pool);
+    TEST_ASSERT_FALSE(c2);
+    Callable<int(int)> c3 = c1;
+    TEST_ASSERT_FALSE(c3);
+}
+
+#if defined(TARGET_LIKE_POSIX)
+static const unsigned benchmarkIterations = 1000000;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+class Accumulator {
+public:
+    Accumulator(): total(0) {}
+
+    int add(int a) {
+        total += a;
+        return total;
+    }
+
+    int total;
+};
+
+static int accumulated = 0;
+
+static int accumulate(int a) {
+    accumulated += a;
+    return accumulated;
+}
+
+// Function object that doesn't fit in the inline buffer
+class BigAccumulator {
+public:
+    BigAccumulator(Accumulator *_target): target(_target) {}
+
+    int operator()(int a) {
+        return target->add(a);
+    }
+
+    Accumulator *target;
+    uint32_t padding[16];
+};
+
+// The barrier makes the compiler reload the target before each call, so that the call
+// isn't resolved at compile time
+template <typename F>
+static double ns_per_call_arg(F &f) {
+    const uint64_t start = now_ns();
+    for (unsigned i = 0; i < benchmarkIterations; i++) {
+        __asm__ __volatile__("" : : "r"(&f) : "memory");
+        f(1);
+    }
+    return (double)(now_ns() - start) / benchmarkIterations;
+}
+
+// Cost of constructing (and destroying) a T from 'source'
+template <typename T, typename Source>
+static double ns_per_construction(const Source &source) {
+    const uint64_t start = now_ns();
+    for (unsigned i = 0; i < benchmarkIterations; i++) {
+        T target(source);
+        __asm__ __volatile__("" : : "r"(&target) : "memory");
+    }
+    return (double)(now_ns() - start) / benchmarkIterations;
+}
+
+// Cost of a call and of a construction for FunctionPointer and for Callable, with a static
+// function, a member function or lambda, and a function object that needs an allocation
+static void test_benchmark() {
+    typedef FunctionPointer1<int, int> FP;
+    typedef Callable<int(int)> C;
+    Accumulator accumulator;
+    auto lambda = [&accumulator](int a) { return accumulator.add(a); };
+    BigAccumulator big(&accumulator);
+    TEST_ASSERT_FALSE(C::is_inline<BigAccumulator>());
+
+    FP fp_static(accumulate);
+    FP fp_member(&accumulator, &Accumulator::add);
+    C c_static(accumulate);
+    C c_lambda(lambda);
+    C c_big(big);
+    const double fpStaticNs = ns_per_call_arg(fp_static);
+    const double fpMemberNs = ns_per_call_arg(fp_member);
+    const double cStaticNs = ns_per_call_arg(c_static);
+    const double cLambdaNs = ns_per_call_arg(c_lambda);
+    const double cBigNs = ns_per_call_arg(c_big);
+    TEST_ASSERT_EQUAL(2 * benchmarkIterations, (unsigned)accumulated);
+    TEST_ASSERT_EQUAL(3 * benchmarkIterations, (unsigned)accumulator.total);
+    printf("ns/call: FunctionPointer static %.2f, member %.2f; Callable static %.2f, lambda %.2f, allocated %.2f\r\n",
+           fpStaticNs, fpMemberNs, cStaticNs, cLambdaNs, cBigNs);
+
+    printf("ns/construction: FunctionPointer static %.2f, member copy %.2f; Callable static %.2f, lambda %.2f, allocated %.2f\r\n",
+           ns_per_construction<FP>(accumulate), ns_per_construction<FP>(fp_member),
+           ns_per_construction<C>(accumulate), ns_per_construction<C>(lambda),
+           ns_per_construction<C>(big));
+}
+#endif // defined(TARGET_LIKE_POSIX)
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("Callable  - test_static_and_lambda", test_static_and_lambda, greentea_failure_handler),
+    Case("Callable  - test_function_pointer_target", test_function_pointer_target, greentea_failure_handler),
+    Case("Callable  - test_inline_functor", test_inline_functor, greentea_failure_handler),
+    Case("Callable  - test_large_functor", test_large_functor, greentea_failure_handler),
+    Case("Callable  - test_pool_fallback", test_pool_fallback, greentea_failure_handler),
+#if defined(TARGET_LIKE_POSIX)
+    Case("Callable  - test_benchmark", test_benchmark, greentea_failure_handler),
+#endif
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
@@ -0,0 +1,229 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core-util/ConcurrentPriorityQueue.h"
+#include "greentea-client/test_env.h"
+#include "mbed-drivers/mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(TARGET_LIKE_POSIX)
+#include <pthread.h>
+#include <time.h>
+#endif
+
+using namespace utest::v1;
+using namespace mbed::util;
+
+template <typename Comparator>
+static void test_queue() {
+    const unsigned count = 256, num_queues = 4;
+    static bool seen[count];
+    ConcurrentPriorityQueue<unsigned, Comparator> queue;
+    UAllocTraits_t traits = {0};
+
+    TEST_ASSERT_FALSE(queue.init(1, 8, 8, traits));
+    TEST_ASSERT_TRUE(queue.init(num_queues, 8, 8, traits));
+    TEST_ASSERT_EQUAL(num_queues, queue.get_num_queues());
+    TEST_ASSERT_TRUE(queue.is_empty());
+
+    for (unsigned i = 0; i < count; i ++) {
+        seen[i] = false;
+        TEST_ASSERT_TRUE(queue.insert((i * 37) % count));
+    }
+    TEST_ASSERT_EQUAL(count, queue.get_num_elements());
+
+    // The order is relaxed, but every element comes out exactly once
+    unsigned e, popped = 0;
+    while (queue.pop_root(e)) {
+        TEST_ASSERT_TRUE(e < count);
+        TEST_ASSERT_FALSE(seen[e]);
+        seen[e] = true;
+        popped ++;
+    }
+    TEST_ASSERT_EQUAL(count, popped);
+    TEST_ASSERT_TRUE(queue.is_empty());
+    TEST_ASSERT_FALSE(queue.pop_root(e));
+}
+
+static void test_min_queue() {
+    test_queue<MinCompare<unsigned> >();
+}
+
+static void test_max_queue() {
+    test_queue<MaxCompare<unsigned> >();
+}
+
+static void test_single_element() {
+    ConcurrentPriorityQueue<int> queue;
+    UAllocTraits_t traits = {0};
+    int e = 0;
+
+    TEST_ASSERT_TRUE(queue.init(8, 1, 1, traits));
+    // pop_root() must find the element even if it is not in one of the randomly chosen heaps
+    for (int i = 0; i < 100; i ++) {
+        TEST_ASSERT_TRUE(queue.insert(i));
+        TEST_ASSERT_TRUE(queue.pop_root(e));
+        TEST_ASSERT_EQUAL(i, e);
+        TEST_ASSERT_TRUE(queue.is_empty());
+    }
+}
+
+#if defined(TARGET_LIKE_POSIX)
+static const unsigned max_threads = 4;
+static const unsigned per_thread = 20000;
+static ConcurrentPriorityQueue<unsigned> *shared_queue;
+static uint8_t popped[max_threads * per_thread];
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void run_threads(unsigned num_threads, void *(*body)(void *)) {
+    pthread_t threads[max_threads];
+    for (uintptr_t i = 0; i < num_threads; i ++) {
+        TEST_ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, body, (void*)i));
+    }
+    for (unsigned i = 0; i < num_threads; i ++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+static void *insert_values(void *arg) {
+    unsigned first = (unsigned)(uintptr_t)arg * per_thread;
+    for (unsigned i = 0; i < per_thread; i ++) {
+        shared_queue->insert(first + i);
+    }
+    return NULL;
+}
+
+static void *pop_values(void *) {
+    unsigned e;
+    while (shared_queue->pop_root(e)) {
+        atomic_fetch_add(&popped[e], (uint8_t)1, atomic_relaxed);
+    }
+    return NULL;
+}
+
+// Every element inserted by some thread is popped by exactly one thread
+static void test_threads() {
+    ConcurrentPriorityQueue<unsigned> queue;
+    UAllocTraits_t traits = {0};
+    TEST_ASSERT_TRUE(queue.init(2 * max_threads, 64, 256, traits));
+    shared_queue = &queue;
+    memset(popped, 0, sizeof(popped));
+
+    run_threads(max_threads, insert_values);
+    TEST_ASSERT_EQUAL(max_threads * per_thread, queue.get_num_elements());
+    run_threads(max_threads, pop_values);
+    TEST_ASSERT_TRUE(queue.is_empty());
+    for (unsigned i = 0; i < max_threads * per_thread; i ++) {
+        TEST_ASSERT_EQUAL(1, popped[i]);
+    }
+}
+
+// Baseline for the benchmark: one heap behind one lock
+static SpinLock single_lock;
+static BinaryHeap<unsigned, MinCompare<unsigned>, NullLock> *single_heap;
+
+static void *mixed_multiqueue(void *arg) {
+    unsigned e, x = (unsigned)(uintptr_t)arg + 1;
+    for (unsigned i = 0; i < per_thread; i ++) {
+        x = x * 1103515245 + 12345;
+        shared_queue->insert(x >> 8);
+        shared_queue->pop_root(e);
+    }
+    return NULL;
+}
+
+static void *mixed_single_heap(void *arg) {
+    unsigned x = (unsigned)(uintptr_t)arg + 1;
+    for (unsigned i = 0; i < per_thread; i ++) {
+        x = x * 1103515245 + 12345;
+        single_lock.lock();
+        single_heap->insert(x >> 8);
+        single_lock.unlock();
+        single_lock.lock();
+        if (!single_heap->is_empty()) {
+            single_heap->pop_root();
+        }
+        single_lock.unlock();
+    }
+    return NULL;
+}
+
+// Throughput of insert + pop pairs, for the MultiQueue and for a single locked BinaryHeap
+static void test_benchmark() {
+    UAllocTraits_t traits = {0};
+    for (unsigned num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        ConcurrentPriorityQueue<unsigned> queue;
+        TEST_ASSERT_TRUE(queue.init(2 * num_threads, 1024, 1024, traits));
+        BinaryHeap<unsigned, MinCompare<unsigned>, NullLock> heap;
+        TEST_ASSERT_TRUE(heap.init(1024, 1024, traits));
+        shared_queue = &queue;
+        single_heap = &heap;
+        // start from a non empty queue
+        for (unsigned i = 0; i < 1000; i ++) {
+            queue.insert(i);
+            heap.insert(i);
+        }
+
+        uint64_t start = now_ns();
+        run_threads(num_threads, mixed_multiqueue);
+        uint64_t multiqueue_ns = now_ns() - start;
+        start = now_ns();
+        run_threads(num_threads, mixed_single_heap);
+        uint64_t single_ns = now_ns() - start;
+
+        const double ops = 2.0 * num_threads * per_thread;
+        printf("%u threads: ConcurrentPriorityQueue %.0f ops/s, locked BinaryHeap %.0f ops/s\r\n",
+               num_threads, ops * 1e9 / multiqueue_ns, ops * 1e9 / single_ns);
+    }
+}
+#endif // defined(TARGET_LIKE_POSIX)
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("ConcurrentPriorityQueue  - test_min_queue", test_min_queue, greentea_failure_handler),
+    Case("ConcurrentPriorityQueue  - test_max_queue", test_max_queue, greentea_failure_handler),
+    Case("ConcurrentPriorityQueue  - test_single_element", test_single_element, greentea_failure_handler),
+#if defined(TARGET_LIKE_POSIX)
+    Case("ConcurrentPriorityQueue  - test_threads", test_threads, greentea_failure_handler),
+    Case("ConcurrentPriorityQueue  - test_benchmark", test_benchmark, greentea_failure_handler),
+#endif
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
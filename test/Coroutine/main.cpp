@@ -0,0 +1,316 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#if defined(TARGET_LIKE_POSIX)
+#include <time.h>
+#endif
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "core-util/Coroutine.h"
+
+using namespace utest::v1;
+
+#if CORE_UTIL_HAS_COROUTINES
+
+using namespace mbed::util;
+
+static const unsigned max_events = 8;
+static uint64_t event_memory[max_events * 16];
+static uint64_t timer_memory[max_events * 16];
+
+static const unsigned max_frames = 2;
+static const size_t frame_size = 512;
+static uint64_t frame_memory[max_frames * frame_size / sizeof(uint64_t)];
+
+static unsigned steps[16];
+static unsigned num_steps;
+
+static EventTask count_steps(EventQueue& queue, unsigned id, unsigned count) {
+    for (unsigned i = 0; i < count; i ++) {
+        steps[num_steps ++] = id * 10 + i;
+        co_await post_to(queue);
+    }
+}
+
+static EventTask wait_timers(TimerQueue& timers, unsigned id) {
+    co_await sleep_for(timers, 10);
+    steps[num_steps ++] = id;
+    co_await sleep_for(timers, 10);
+    steps[num_steps ++] = id + 1;
+}
+
+// Counts its live instances, to check that the locals of a coroutine are destroyed
+class Local {
+public:
+    Local() {
+        instances ++;
+    }
+
+    ~Local() {
+        instances --;
+    }
+
+    static unsigned instances;
+};
+
+unsigned Local::instances = 0;
+
+static EventTask wait_forever(EventQueue& queue, TimerQueue& timers) {
+    Local local;
+    co_await post_to(queue);
+    steps[num_steps ++] = 1;
+    co_await sleep_for(timers, 100);
+    steps[num_steps ++] = 2;
+}
+
+static void test_post_to() {
+    PoolAllocator event_pool(event_memory, max_events, EventQueue::get_node_size());
+    PoolAllocator frame_pool(frame_memory, max_frames, frame_size);
+    EventQueue queue(event_pool);
+    CoroutineFrameAllocator::set_pool(&frame_pool, frame_size);
+    num_steps = 0;
+
+    // each coroutine runs until its first co_await, then one step per dispatch()
+    TEST_ASSERT_TRUE(count_steps(queue, 1, 2));
+    TEST_ASSERT_TRUE(count_steps(queue, 2, 3));
+    TEST_ASSERT_EQUAL(2, num_steps);
+    // both frames were taken from the pool
+    TEST_ASSERT_EQUAL(NULL, frame_pool.alloc());
+
+    TEST_ASSERT_EQUAL(2, queue.dispatch());
+    TEST_ASSERT_EQUAL(4, num_steps);
+    // the first coroutine returned, freeing its frame
+    TEST_ASSERT_EQUAL(2, queue.dispatch());
+    TEST_ASSERT_EQUAL(5, num_steps);
+    TEST_ASSERT_EQUAL(1, queue.dispatch());
+    TEST_ASSERT_EQUAL(0, queue.dispatch());
+
+    const unsigned expected[] = {10, 20, 11, 21, 22};
+    for (unsigned i = 0; i < num_steps; i ++) {
+        TEST_ASSERT_EQUAL(expected[i], steps[i]);
+    }
+    void *frames[max_frames];
+    for (unsigned i = 0; i < max_frames; i ++) {
+        frames[i] = frame_pool.alloc();
+        TEST_ASSERT_NOT_EQUAL(NULL, frames[i]);
+    }
+    for (unsigned i = 0; i < max_frames; i ++) {
+        frame_pool.free(frames[i]);
+    }
+    CoroutineFrameAllocator::set_pool(NULL, 0);
+}
+
+static void test_sleep_for() {
+    UAllocTraits_t traits = {0};
+    PoolAllocator timer_pool(timer_memory, max_events, TimerQueue::get_node_size());
+    TimerQueue timers(timer_pool);
+    TEST_ASSERT_TRUE(timers.init(4, 4, traits));
+    num_steps = 0;
+
+    // frames from mbed_ualloc
+    TEST_ASSERT_TRUE(wait_timers(timers, 1));
+    TEST_ASSERT_EQUAL(0, timers.dispatch(9));
+    TEST_ASSERT_EQUAL(1, timers.dispatch(10));
+    TEST_ASSERT_EQUAL(1, num_steps);
+    TEST_ASSERT_EQUAL(0, timers.dispatch(19));
+    TEST_ASSERT_EQUAL(1, timers.dispatch(20));
+    TEST_ASSERT_EQUAL(2, num_steps);
+    TEST_ASSERT_EQUAL(1, steps[0]);
+    TEST_ASSERT_EQUAL(2, steps[1]);
+    TEST_ASSERT_EQUAL(0, timers.get_num_pending());
+}
+
+static void test_destroyed_queue() {
+    UAllocTraits_t traits = {0};
+    PoolAllocator event_pool(event_memory, max_events, EventQueue::get_node_size());
+    PoolAllocator timer_pool(timer_memory, max_events, TimerQueue::get_node_size());
+    PoolAllocator frame_pool(frame_memory, max_frames, frame_size);
+    CoroutineFrameAllocator::set_pool(&frame_pool, frame_size);
+    num_steps = 0;
+
+    // the frame is destroyed with the queue that held the Event resuming the coroutine
+    {
+        EventQueue queue(event_pool);
+        TimerQueue timers(timer_pool);
+        TEST_ASSERT_TRUE(wait_forever(queue, timers));
+        TEST_ASSERT_EQUAL(1, Local::instances);
+    }
+    TEST_ASSERT_EQUAL(0, Local::instances);
+    TEST_ASSERT_EQUAL(0, num_steps);
+
+    // same with a timer, after a step
+    {
+        EventQueue queue(event_pool);
+        TimerQueue timers(timer_pool);
+        TEST_ASSERT_TRUE(timers.init(4, 4, traits));
+        TEST_ASSERT_TRUE(wait_forever(queue, timers));
+        TEST_ASSERT_EQUAL(1, queue.dispatch());
+        TEST_ASSERT_EQUAL(1, num_steps);
+        TEST_ASSERT_EQUAL(1, timers.get_num_pending());
+        TEST_ASSERT_EQUAL(1, Local::instances);
+    }
+    TEST_ASSERT_EQUAL(0, Local::instances);
+    TEST_ASSERT_EQUAL(1, num_steps);
+
+    // both frames went back to the pool
+    void *frames[max_frames];
+    for (unsigned i = 0; i < max_frames; i ++) {
+        frames[i] = frame_pool.alloc();
+        TEST_ASSERT_NOT_EQUAL(NULL, frames[i]);
+    }
+    for (unsigned i = 0; i < max_frames; i ++) {
+        frame_pool.free(frames[i]);
+    }
+    CoroutineFrameAllocator::set_pool(NULL, 0);
+}
+
+#if defined(TARGET_LIKE_POSIX)
+
+/******************************************************************************
+ * Benchmark: the same chains of steps written as callbacks that re-post
+ * themselves and as coroutines that co_await post_to()
+ *****************************************************************************/
+
+static const unsigned bench_chains = 4;
+static const unsigned bench_steps = 20000;
+static uint64_t bench_event_memory[(bench_chains + 1) * 16];
+static uint64_t bench_frame_memory[bench_chains * frame_size / sizeof(uint64_t)];
+static unsigned bench_done;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// The state of a callback chain, which a coroutine keeps in its frame
+struct CallbackChain {
+    EventQueue *queue;
+    unsigned remaining;
+};
+
+static void callback_step(CallbackChain *chain) {
+    bench_done ++;
+    if (-- chain->remaining > 0) {
+        FunctionPointer1<void, CallbackChain*> fp(callback_step);
+        TEST_ASSERT_TRUE(chain->queue->post(fp.bind(chain)));
+    }
+}
+
+static EventTask coroutine_chain(EventQueue& queue, unsigned steps) {
+    for (unsigned i = 0; i < steps; i ++) {
+        bench_done ++;
+        co_await post_to(queue);
+    }
+}
+
+static uint64_t run_chains(EventQueue& queue) {
+    uint64_t start = now_ns();
+    while (!queue.is_empty()) {
+        queue.dispatch();
+    }
+    return now_ns() - start;
+}
+
+static void test_benchmark() {
+    printf("\r\n********** Starting test_benchmark **********\r\n");
+    PoolAllocator event_pool(bench_event_memory, bench_chains + 1, EventQueue::get_node_size());
+    PoolAllocator frame_pool(bench_frame_memory, bench_chains, frame_size);
+    EventQueue queue(event_pool);
+
+    // the state of the callback chains is static and the frames come from a pool, so neither
+    // side allocates from the heap and only the way the steps are resumed differs
+    static CallbackChain chains[bench_chains];
+    FunctionPointer1<void, CallbackChain*> fp(callback_step);
+    bench_done = 0;
+    uint64_t start = now_ns();
+    for (unsigned i = 0; i < bench_chains; i ++) {
+        chains[i].queue = &queue;
+        chains[i].remaining = bench_steps;
+        TEST_ASSERT_TRUE(queue.post(fp.bind(&chains[i])));
+    }
+    uint64_t callback_start_ns = now_ns() - start;
+    uint64_t callback_ns = run_chains(queue);
+    TEST_ASSERT_EQUAL(bench_chains * bench_steps, bench_done);
+
+    CoroutineFrameAllocator::set_pool(&frame_pool, frame_size);
+    bench_done = 0;
+    start = now_ns();
+    for (unsigned i = 0; i < bench_chains; i ++) {
+        TEST_ASSERT_TRUE(coroutine_chain(queue, bench_steps));
+    }
+    uint64_t coroutine_start_ns = now_ns() - start;
+    // all the frames came from the pool
+    TEST_ASSERT_EQUAL(NULL, frame_pool.alloc());
+    uint64_t coroutine_ns = run_chains(queue);
+    TEST_ASSERT_EQUAL(bench_chains * bench_steps, bench_done);
+    // ... and went back to it
+    void *frame = frame_pool.alloc();
+    TEST_ASSERT_NOT_EQUAL(NULL, frame);
+    frame_pool.free(frame);
+    CoroutineFrameAllocator::set_pool(NULL, 0);
+
+    printf("%u chains of %u steps\r\n", bench_chains, bench_steps);
+    printf("callbacks:  %.1f ns/step, %.1f ns to start a chain\r\n",
+           (double)callback_ns / (bench_chains * bench_steps), (double)callback_start_ns / bench_chains);
+    printf("coroutines: %.1f ns/step, %.1f ns to start a chain\r\n",
+           (double)coroutine_ns / (bench_chains * bench_steps), (double)coroutine_start_ns / bench_chains);
+}
+
+#endif // defined(TARGET_LIKE_POSIX)
+
+#else
+
+static void test_unsupported() {
+    printf("Coroutines are not supported by this compiler\r\n");
+}
+
+#endif // CORE_UTIL_HAS_COROUTINES
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+#if CORE_UTIL_HAS_COROUTINES
+    Case("Coroutine  - test_post_to", test_post_to, greentea_failure_handler),
+    Case("Coroutine  - test_sleep_for", test_sleep_for, greentea_failure_handler),
+    Case("Coroutine  - test_destroyed_queue", test_destroyed_queue, greentea_failure_handler),
+#if defined(TARGET_LIKE_POSIX)
+    Case("Coroutine  - test_benchmark", test_benchmark, greentea_failure_handler),
+#endif
+#else
+    Case("Coroutine  - test_unsupported", test_unsupported, greentea_failure_handler)
+#endif
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
@@ -0,0 +1,293 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "core-util/EventBatch.h"
+
+#if defined(TARGET_LIKE_POSIX)
+#include <stdio.h>
+#include <time.h>
+#endif
+
+using namespace utest::v1;
+using namespace mbed::util;
+
+typedef EventBatch<unsigned, int> Batch;
+
+static unsigned num_batches;
+static unsigned num_items;
+static int item_sum;
+static unsigned last_id;
+
+static void handle_batch(const Batch::ArgStruct *items, size_t count) {
+    num_batches ++;
+    for (size_t i = 0; i < count; i ++) {
+        // the calls are kept in order
+        TEST_ASSERT_EQUAL(last_id + 1, std::get<0>(items[i]));
+        last_id = std::get<0>(items[i]);
+        item_sum += std::get<1>(items[i]);
+    }
+    num_items += count;
+}
+
+static void reset_counters() {
+    num_batches = num_items = last_id = 0;
+    item_sum = 0;
+}
+
+static void test_add_and_flush() {
+    UAllocTraits_t traits = {0};
+    Batch batch(handle_batch);
+    TEST_ASSERT_FALSE(batch.init(0, traits));
+    TEST_ASSERT_TRUE(batch.init(4, traits));
+    TEST_ASSERT_FALSE(batch.init(4, traits));
+    TEST_ASSERT_EQUAL(4, batch.get_capacity());
+    reset_counters();
+
+    TEST_ASSERT_EQUAL(0, batch.flush());
+    TEST_ASSERT_EQUAL(0, num_batches);
+
+    for (unsigned i = 1; i <= 4; i ++) {
+        TEST_ASSERT_TRUE(batch.add(i, (int)i * 10));
+    }
+    TEST_ASSERT_FALSE(batch.add(5, 50));
+    TEST_ASSERT_EQUAL(4, batch.get_num_pending());
+
+    // one call to the handler for all the collected arguments
+    TEST_ASSERT_EQUAL(4, batch.flush());
+    TEST_ASSERT_EQUAL(1, num_batches);
+    TEST_ASSERT_EQUAL(100, item_sum);
+    TEST_ASSERT_EQUAL(0, batch.get_num_pending());
+
+    // the other buffer is used next, then the first one again
+    for (unsigned round = 0; round < 3; round ++) {
+        TEST_ASSERT_TRUE(batch.add(last_id + 1, 1));
+        TEST_ASSERT_TRUE(batch.add(last_id + 2, 1));
+        TEST_ASSERT_EQUAL(2, batch.flush());
+    }
+    TEST_ASSERT_EQUAL(4, num_batches);
+    TEST_ASSERT_EQUAL(10, num_items);
+}
+
+static const unsigned max_events = 4;
+static uint64_t memory[max_events * 16];
+
+static void test_coalescing() {
+    UAllocTraits_t traits = {0};
+    PoolAllocator pool(memory, max_events, EventQueue::get_node_size());
+    EventQueue queue(pool);
+    Batch batch(handle_batch, &queue);
+    TEST_ASSERT_TRUE(batch.init(100, traits));
+    reset_counters();
+
+    // many calls, one Event
+    for (unsigned i = 1; i <= 100; i ++) {
+        TEST_ASSERT_TRUE(batch.add(i, 1));
+    }
+    TEST_ASSERT_EQUAL(1, queue.dispatch());
+    TEST_ASSERT_EQUAL(1, num_batches);
+    TEST_ASSERT_EQUAL(100, num_items);
+    TEST_ASSERT_EQUAL(0, queue.dispatch());
+
+    // a new Event is posted after each flush
+    TEST_ASSERT_TRUE(batch.add(101, 1));
+    TEST_ASSERT_EQUAL(1, queue.dispatch());
+    TEST_ASSERT_EQUAL(2, num_batches);
+
+    // if the Event can't be posted, the next add() tries again
+    void *nodes[max_events];
+    for (unsigned i = 0; i < max_events; i ++) {
+        nodes[i] = pool.alloc();
+    }
+    TEST_ASSERT_TRUE(batch.add(102, 1));
+    TEST_ASSERT_TRUE(queue.is_empty());
+    for (unsigned i = 0; i < max_events; i ++) {
+        pool.free(nodes[i]);
+    }
+    TEST_ASSERT_TRUE(batch.add(103, 1));
+    TEST_ASSERT_EQUAL(1, queue.dispatch());
+    TEST_ASSERT_EQUAL(3, num_batches);
+    TEST_ASSERT_EQUAL(103, num_items);
+
+    // a full batch still tries to post the flush Event, or it would never be flushed
+    for (unsigned i = 0; i < max_events; i ++) {
+        nodes[i] = pool.alloc();
+    }
+    for (unsigned i = 104; i <= 203; i ++) {
+        TEST_ASSERT_TRUE(batch.add(i, 1));
+    }
+    TEST_ASSERT_TRUE(queue.is_empty());
+    for (unsigned i = 0; i < max_events; i ++) {
+        pool.free(nodes[i]);
+    }
+    TEST_ASSERT_FALSE(batch.add(204, 1));
+    TEST_ASSERT_EQUAL(1, queue.dispatch());
+    TEST_ASSERT_EQUAL(4, num_batches);
+    TEST_ASSERT_EQUAL(203, num_items);
+
+    // flush() leaves the Event in the queue, which must be dispatched before the batch is
+    // destroyed; it finds the batch empty
+    TEST_ASSERT_TRUE(batch.add(204, 1));
+    TEST_ASSERT_EQUAL(1, batch.flush());
+    TEST_ASSERT_FALSE(queue.is_empty());
+    TEST_ASSERT_EQUAL(1, queue.dispatch());
+    TEST_ASSERT_EQUAL(5, num_batches);
+    TEST_ASSERT_EQUAL(204, num_items);
+}
+
+// Arguments that are not trivially destructible are destroyed after the flush
+class Counted {
+public:
+    Counted() {
+        instances ++;
+    }
+
+    Counted(const Counted&) {
+        instances ++;
+    }
+
+    ~Counted() {
+        instances --;
+    }
+
+    static int instances;
+};
+
+int Counted::instances = 0;
+
+static void handle_counted(const std::tuple<Counted> *, size_t count) {
+    TEST_ASSERT_EQUAL(count, Counted::instances);
+}
+
+static void test_argument_lifetime() {
+    UAllocTraits_t traits = {0};
+    {
+        EventBatch<Counted> batch(handle_counted);
+        TEST_ASSERT_TRUE(batch.init(8, traits));
+        batch.add(Counted());
+        batch.add(Counted());
+        TEST_ASSERT_EQUAL(2, Counted::instances);
+        TEST_ASSERT_EQUAL(2, batch.flush());
+        TEST_ASSERT_EQUAL(0, Counted::instances);
+        batch.add(Counted());
+        TEST_ASSERT_EQUAL(1, Counted::instances);
+    }
+    TEST_ASSERT_EQUAL(0, Counted::instances);
+}
+
+#if defined(TARGET_LIKE_POSIX)
+static const unsigned bench_calls = 100000;
+static const unsigned bench_burst = 256;
+static uint64_t bench_memory[bench_burst * 16];
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void handle_one(unsigned id, int value) {
+    num_items ++;
+    last_id = id;
+    item_sum += value;
+}
+
+static void handle_many(const Batch::ArgStruct *items, size_t count) {
+    for (size_t i = 0; i < count; i ++) {
+        handle_one(std::get<0>(items[i]), std::get<1>(items[i]));
+    }
+}
+
+// Calls per second for bursts of calls posted to an EventQueue, one Event per call or
+// collected in an EventBatch. The time spent adding the calls and the time spent
+// dispatching them are measured separately: on POSIX the CriticalSectionLock taken by
+// add() costs two sigprocmask() calls, much more than on a microcontroller.
+static void test_benchmark() {
+    UAllocTraits_t traits = {0};
+    TEST_ASSERT_TRUE(PoolAllocator::get_pool_size(bench_burst, EventQueue::get_node_size()) <= sizeof(bench_memory));
+    PoolAllocator pool(bench_memory, bench_burst, EventQueue::get_node_size());
+    EventQueue queue(pool);
+    FunctionPointer2<void, unsigned, int> fp(handle_one);
+    const unsigned calls = (bench_calls + bench_burst - 1) / bench_burst * bench_burst;
+    uint64_t add_ns = 0, dispatch_ns = 0;
+    reset_counters();
+
+    for (unsigned i = 0; i < calls; i += bench_burst) {
+        uint64_t start = now_ns();
+        for (unsigned j = 0; j < bench_burst; j ++) {
+            queue.post(fp.bind(i + j, 1));
+        }
+        uint64_t middle = now_ns();
+        queue.dispatch();
+        dispatch_ns += now_ns() - middle;
+        add_ns += middle - start;
+    }
+    TEST_ASSERT_EQUAL(calls, num_items);
+    TEST_ASSERT_EQUAL(calls, last_id + 1);
+    printf("One Event per call: post() %.0f calls/s, dispatch() %.0f calls/s\r\n",
+           calls * 1e9 / add_ns, calls * 1e9 / dispatch_ns);
+
+    Batch batch(handle_many, &queue);
+    TEST_ASSERT_TRUE(batch.init(bench_burst, traits));
+    add_ns = dispatch_ns = 0;
+    reset_counters();
+    for (unsigned i = 0; i < calls; i += bench_burst) {
+        uint64_t start = now_ns();
+        for (unsigned j = 0; j < bench_burst; j ++) {
+            batch.add(i + j, 1);
+        }
+        uint64_t middle = now_ns();
+        queue.dispatch();
+        dispatch_ns += now_ns() - middle;
+        add_ns += middle - start;
+    }
+    TEST_ASSERT_EQUAL(calls, num_items);
+    TEST_ASSERT_EQUAL(calls, last_id + 1);
+    printf("EventBatch: add() %.0f calls/s, dispatch() %.0f calls/s\r\n",
+           calls * 1e9 / add_ns, calls * 1e9 / dispatch_ns);
+}
+#endif // defined(TARGET_LIKE_POSIX)
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(5, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("EventBatch  - test_add_and_flush", test_add_and_flush, greentea_failure_handler),
+    Case("EventBatch  - test_coalescing", test_coalescing, greentea_failure_handler),
+    Case("EventBatch  - test_argument_lifetime", test_argument_lifetime, greentea_failure_handler),
+#if defined(TARGET_LIKE_POSIX)
+    Case("EventBatch  - test_benchmark", test_benchmark, greentea_failure_handler),
+#endif
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
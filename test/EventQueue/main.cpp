@@ -0,0 +1,361 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <new>
+#include <utility>
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "core-util/EventQueue.h"
+#include "core-util/FunctionPointer.h"
+
+#if defined(TARGET_LIKE_POSIX)
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+using namespace utest::v1;
+using namespace mbed::util;
+
+static const unsigned max_events = 8;
+static uint64_t memory[max_events * 16];
+
+static unsigned calls[max_events * 2];
+static unsigned num_calls;
+
+static void record(unsigned id) {
+    calls[num_calls ++] = id;
+}
+
+static EventQueue *repost_queue;
+
+static void repost(unsigned id) {
+    record(id);
+    if (id > 0) {
+        repost_queue->post(FunctionPointer1<void, unsigned>(repost).bind(id - 1));
+    }
+}
+
+static void test_post_and_dispatch() {
+    TEST_ASSERT_TRUE(PoolAllocator::get_pool_size(max_events, EventQueue::get_node_size()) <= sizeof(memory));
+    PoolAllocator pool(memory, max_events, EventQueue::get_node_size());
+    EventQueue queue(pool);
+    FunctionPointer1<void, unsigned> fp(record);
+    num_calls = 0;
+
+    TEST_ASSERT_TRUE(queue.is_empty());
+    TEST_ASSERT_EQUAL(0, queue.dispatch());
+    TEST_ASSERT_FALSE(queue.post(Event()));
+
+    // the events are called in the order they were posted
+    for (unsigned i = 0; i < 3; i ++) {
+        TEST_ASSERT_TRUE(queue.post(fp.bind(i)));
+    }
+    TEST_ASSERT_FALSE(queue.is_empty());
+    TEST_ASSERT_EQUAL(3, queue.dispatch());
+    TEST_ASSERT_TRUE(queue.is_empty());
+    TEST_ASSERT_EQUAL(3, num_calls);
+    for (unsigned i = 0; i < 3; i ++) {
+        TEST_ASSERT_EQUAL(i, calls[i]);
+    }
+
+    // posting a copy leaves the original event alone
+    Event e(fp.bind(10));
+    TEST_ASSERT_TRUE(queue.post(e));
+    TEST_ASSERT_TRUE(e);
+    TEST_ASSERT_TRUE(queue.post(std::move(e)));
+    TEST_ASSERT_FALSE(e);
+    TEST_ASSERT_EQUAL(2, queue.dispatch());
+    TEST_ASSERT_EQUAL(5, num_calls);
+    TEST_ASSERT_EQUAL(10, calls[3]);
+    TEST_ASSERT_EQUAL(10, calls[4]);
+}
+
+static void test_batches() {
+    PoolAllocator pool(memory, max_events, EventQueue::get_node_size());
+    EventQueue queue(pool);
+    FunctionPointer1<void, unsigned> fp(record);
+    num_calls = 0;
+
+    // fill the pool
+    for (unsigned i = 0; i < max_events; i ++) {
+        TEST_ASSERT_TRUE(queue.post(fp.bind(i)));
+    }
+    TEST_ASSERT_FALSE(queue.post(fp.bind(max_events)));
+
+    // a limited dispatch leaves the rest of the events in order
+    TEST_ASSERT_EQUAL(3, queue.dispatch(3));
+    TEST_ASSERT_TRUE(queue.post(fp.bind(max_events)));
+    TEST_ASSERT_EQUAL(2, queue.dispatch(2));
+    TEST_ASSERT_EQUAL(max_events - 4, queue.dispatch());
+    TEST_ASSERT_EQUAL(max_events + 1, num_calls);
+    for (unsigned i = 0; i <= max_events; i ++) {
+        TEST_ASSERT_EQUAL(i, calls[i]);
+    }
+    TEST_ASSERT_TRUE(queue.is_empty());
+}
+
+static void test_repost() {
+    PoolAllocator pool(memory, max_events, EventQueue::get_node_size());
+    EventQueue queue(pool);
+    repost_queue = &queue;
+    num_calls = 0;
+
+    // events posted by dispatched events wait for the next dispatch()
+    TEST_ASSERT_TRUE(queue.post(FunctionPointer1<void, unsigned>(repost).bind(2)));
+    TEST_ASSERT_EQUAL(1, queue.dispatch());
+    TEST_ASSERT_EQUAL(1, queue.dispatch());
+    TEST_ASSERT_EQUAL(1, queue.dispatch());
+    TEST_ASSERT_EQUAL(0, queue.dispatch());
+    TEST_ASSERT_EQUAL(3, num_calls);
+    TEST_ASSERT_EQUAL(0, calls[2]);
+}
+
+static void test_destructor() {
+    PoolAllocator pool(memory, max_events, EventQueue::get_node_size());
+    FunctionPointer1<void, unsigned> fp(record);
+    num_calls = 0;
+    {
+        EventQueue queue(pool);
+        for (unsigned i = 0; i < max_events; i ++) {
+            TEST_ASSERT_TRUE(queue.post(fp.bind(i)));
+        }
+        TEST_ASSERT_EQUAL(1, queue.dispatch(1));
+    }
+    // the events left in the queue are not called, but their nodes are freed
+    TEST_ASSERT_EQUAL(1, num_calls);
+    void *nodes[max_events];
+    for (unsigned i = 0; i < max_events; i ++) {
+        nodes[i] = pool.alloc();
+        TEST_ASSERT_NOT_EQUAL(NULL, nodes[i]);
+    }
+    for (unsigned i = 0; i < max_events; i ++) {
+        pool.free(nodes[i]);
+    }
+}
+
+#if defined(TARGET_LIKE_POSIX)
+static const unsigned num_producers = 3;
+static const unsigned per_producer = 100000;
+static const unsigned shared_pool_events = 64;
+static uint64_t shared_memory[shared_pool_events * 16];
+static EventQueue *shared_queue;
+static uint8_t received[num_producers * per_producer];
+static unsigned last_received[num_producers];
+static unsigned num_received;
+static bool in_order;
+// Time spent in the post() calls that succeeded, per producer
+static uint64_t post_ns[num_producers];
+static uint64_t max_post_ns[num_producers];
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Called by the consumer only
+static void receive(unsigned id) {
+    unsigned producer = id / per_producer;
+    in_order = in_order && (last_received[producer] <= id);
+    last_received[producer] = id + 1;
+    received[id] ++;
+    num_received ++;
+}
+
+static void *produce(void *arg) {
+    unsigned producer = (unsigned)(uintptr_t)arg;
+    unsigned first = producer * per_producer;
+    FunctionPointer1<void, unsigned> fp(receive);
+    uint64_t total_ns = 0, max_ns = 0;
+    for (unsigned i = 0; i < per_producer; i ++) {
+        Event e(fp.bind(first + i));
+        while (true) {
+            uint64_t start = now_ns();
+            bool posted = shared_queue->post(std::move(e));
+            uint64_t elapsed = now_ns() - start;
+            if (posted) {
+                total_ns += elapsed;
+                max_ns = elapsed > max_ns ? elapsed : max_ns;
+                break;
+            }
+            // the pool is small, so it is often empty until the consumer catches up
+            sched_yield();
+        }
+    }
+    post_ns[producer] = total_ns;
+    max_post_ns[producer] = max_ns;
+    return NULL;
+}
+
+// Producers post from several threads while the consumer dispatches: every Event is called
+// exactly once, in posting order for each producer, and the pool nodes are reused many times
+static void test_threads() {
+    PoolAllocator pool(shared_memory, shared_pool_events, EventQueue::get_node_size());
+    EventQueue queue(pool);
+    shared_queue = &queue;
+    memset(received, 0, sizeof(received));
+    memset(last_received, 0, sizeof(last_received));
+    num_received = 0;
+    in_order = true;
+
+    pthread_t producers[num_producers];
+    uint64_t start = now_ns();
+    for (uintptr_t i = 0; i < num_producers; i ++) {
+        TEST_ASSERT_EQUAL(0, pthread_create(&producers[i], NULL, produce, (void*)i));
+    }
+    const unsigned total = num_producers * per_producer;
+    while (num_received < total) {
+        if (queue.dispatch() == 0)
+            sched_yield();
+    }
+    for (unsigned i = 0; i < num_producers; i ++) {
+        pthread_join(producers[i], NULL);
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    TEST_ASSERT_TRUE(in_order);
+    for (unsigned i = 0; i < total; i ++) {
+        TEST_ASSERT_EQUAL(1, received[i]);
+    }
+    TEST_ASSERT_TRUE(queue.is_empty());
+    // all the nodes went back to the pool
+    void *nodes[shared_pool_events];
+    for (unsigned i = 0; i < shared_pool_events; i ++) {
+        nodes[i] = pool.alloc();
+        TEST_ASSERT_NOT_EQUAL(NULL, nodes[i]);
+    }
+    TEST_ASSERT_EQUAL(NULL, pool.alloc());
+    for (unsigned i = 0; i < shared_pool_events; i ++) {
+        pool.free(nodes[i]);
+    }
+    uint64_t sum_ns = 0, max_ns = 0;
+    for (unsigned i = 0; i < num_producers; i ++) {
+        sum_ns += post_ns[i];
+        max_ns = max_post_ns[i] > max_ns ? max_post_ns[i] : max_ns;
+    }
+    printf("%u producers, %u events: %.0f events/s\r\n", num_producers, total, total * 1e9 / elapsed);
+    printf("post() latency: %.1f ns average, %.1f us worst case\r\n", (double)sum_ns / total, max_ns / 1000.0);
+}
+
+// The same Event with the virtual destructor that FunctionPointerBind used to have
+class VirtualEvent : public Event {
+public:
+    virtual ~VirtualEvent() {
+    }
+};
+
+static const unsigned ring_slots = 64;
+static const unsigned ring_rounds = 20000;
+static uint64_t ring[ring_slots][(sizeof(Event) + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+static unsigned ring_sum;
+
+static void add_to_ring_sum(unsigned value) {
+    ring_sum += value;
+}
+
+// sizeof(Event) with and without a vtable, and the cost of moving an Event in and out of an
+// EventQueue, of a ring buffer with move construction and of a ring buffer with memcpy
+static void test_benchmark_queues() {
+    PoolAllocator pool(shared_memory, shared_pool_events, EventQueue::get_node_size());
+    EventQueue queue(pool);
+    FunctionPointer1<void, unsigned> fp(add_to_ring_sum);
+    const unsigned total = ring_rounds * ring_slots;
+
+    ring_sum = 0;
+    uint64_t start = now_ns();
+    for (unsigned round = 0; round < ring_rounds; round ++) {
+        for (unsigned i = 0; i < ring_slots; i ++) {
+            queue.post(fp.bind(1));
+        }
+        queue.dispatch();
+    }
+    const uint64_t queue_ns = now_ns() - start;
+    TEST_ASSERT_EQUAL(total, ring_sum);
+
+    ring_sum = 0;
+    start = now_ns();
+    for (unsigned round = 0; round < ring_rounds; round ++) {
+        for (unsigned i = 0; i < ring_slots; i ++) {
+            new(ring[i]) Event(fp.bind(1));
+        }
+        for (unsigned i = 0; i < ring_slots; i ++) {
+            Event *e = reinterpret_cast<Event*>(ring[i]);
+            Event taken(std::move(*e));
+            e->~Event();
+            taken.call();
+        }
+    }
+    const uint64_t move_ns = now_ns() - start;
+    TEST_ASSERT_EQUAL(total, ring_sum);
+
+    // the bound argument is trivially copyable, so the Events can be relocated with memcpy
+    ring_sum = 0;
+    start = now_ns();
+    for (unsigned round = 0; round < ring_rounds; round ++) {
+        for (unsigned i = 0; i < ring_slots; i ++) {
+            Event e(fp.bind(1));
+            memcpy(ring[i], static_cast<void*>(&e), sizeof(Event));
+            new(&e) Event();
+        }
+        for (unsigned i = 0; i < ring_slots; i ++) {
+            Event *e = reinterpret_cast<Event*>(ring[i]);
+            e->call();
+            e->~Event();
+        }
+    }
+    const uint64_t memcpy_ns = now_ns() - start;
+    TEST_ASSERT_EQUAL(total, ring_sum);
+
+    printf("sizeof(Event): %u bytes, %u bytes with a vtable\r\n", (unsigned)sizeof(Event), (unsigned)sizeof(VirtualEvent));
+    printf("enqueue + dequeue: EventQueue %.1f ns, ring buffer with move %.1f ns, ring buffer with memcpy %.1f ns\r\n",
+           (double)queue_ns / total, (double)move_ns / total, (double)memcpy_ns / total);
+}
+#endif // defined(TARGET_LIKE_POSIX)
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("EventQueue  - test_post_and_dispatch", test_post_and_dispatch, greentea_failure_handler),
+    Case("EventQueue  - test_batches", test_batches, greentea_failure_handler),
+    Case("EventQueue  - test_repost", test_repost, greentea_failure_handler),
+    Case("EventQueue  - test_destructor", test_destructor, greentea_failure_handler),
+#if defined(TARGET_LIKE_POSIX)
+    Case("EventQueue  - test_threads", test_threads, greentea_failure_handler),
+    Case("EventQueue  - test_benchmark_queues", test_benchmark_queues, greentea_failure_handler),
+#endif
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
@@ -29,7 +29,7 @@ using namespace mbed::util;
 static bool check_value_and_alignment(void *p, unsigned alignment = MBED_UTIL_POOL_ALLOC_DEFAULT_ALIGN) {
     if (NULL == p)
         return false;
-    return ((uint32_t)p & (alignment - 1)) == 0;
+    return ((uintptr_t)p & (alignment - 1)) == 0;
 }
 
 static void test_extendable_pool_allocator() {
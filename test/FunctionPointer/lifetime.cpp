@@ -76,9 +76,10 @@ bool LifetimeChecker::_cc;
 int lifeCheck(LifetimeChecker lc) {
     int arg = lc.getArg();
     int instances = lc.getInstances();
-    lc.set(instances == 4);
-    if (instances != 4) {
-        printf("Expected 4 instances, got %i\r\n",instances);
+    // the original, the argument of FunctionPointer1::call() and the argument of lifeCheck()
+    lc.set(instances == 3);
+    if (instances != 3) {
+        printf("Expected 3 instances, got %i\r\n",instances);
     }
     return arg-1;
 }
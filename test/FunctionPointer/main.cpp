@@ -22,6 +22,10 @@
 #include "lifetime.hpp"
 #include "side_effects.hpp"
 
+#if defined(TARGET_LIKE_POSIX)
+#include <time.h>
+#endif
+
 using namespace utest::v1;
 
 namespace {
@@ -83,14 +87,236 @@ void test_function_pointer(void) {
     TEST_ASSERT_TRUE(result);
 }
 
+class Summer {
+public:
+    Summer(): total(0) {}
+
+    int add6(int a, int b, int c, int d, int e, int f) {
+        total = a + b + c + d + e + f;
+        return total;
+    }
+
+    int total;
+};
+
+int mul5(int a, int b, int c, int d, int e) {
+    return a * b * c * d * e;
+}
+
+void test_variadic_function_pointer(void) {
+    Summer summer;
+
+    // more than four arguments
+    mbed::util::VariadicFunctionPointer<int(int, int, int, int, int, int)> fp6(&summer, &Summer::add6);
+    TEST_ASSERT_EQUAL(21, fp6(1, 2, 3, 4, 5, 6));
+    TEST_ASSERT_EQUAL(21, summer.total);
+
+    mbed::util::VariadicFunctionPointer<int(int, int, int, int, int)> fp5(mul5);
+    TEST_ASSERT_EQUAL(120, fp5.call(1, 2, 3, 4, 5));
+    TEST_ASSERT_TRUE(fp5.get_function() == mul5);
+
+    // bound arguments
+    mbed::util::FunctionPointerBind<int> bound = fp6.bind(6, 5, 4, 3, 2, 1);
+    summer.total = 0;
+    TEST_ASSERT_EQUAL(21, bound());
+    TEST_ASSERT_EQUAL(21, summer.total);
+
+    // the numbered names are the same classes
+    mbed::util::FunctionPointer2<int, int, int> *fp2 = NULL;
+    mbed::util::VariadicFunctionPointer<int(int, int)> *fpv = fp2;
+    TEST_ASSERT_TRUE(fpv == NULL);
+}
+
+void test_fixed_target_function_pointer(void) {
+    Summer summer;
+
+    // member function known at compile time
+    mbed::util::VariadicFunctionPointer<int(int, int, int, int, int, int)> fp6;
+    fp6.attach<Summer, &Summer::add6>(&summer);
+    TEST_ASSERT_TRUE(fp6);
+    TEST_ASSERT_EQUAL(21, fp6(1, 2, 3, 4, 5, 6));
+    TEST_ASSERT_EQUAL(21, summer.total);
+    mbed::util::VariadicFunctionPointer<int(int, int, int, int, int, int)> other6(&summer, &Summer::add6);
+    TEST_ASSERT_TRUE(fp6 == other6);
+
+    // static function known at compile time
+    mbed::util::VariadicFunctionPointer<int(int, int, int, int, int)> fp5;
+    fp5.attach<&mul5>();
+    TEST_ASSERT_EQUAL(120, fp5.call(1, 2, 3, 4, 5));
+    TEST_ASSERT_TRUE(fp5.get_function() == mul5);
+    TEST_ASSERT_TRUE(fp5 == mbed::util::VariadicFunctionPointer<int(int, int, int, int, int)>(mul5));
+
+    // bound arguments and copies use the same caller
+    mbed::util::FunctionPointerBind<int> bound = fp6.bind(6, 5, 4, 3, 2, 1);
+    summer.total = 0;
+    TEST_ASSERT_EQUAL(21, bound());
+    TEST_ASSERT_EQUAL(21, summer.total);
+    mbed::util::VariadicFunctionPointer<int(int, int, int, int, int)> copy5(fp5);
+    TEST_ASSERT_EQUAL(32, copy5(2, 2, 2, 2, 2));
+}
+
+#if defined(TARGET_LIKE_POSIX)
+static const unsigned benchmarkIterations = 1000000;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+class Accumulator {
+public:
+    Accumulator(): total(0) {}
+
+    int add(int a) {
+        total += a;
+        return total;
+    }
+
+    int total;
+};
+
+static int accumulated = 0;
+
+int accumulate(int a) {
+    accumulated += a;
+    return accumulated;
+}
+
+// The barrier makes the compiler reload the function pointer before each call, so that the
+// call isn't resolved at compile time
+template <typename F>
+static double ns_per_call(F &fp) {
+    const uint64_t start = now_ns();
+    for (unsigned i = 0; i < benchmarkIterations; i++) {
+        __asm__ __volatile__("" : : "r"(&fp) : "memory");
+        fp();
+    }
+    return (double)(now_ns() - start) / benchmarkIterations;
+}
+
+template <typename F>
+static double ns_per_call_arg(F &fp) {
+    const uint64_t start = now_ns();
+    for (unsigned i = 0; i < benchmarkIterations; i++) {
+        __asm__ __volatile__("" : : "r"(&fp) : "memory");
+        fp(1);
+    }
+    return (double)(now_ns() - start) / benchmarkIterations;
+}
+
+// Cost of a call through each kind of attached target
+void test_benchmark_calls(void) {
+    Accumulator accumulator;
+
+    mbed::util::FunctionPointer1<int, int> fp_static(accumulate);
+    const double staticNs = ns_per_call_arg(fp_static);
+
+    mbed::util::FunctionPointer1<int, int> fp_member(&accumulator, &Accumulator::add);
+    const double memberNs = ns_per_call_arg(fp_member);
+
+    mbed::util::FunctionPointerBind<int> bound = fp_member.bind(1);
+    const double boundNs = ns_per_call(bound);
+
+    mbed::util::FunctionPointer1<int, int> fp_fixed_static;
+    fp_fixed_static.attach<&accumulate>();
+    const double fixedStaticNs = ns_per_call_arg(fp_fixed_static);
+
+    mbed::util::FunctionPointer1<int, int> fp_fixed_member;
+    fp_fixed_member.attach<Accumulator, &Accumulator::add>(&accumulator);
+    const double fixedMemberNs = ns_per_call_arg(fp_fixed_member);
+
+    mbed::util::FunctionPointerBind<int> fixed_bound = fp_fixed_member.bind(1);
+    const double fixedBoundNs = ns_per_call(fixed_bound);
+
+    TEST_ASSERT_EQUAL(2 * benchmarkIterations, (unsigned)accumulated);
+    TEST_ASSERT_EQUAL(4 * benchmarkIterations, (unsigned)accumulator.total);
+    printf("ns/call: static %.2f, member %.2f, bound %.2f\r\n", staticNs, memberNs, boundNs);
+    printf("ns/call: attach<&f> %.2f, attach<T, &T::m> %.2f, bound attach<T, &T::m> %.2f\r\n",
+           fixedStaticNs, fixedMemberNs, fixedBoundNs);
+}
+
+static int sum0() {
+    accumulated += 1;
+    return accumulated;
+}
+
+static int sum1(int a) {
+    accumulated += a;
+    return accumulated;
+}
+
+static int sum2(int a, int b) {
+    accumulated += a + b;
+    return accumulated;
+}
+
+static int sum3(int a, int b, int c) {
+    accumulated += a + b + c;
+    return accumulated;
+}
+
+static int sum4(int a, int b, int c, int d) {
+    accumulated += a + b + c + d;
+    return accumulated;
+}
+
+static int sum5(int a, int b, int c, int d, int e) {
+    accumulated += a + b + c + d + e;
+    return accumulated;
+}
+
+static int sum6(int a, int b, int c, int d, int e, int f) {
+    accumulated += a + b + c + d + e + f;
+    return accumulated;
+}
+
+template <typename F, typename... CallArgs>
+static double ns_per_call_args(F &fp, CallArgs... args) {
+    const uint64_t start = now_ns();
+    for (unsigned i = 0; i < benchmarkIterations; i++) {
+        __asm__ __volatile__("" : : "r"(&fp) : "memory");
+        fp(args...);
+    }
+    return (double)(now_ns() - start) / benchmarkIterations;
+}
+
+// Cost of call() and of a call through a FunctionPointerBind for 0 to 6 arguments
+template <typename F, typename... CallArgs>
+static void benchmark_arity(unsigned arity, F fp, CallArgs... args) {
+    accumulated = 0;
+    const double callNs = ns_per_call_args(fp, args...);
+    mbed::util::FunctionPointerBind<int> bound = fp.bind(args...);
+    const double boundNs = ns_per_call(bound);
+    TEST_ASSERT_EQUAL(2 * benchmarkIterations * (arity > 0 ? arity : 1), (unsigned)accumulated);
+    printf("%u arguments: call %.2f ns, bound %.2f ns\r\n", arity, callNs, boundNs);
+}
+
+void test_benchmark_arity(void) {
+    benchmark_arity(0, mbed::util::FunctionPointer0<int>(sum0));
+    benchmark_arity(1, mbed::util::FunctionPointer1<int, int>(sum1), 1);
+    benchmark_arity(2, mbed::util::FunctionPointer2<int, int, int>(sum2), 1, 1);
+    benchmark_arity(3, mbed::util::FunctionPointer3<int, int, int, int>(sum3), 1, 1, 1);
+    benchmark_arity(4, mbed::util::VariadicFunctionPointer<int(int, int, int, int)>(sum4), 1, 1, 1, 1);
+    benchmark_arity(5, mbed::util::VariadicFunctionPointer<int(int, int, int, int, int)>(sum5), 1, 1, 1, 1, 1);
+    benchmark_arity(6, mbed::util::VariadicFunctionPointer<int(int, int, int, int, int, int)>(sum6), 1, 1, 1, 1, 1, 1);
+}
+#endif
+
 static status_t test_setup(const size_t number_of_cases) {
-    GREENTEA_SETUP(10, "default_auto");
+    GREENTEA_SETUP(20, "default_auto");
 
     return greentea_test_setup_handler(number_of_cases);
 }
 
 static Case cases[] = {
-    Case("FunctionPointer  - test_function_pointer", test_function_pointer)
+    Case("FunctionPointer  - test_function_pointer", test_function_pointer),
+    Case("FunctionPointer  - test_variadic_function_pointer", test_variadic_function_pointer),
+    Case("FunctionPointer  - test_fixed_target_function_pointer", test_fixed_target_function_pointer),
+#if defined(TARGET_LIKE_POSIX)
+    Case("FunctionPointer  - test_benchmark_calls", test_benchmark_calls),
+    Case("FunctionPointer  - test_benchmark_arity", test_benchmark_arity),
+#endif
 };
 
 static Specification specification(test_setup, cases, greentea_test_teardown_handler);
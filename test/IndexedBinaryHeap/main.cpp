@@ -0,0 +1,173 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core-util/IndexedBinaryHeap.h"
+#include "greentea-client/test_env.h"
+#include "mbed-drivers/mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace utest::v1;
+using namespace mbed::util;
+
+typedef IndexedBinaryHeap<int> MinHeap;
+typedef IndexedBinaryHeap<int, MaxCompare<int> > MaxHeap;
+
+static void test_insert_remove_by_handle() {
+    int data[] = {20, 13, 8, 7, 100, -50, 0, 16, 1000, 2};
+    const unsigned data_size = sizeof(data) / sizeof(int);
+    MinHeap::Handle handles[data_size];
+    MinHeap heap;
+    UAllocTraits_t traits = {0};
+    TEST_ASSERT_TRUE(heap.init(4, 4, traits));
+
+    for (unsigned i = 0; i < data_size; i ++) {
+        handles[i] = heap.insert(data[i]);
+        TEST_ASSERT_TRUE(handles[i].is_valid());
+        TEST_ASSERT_TRUE(heap.is_consistent());
+    }
+    TEST_ASSERT_EQUAL(data_size, heap.get_num_elements());
+    for (unsigned i = 0; i < data_size; i ++) {
+        TEST_ASSERT_TRUE(heap.contains(handles[i]));
+        TEST_ASSERT_EQUAL(data[i], heap.get(handles[i]));
+    }
+
+    // Remove -50 (root), 100, 8 and 2 using their handles
+    unsigned to_remove[] = {5, 4, 2, 9};
+    for (unsigned i = 0; i < sizeof(to_remove) / sizeof(unsigned); i ++) {
+        TEST_ASSERT_TRUE(heap.remove(handles[to_remove[i]]));
+        TEST_ASSERT_FALSE(heap.contains(handles[to_remove[i]]));
+        TEST_ASSERT_TRUE(heap.is_consistent());
+    }
+    // Removing twice using the same handle fails
+    TEST_ASSERT_FALSE(heap.remove(handles[4]));
+    TEST_ASSERT_FALSE(heap.remove(MinHeap::Handle()));
+
+    int sorted_after_remove[] = {0, 7, 13, 16, 20, 1000};
+    TEST_ASSERT_EQUAL(sizeof(sorted_after_remove) / sizeof(int), heap.get_num_elements());
+    for (unsigned i = 0; i < sizeof(sorted_after_remove) / sizeof(int); i ++) {
+        TEST_ASSERT_EQUAL(sorted_after_remove[i], heap.pop_root());
+        TEST_ASSERT_TRUE(heap.is_consistent());
+    }
+    TEST_ASSERT_TRUE(heap.is_empty());
+}
+
+static void test_update() {
+    MaxHeap heap;
+    UAllocTraits_t traits = {0};
+    TEST_ASSERT_TRUE(heap.init(8, 8, traits));
+
+    MaxHeap::Handle h1 = heap.insert(10);
+    MaxHeap::Handle h2 = heap.insert(20);
+    MaxHeap::Handle h3 = heap.insert(30);
+    heap.insert(5);
+    heap.insert(25);
+    TEST_ASSERT_EQUAL(30, heap.get_root());
+    TEST_ASSERT_TRUE(heap.get_root_handle() == h3);
+
+    // Move an element up to the root
+    TEST_ASSERT_TRUE(heap.update(h1, 100));
+    TEST_ASSERT_TRUE(heap.is_consistent());
+    TEST_ASSERT_TRUE(heap.get_root_handle() == h1);
+
+    // Move the root down
+    TEST_ASSERT_TRUE(heap.update(h1, 1));
+    TEST_ASSERT_TRUE(heap.is_consistent());
+    TEST_ASSERT_EQUAL(30, heap.get_root());
+    TEST_ASSERT_EQUAL(1, heap.get(h1));
+
+    TEST_ASSERT_TRUE(heap.update(h2, 26));
+    TEST_ASSERT_TRUE(heap.is_consistent());
+
+    int sorted[] = {30, 26, 25, 5, 1};
+    for (unsigned i = 0; i < sizeof(sorted) / sizeof(int); i ++) {
+        TEST_ASSERT_EQUAL(sorted[i], heap.pop_root());
+        TEST_ASSERT_TRUE(heap.is_consistent());
+    }
+    // All the handles are stale now
+    TEST_ASSERT_FALSE(heap.update(h1, 0));
+    TEST_ASSERT_FALSE(heap.contains(h2));
+}
+
+static void test_stale_handles() {
+    MinHeap heap;
+    UAllocTraits_t traits = {0};
+    TEST_ASSERT_TRUE(heap.init(2, 2, traits));
+
+    // The slot used by 'h1' is reused by 'h2', but 'h1' must not refer to the new element
+    MinHeap::Handle h1 = heap.insert(1);
+    heap.remove_root();
+    MinHeap::Handle h2 = heap.insert(2);
+    TEST_ASSERT_TRUE(h1 != h2);
+    TEST_ASSERT_FALSE(heap.remove(h1));
+    TEST_ASSERT_TRUE(heap.contains(h2));
+    TEST_ASSERT_EQUAL(1, heap.get_num_elements());
+
+    // Randomized insert/remove/update against the heap invariants
+    const unsigned count = 200;
+    MinHeap::Handle handles[count];
+    for (unsigned i = 0; i < count; i ++) {
+        handles[i] = heap.insert(rand() % 1000);
+        TEST_ASSERT_TRUE(handles[i].is_valid());
+    }
+    for (unsigned i = 0; i < count; i += 3) {
+        TEST_ASSERT_TRUE(heap.remove(handles[i]));
+        TEST_ASSERT_TRUE(heap.update(handles[i + 1], rand() % 1000));
+    }
+    TEST_ASSERT_TRUE(heap.is_consistent());
+    int prev = heap.pop_root();
+    while (!heap.is_empty()) {
+        int crt = heap.pop_root();
+        TEST_ASSERT_TRUE(prev <= crt);
+        prev = crt;
+    }
+
+    // All the slots were freed, so they can all be reused
+    for (unsigned i = 0; i < count; i ++) {
+        handles[i] = heap.insert(i);
+        TEST_ASSERT_TRUE(handles[i].is_valid());
+    }
+    TEST_ASSERT_TRUE(heap.is_consistent());
+    for (unsigned i = 0; i < count; i ++) {
+        TEST_ASSERT_EQUAL(i, heap.get(handles[i]));
+    }
+}
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(5, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("IndexedBinaryHeap  - test_insert_remove_by_handle", test_insert_remove_by_handle, greentea_failure_handler),
+    Case("IndexedBinaryHeap  - test_update", test_update, greentea_failure_handler),
+    Case("IndexedBinaryHeap  - test_stale_handles", test_stale_handles, greentea_failure_handler)
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
@@ -0,0 +1,344 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "core-util/IntrusivePointer.h"
+#include "core-util/SharedPointer.h"
+
+#if defined(TARGET_LIKE_POSIX)
+#include <stdio.h>
+#include <time.h>
+#endif
+
+using namespace utest::v1;
+using namespace mbed::util;
+
+template <class RefCount>
+class Message : public RefCounted<RefCount> {
+public:
+    Message(int _id): id(_id) {
+        liveObjects++;
+    }
+
+    ~Message() {
+        liveObjects--;
+    }
+
+    int id;
+
+    static int liveObjects;
+};
+
+template <class RefCount>
+int Message<RefCount>::liveObjects = 0;
+
+template <class RefCount>
+static void test_intrusive_pointer() {
+    typedef Message<RefCount> Msg;
+    typedef IntrusivePointer<Msg> MsgPointer;
+
+    // a single word
+    TEST_ASSERT_EQUAL(sizeof(Msg*), sizeof(MsgPointer));
+
+    {
+        MsgPointer empty;
+        TEST_ASSERT_FALSE(empty);
+        TEST_ASSERT_EQUAL(0, empty.use_count());
+
+        Msg *raw = new Msg(1);
+        MsgPointer ptr1(raw);
+        TEST_ASSERT_EQUAL(raw, ptr1.get());
+        TEST_ASSERT_EQUAL(1, ptr1.use_count());
+        TEST_ASSERT_EQUAL(1, ptr1->id);
+
+        // copies share the counter inside the object
+        MsgPointer ptr2 = ptr1;
+        TEST_ASSERT_TRUE(ptr1 == ptr2);
+        TEST_ASSERT_EQUAL(2, raw->use_count());
+
+        // a new IntrusivePointer can be made from the raw pointer
+        MsgPointer ptr3(raw);
+        TEST_ASSERT_EQUAL(3, raw->use_count());
+
+        // moving doesn't change the counter
+        MsgPointer ptr4(std::move(ptr3));
+        TEST_ASSERT_FALSE(ptr3);
+        TEST_ASSERT_EQUAL(3, raw->use_count());
+
+        // self assignment
+        ptr4 = ptr4;
+        TEST_ASSERT_EQUAL(3, raw->use_count());
+
+        MsgPointer ptr5(new Msg(2));
+        TEST_ASSERT_EQUAL(2, Msg::liveObjects);
+        ptr5 = ptr4;
+        TEST_ASSERT_EQUAL(1, Msg::liveObjects);
+        TEST_ASSERT_EQUAL(4, raw->use_count());
+
+        ptr5.reset();
+        ptr4.reset();
+        ptr2.reset();
+        TEST_ASSERT_EQUAL(1, raw->use_count());
+        TEST_ASSERT_EQUAL(1, Msg::liveObjects);
+    }
+
+    TEST_ASSERT_EQUAL(0, Msg::liveObjects);
+}
+
+static void test_plain_count() {
+    test_intrusive_pointer<SharedPointerPlainCount>();
+}
+
+static void test_atomic_count() {
+    test_intrusive_pointer<SharedPointerAtomicCount>();
+}
+
+// A list node that owns the next one
+class Node : public RefCounted<SharedPointerPlainCount> {
+public:
+    Node(int _value): value(_value) {
+        liveNodes++;
+    }
+
+    ~Node() {
+        liveNodes--;
+    }
+
+    int value;
+    IntrusivePointer<Node> next;
+    static int liveNodes;
+};
+
+int Node::liveNodes = 0;
+
+// Assigning from an IntrusivePointer that is owned by the object being released
+static void test_assign_from_owned() {
+    {
+        IntrusivePointer<Node> list;
+        for (int i = 3; i > 0; i--) {
+            IntrusivePointer<Node> node(new Node(i));
+            node->next = list;
+            list = node;
+        }
+        TEST_ASSERT_EQUAL(3, Node::liveNodes);
+        list = list->next;
+        TEST_ASSERT_EQUAL(2, Node::liveNodes);
+        TEST_ASSERT_EQUAL(2, list->value);
+        TEST_ASSERT_EQUAL(1, list.use_count());
+
+        list = std::move(list->next);
+        TEST_ASSERT_EQUAL(1, Node::liveNodes);
+        TEST_ASSERT_EQUAL(3, list->value);
+        TEST_ASSERT_EQUAL(1, list.use_count());
+
+        // self move assignment keeps the reference
+        IntrusivePointer<Node> &alias = list;
+        list = std::move(alias);
+        TEST_ASSERT_EQUAL(3, list->value);
+        TEST_ASSERT_EQUAL(1, list.use_count());
+    }
+    TEST_ASSERT_EQUAL(0, Node::liveNodes);
+}
+
+typedef Message<SharedPointerPlainCount> PoolMessage;
+static const unsigned poolElements = 4;
+static uint64_t poolMemory[poolElements * ((sizeof(PoolMessage) + 7) / 8)];
+PoolAllocator messagePool(poolMemory, poolElements, sizeof(PoolMessage));
+
+static void test_pool_delete() {
+    typedef IntrusivePointer<PoolMessage, IntrusivePoolDelete<PoolAllocator, &messagePool> > MsgPointer;
+
+    {
+        MsgPointer ptrs[poolElements];
+        for (unsigned i = 0; i < poolElements; i++) {
+            void *mem = messagePool.alloc();
+            TEST_ASSERT_NOT_EQUAL(NULL, mem);
+            ptrs[i] = MsgPointer(new(mem) PoolMessage(i));
+        }
+        TEST_ASSERT_EQUAL(NULL, messagePool.alloc());
+
+        // the last reference returns the object to the pool
+        MsgPointer copy = ptrs[0];
+        ptrs[0].reset();
+        TEST_ASSERT_EQUAL(NULL, messagePool.alloc());
+        copy.reset();
+        TEST_ASSERT_EQUAL(poolElements - 1, PoolMessage::liveObjects);
+        void *mem = messagePool.alloc();
+        TEST_ASSERT_NOT_EQUAL(NULL, mem);
+        messagePool.free(mem);
+    }
+
+    TEST_ASSERT_EQUAL(0, PoolMessage::liveObjects);
+}
+
+#if defined(TARGET_LIKE_POSIX)
+static const unsigned benchmarkIterations = 200000;
+static const unsigned benchmarkObjects = 1 << 17;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// The SharedPointer counterpart of Message, without the embedded counter
+class Payload {
+public:
+    Payload(int _id): id(_id) {
+    }
+
+    int id;
+};
+
+template <class Pointer>
+static uint64_t copyLoopNs(const Pointer& source) {
+    uint64_t start = now_ns();
+    for (unsigned i = 0; i < benchmarkIterations; i++) {
+        Pointer copy = source;
+        // compiler barrier, keeps the increment and decrement pair from being optimized out
+        __asm__ __volatile__("" : : "r"(&copy) : "memory");
+    }
+    return now_ns() - start;
+}
+
+// Shuffles the pointers, so that walking the array visits the objects in a random order
+template <class Pointer>
+static void shuffle(Pointer *ptrs, unsigned count) {
+    uint32_t seed = 12345;
+    for (unsigned i = count - 1; i > 0; i--) {
+        seed = seed * 1103515245 + 12345;
+        unsigned j = (seed >> 8) % (i + 1);
+        Pointer tmp(std::move(ptrs[i]));
+        ptrs[i] = std::move(ptrs[j]);
+        ptrs[j] = std::move(tmp);
+    }
+}
+
+// Copies every pointer of the array and reads the object: with more objects than fit in the
+// cache, the time is dominated by the cache lines each copy touches
+template <class Pointer>
+static uint64_t walkNs(const Pointer *ptrs, unsigned count) {
+    unsigned sum = 0;
+    uint64_t start = now_ns();
+    for (unsigned i = 0; i < count; i++) {
+        Pointer copy = ptrs[i];
+        sum += copy->id;
+        __asm__ __volatile__("" : : "r"(&copy) : "memory");
+    }
+    const uint64_t elapsed = now_ns() - start;
+    TEST_ASSERT_EQUAL((unsigned)((uint64_t)count * (count - 1) / 2), sum);
+    return elapsed;
+}
+
+template <class Pointer>
+static double walkNsPerObject(Pointer *ptrs) {
+    shuffle(ptrs, benchmarkObjects);
+    // the first walk brings whatever fits in the cache, the second one is measured
+    walkNs(ptrs, benchmarkObjects);
+    const uint64_t ns = walkNs(ptrs, benchmarkObjects);
+    for (unsigned i = 0; i < benchmarkObjects; i++) {
+        ptrs[i] = Pointer();
+    }
+    return (double)ns / benchmarkObjects;
+}
+
+// Size, copy/destroy cost and cache behaviour of IntrusivePointer against SharedPointer with a
+// separate counter (SharedPointer(new T)) and with the counter next to the object (make_shared)
+template <class RefCount>
+static void benchmark() {
+    typedef Message<RefCount> Msg;
+    typedef IntrusivePointer<Msg> MsgPointer;
+    typedef SharedPointer<Payload, RefCount> PayloadPointer;
+
+    printf("pointer size: IntrusivePointer %u bytes, SharedPointer %u bytes\r\n",
+           (unsigned)sizeof(MsgPointer), (unsigned)sizeof(PayloadPointer));
+
+    {
+        MsgPointer intrusive(new Msg(0));
+        PayloadPointer separate(new Payload(0));
+        PayloadPointer inplace = make_shared<Payload, RefCount>(0);
+        const uint64_t intrusiveNs = copyLoopNs(intrusive);
+        const uint64_t separateNs = copyLoopNs(separate);
+        const uint64_t inplaceNs = copyLoopNs(inplace);
+        printf("copy/destroy: IntrusivePointer %.1f ns, SharedPointer(new) %.1f ns, make_shared %.1f ns\r\n",
+               (double)intrusiveNs / benchmarkIterations, (double)separateNs / benchmarkIterations,
+               (double)inplaceNs / benchmarkIterations);
+    }
+
+    MsgPointer *intrusive = new MsgPointer[benchmarkObjects];
+    for (unsigned i = 0; i < benchmarkObjects; i++) {
+        intrusive[i] = MsgPointer(new Msg(i));
+    }
+    const double intrusiveNs = walkNsPerObject(intrusive);
+    delete[] intrusive;
+    TEST_ASSERT_EQUAL(0, Msg::liveObjects);
+
+    PayloadPointer *shared = new PayloadPointer[benchmarkObjects];
+    for (unsigned i = 0; i < benchmarkObjects; i++) {
+        shared[i] = PayloadPointer(new Payload(i));
+    }
+    const double separateNs = walkNsPerObject(shared);
+    for (unsigned i = 0; i < benchmarkObjects; i++) {
+        shared[i] = make_shared<Payload, RefCount>(i);
+    }
+    const double inplaceNs = walkNsPerObject(shared);
+    delete[] shared;
+
+    printf("random walk over %u objects: IntrusivePointer %.1f ns, SharedPointer(new) %.1f ns, make_shared %.1f ns\r\n",
+           benchmarkObjects, intrusiveNs, separateNs, inplaceNs);
+}
+
+static void test_benchmark_plain() {
+    benchmark<SharedPointerPlainCount>();
+}
+
+static void test_benchmark_atomic() {
+    benchmark<SharedPointerAtomicCount>();
+}
+#endif // defined(TARGET_LIKE_POSIX)
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("IntrusivePointer  - test_plain_count", test_plain_count, greentea_failure_handler),
+    Case("IntrusivePointer  - test_atomic_count", test_atomic_count, greentea_failure_handler),
+    Case("IntrusivePointer  - test_pool_delete", test_pool_delete, greentea_failure_handler),
+    Case("IntrusivePointer  - test_assign_from_owned", test_assign_from_owned, greentea_failure_handler),
+#if defined(TARGET_LIKE_POSIX)
+    Case("IntrusivePointer  - test_benchmark_plain", test_benchmark_plain, greentea_failure_handler),
+    Case("IntrusivePointer  - test_benchmark_atomic", test_benchmark_atomic, greentea_failure_handler),
+#endif
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
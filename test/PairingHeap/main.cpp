@@ -0,0 +1,145 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core-util/PairingHeap.h"
+#include "greentea-client/test_env.h"
+#include "mbed-drivers/mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace utest::v1;
+using namespace mbed::util;
+
+template<typename T, typename Compare>
+static void test_heap(const T* data, unsigned data_size, const T* sorted_data) {
+    PairingHeap<T, Compare> heap;
+    UAllocTraits_t traits = {0};
+    TEST_ASSERT_TRUE(heap.init(data_size / 2, data_size / 2, traits));
+
+    for (int pass = 0; pass < 2; pass ++) {
+        for (unsigned i = 0; i < data_size; i++) {
+            TEST_ASSERT_TRUE(heap.insert(data[i]));
+        }
+        TEST_ASSERT_EQUAL(data_size, heap.get_num_elements());
+        for (unsigned i = 0; i < data_size; i ++) {
+            TEST_ASSERT_TRUE(heap.get_root() == sorted_data[i]);
+            TEST_ASSERT_TRUE(heap.pop_root() == sorted_data[i]);
+        }
+        TEST_ASSERT_TRUE(heap.is_empty());
+    }
+    // Leave some elements in the heap, the destructor must destroy them
+    for (unsigned i = 0; i < data_size; i++) {
+        heap.insert(data[i]);
+    }
+    heap.remove_root();
+}
+
+static void test_min_heap_pod() {
+    int data[] = {20, 13, 8, 7, 100, -50, 0, 16, 1000, 2};
+    int sorted_data[] = {-50, 0, 2, 7, 8, 13, 16, 20, 100, 1000};
+
+    test_heap<int, MinCompare<int> >(data, sizeof(data)/sizeof(int), sorted_data);
+}
+
+static void test_max_heap_pod() {
+    unsigned data[] = {53, 0, 21, 19, 77, 123, 81, 0, 1001, 66, 17, 5};
+    unsigned sorted_data[] = {1001, 123, 81, 77, 66, 53, 21, 19, 17, 5, 0, 0};
+
+    test_heap<unsigned, MaxCompare<unsigned> >(data, sizeof(data)/sizeof(unsigned), sorted_data);
+}
+
+struct Test {
+    Test(int a = 0): _a(a) {
+        inst_count ++;
+    }
+
+    Test(const Test& t): _a(t._a) {
+        inst_count ++;
+    }
+
+    ~Test() {
+        inst_count --;
+    }
+
+    bool operator ==(const Test& t) const {
+        return t._a == _a;
+    }
+
+    bool operator <=(const Test& t) const {
+        return _a <= t._a;
+    }
+
+    int _a;
+    static int inst_count;
+};
+int Test::inst_count = 0;
+
+static void test_min_heap_non_pod() {
+    {
+    Test data[] = {291, 62, 364, 63, 753, 325, -382, -736, -930, -927, 734, -591, 136, 753, 576, -59, -930, -700, -380, 764};
+    Test sorted_data[] = {-930, -930, -927, -736, -700, -591, -382, -380, -59, 62, 63, 136, 291, 325, 364, 576, 734, 753, 753, 764};
+
+    test_heap<Test, MinCompare<Test> >(data, sizeof(data)/sizeof(Test), sorted_data);
+    }
+    TEST_ASSERT_EQUAL(0, Test::inst_count);
+}
+
+static void test_random() {
+    PairingHeap<unsigned> heap;
+    UAllocTraits_t traits = {0};
+    TEST_ASSERT_TRUE(heap.init(64, 64, traits));
+
+    // Interleave inserts and removals, checking the order of the removed elements
+    for (unsigned i = 0; i < 500; i ++) {
+        heap.insert(rand() % 10000);
+        if (i % 3 == 0) {
+            heap.remove_root();
+        }
+    }
+    unsigned prev = heap.pop_root();
+    while (!heap.is_empty()) {
+        unsigned crt = heap.pop_root();
+        TEST_ASSERT_TRUE(prev <= crt);
+        prev = crt;
+    }
+}
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(5, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("PairingHeap  - test_min_heap_pod", test_min_heap_pod, greentea_failure_handler),
+    Case("PairingHeap  - test_max_heap_pod", test_max_heap_pod, greentea_failure_handler),
+    Case("PairingHeap  - test_min_heap_non_pod", test_min_heap_non_pod, greentea_failure_handler),
+    Case("PairingHeap  - test_random", test_random, greentea_failure_handler)
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
@@ -21,6 +21,12 @@
 #include "utest/utest.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(TARGET_LIKE_POSIX)
+#include <pthread.h>
+#include <sys/mman.h>
+#endif
 
 using namespace utest::v1;
 using namespace mbed::util;
@@ -42,10 +48,10 @@ void test_pool_allocator() {
         p = allocator.alloc();
         TEST_ASSERT_TRUE(p != NULL);
         // Check alignment
-        TEST_ASSERT_EQUAL(0, ((uint32_t)p & (MBED_UTIL_POOL_ALLOC_DEFAULT_ALIGN - 1)));
+        TEST_ASSERT_EQUAL(0, ((uintptr_t)p & (MBED_UTIL_POOL_ALLOC_DEFAULT_ALIGN - 1)));
         // Check spacing
         if (i > 0) {
-            TEST_ASSERT_EQUAL(aligned_size, ((uint32_t)p - (uint32_t)prev));
+            TEST_ASSERT_EQUAL(aligned_size, ((uintptr_t)p - (uintptr_t)prev));
         } else {
             first = p;
             TEST_ASSERT_EQUAL(start, p);
@@ -65,16 +71,132 @@ void test_pool_allocator() {
     TEST_ASSERT_EQUAL(first, p);
     p = allocator.alloc();
     TEST_ASSERT_EQUAL(NULL, p);
+    free(start);
+}
+
+void test_calloc() {
+    const size_t elements = 2, element_size = 24;
+    uint64_t memory[elements * element_size / sizeof(uint64_t)];
+    memset(memory, 0xFF, sizeof(memory));
+    PoolAllocator allocator(memory, elements, element_size);
+
+    // the element is returned, cleared
+    uint8_t *p = (uint8_t*)allocator.calloc();
+    TEST_ASSERT_TRUE(p == (uint8_t*)memory);
+    for (size_t i = 0; i < element_size; i ++) {
+        TEST_ASSERT_EQUAL(0, p[i]);
+    }
+    // the next element is untouched, except for its free list link
+    TEST_ASSERT_EQUAL(0xFF, p[element_size + sizeof(uint32_t)]);
+}
+
+void test_large_pool() {
+#if defined(TARGET_LIKE_POSIX)
+    if (sizeof(void*) < 8) {
+        printf("32 bit host, skipping\r\n");
+        return;
+    }
+    // Pool of more than 4GB in a reserved virtual region. Only the first word of
+    // each element is written, so only a few pages are actually used.
+    const size_t elements = 4200, element_size = 1024 * 1024;
+    const size_t pool_size = PoolAllocator::get_pool_size(elements, element_size);
+    TEST_ASSERT_TRUE(pool_size == (size_t)elements * element_size);
+    TEST_ASSERT_TRUE(pool_size > 0x100000000ULL);
+    void *start = mmap(NULL, pool_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (start == MAP_FAILED) {
+        printf("Can't reserve %lu bytes, skipping\r\n", (unsigned long)pool_size);
+        return;
+    }
+    TEST_ASSERT_TRUE(PoolAllocator::align_up(0x100000001ULL, 8) == 0x100000008ULL);
+
+    {
+        PoolAllocator allocator(start, elements, element_size);
+        void *p = NULL;
+        for (size_t i = 0; i < elements; i ++) {
+            p = allocator.alloc();
+            TEST_ASSERT_TRUE(p != NULL);
+        }
+        TEST_ASSERT_TRUE(allocator.alloc() == NULL);
+        // the last element is past the 4GB boundary
+        TEST_ASSERT_TRUE((uint8_t*)p == (uint8_t*)start + (elements - 1) * element_size);
+        TEST_ASSERT_TRUE((uintptr_t)p - (uintptr_t)start > 0xFFFFFFFFULL);
+        TEST_ASSERT_TRUE(allocator.owns(p));
+        allocator.free(p);
+        TEST_ASSERT_TRUE(allocator.alloc() == p);
+    }
+    TEST_ASSERT_TRUE(PoolAllocator::get_max_elements() >= 0xFFFF);
+    TEST_ASSERT_TRUE(elements <= PoolAllocator::get_max_elements());
+    munmap(start, pool_size);
+#endif
+}
+
+#if defined(TARGET_LIKE_POSIX)
+static const unsigned num_threads = 4;
+static const unsigned per_thread = 100000;
+static const size_t held_per_thread = 2;
+static const size_t thread_element_size = 32;
+static PoolAllocator *shared_pool;
+static unsigned shared_errors[num_threads];
+
+// Allocate and free elements as fast as possible, checking that no other thread gets an
+// element while this one holds it (which is what a free list with an ABA problem does)
+static void *alloc_free(void *arg) {
+    unsigned id = (unsigned)(uintptr_t)arg;
+    unsigned errors = 0;
+    for (unsigned i = 0; i < per_thread; i ++) {
+        uint8_t *held[held_per_thread];
+        for (size_t j = 0; j < held_per_thread; j ++) {
+            while ((held[j] = (uint8_t*)shared_pool->alloc()) == NULL) {
+            }
+            memset(held[j], id, thread_element_size);
+        }
+        for (size_t j = 0; j < held_per_thread; j ++) {
+            for (size_t k = 0; k < thread_element_size; k ++) {
+                if (held[j][k] != id)
+                    errors ++;
+            }
+            shared_pool->free(held[j]);
+        }
+    }
+    shared_errors[id] = errors;
+    return NULL;
+}
+#endif
+
+void test_threads() {
+#if defined(TARGET_LIKE_POSIX)
+    const size_t elements = num_threads * held_per_thread;
+    uint64_t memory[elements * thread_element_size / sizeof(uint64_t)];
+    PoolAllocator allocator(memory, elements, thread_element_size);
+    shared_pool = &allocator;
+
+    pthread_t threads[num_threads];
+    for (uintptr_t i = 0; i < num_threads; i ++) {
+        TEST_ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, alloc_free, (void*)i));
+    }
+    for (unsigned i = 0; i < num_threads; i ++) {
+        pthread_join(threads[i], NULL);
+        TEST_ASSERT_EQUAL(0, shared_errors[i]);
+    }
+    // every element is back in the pool, exactly once
+    for (size_t i = 0; i < elements; i ++) {
+        TEST_ASSERT_TRUE(allocator.alloc() != NULL);
+    }
+    TEST_ASSERT_TRUE(allocator.alloc() == NULL);
+#endif
 }
 
 static status_t test_setup(const size_t number_of_cases) {
-    GREENTEA_SETUP(5, "default_auto");
+    GREENTEA_SETUP(20, "default_auto");
 
     return greentea_test_setup_handler(number_of_cases);
 }
 
 static Case cases[] = {
-    Case("PoolAllocator  - test_pool_allocator", test_pool_allocator)
+    Case("PoolAllocator  - test_pool_allocator", test_pool_allocator),
+    Case("PoolAllocator  - test_calloc", test_calloc),
+    Case("PoolAllocator  - test_large_pool", test_large_pool),
+    Case("PoolAllocator  - test_threads", test_threads)
 };
 
 static Specification specification(test_setup, cases, greentea_test_teardown_handler);
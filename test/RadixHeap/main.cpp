@@ -0,0 +1,192 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core-util/RadixHeap.h"
+#include "core-util/BinaryHeap.h"
+#include "core-util/PairingHeap.h"
+#include "greentea-client/test_env.h"
+#include "mbed-drivers/mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(TARGET_LIKE_POSIX)
+#include <time.h>
+#endif
+
+using namespace utest::v1;
+using namespace mbed::util;
+
+static void test_radix_heap_pod() {
+    uint32_t data[] = {20, 13, 8, 7, 100, 50, 0, 16, 1000, 2, 0xFFFFFFFFUL, 8};
+    uint32_t sorted_data[] = {0, 2, 7, 8, 8, 13, 16, 20, 50, 100, 1000, 0xFFFFFFFFUL};
+    const unsigned data_size = sizeof(data)/sizeof(uint32_t);
+    RadixHeap<uint32_t> heap;
+    UAllocTraits_t traits = {0};
+
+    TEST_ASSERT_TRUE(heap.init(4, 4, traits));
+    for (unsigned i = 0; i < data_size; i ++) {
+        TEST_ASSERT_TRUE(heap.insert(data[i]));
+    }
+    TEST_ASSERT_EQUAL(data_size, heap.get_num_elements());
+    for (unsigned i = 0; i < data_size; i ++) {
+        TEST_ASSERT_EQUAL(sorted_data[i], heap.get_root());
+        TEST_ASSERT_EQUAL(sorted_data[i], heap.pop_root());
+    }
+    TEST_ASSERT_TRUE(heap.is_empty());
+    // Keys smaller than the last root are rejected
+    TEST_ASSERT_EQUAL(0xFFFFFFFFUL, heap.get_min_key());
+    TEST_ASSERT_FALSE(heap.insert(1000));
+    TEST_ASSERT_TRUE(heap.insert(0xFFFFFFFFUL));
+}
+
+struct Timer {
+    Timer(uint64_t _deadline = 0, unsigned _id = 0): deadline(_deadline), id(_id) {
+        inst_count ++;
+    }
+
+    Timer(const Timer& t): deadline(t.deadline), id(t.id) {
+        inst_count ++;
+    }
+
+    ~Timer() {
+        inst_count --;
+    }
+
+    uint64_t deadline;
+    unsigned id;
+    static int inst_count;
+};
+int Timer::inst_count = 0;
+
+struct TimerKey {
+    uint64_t operator ()(const Timer& t) const {
+        return t.deadline;
+    }
+};
+
+static void test_radix_heap_timers() {
+    {
+    // Replay a simple timer trace: each expired timer is re-armed with a new deadline
+    // in the future, so the keys popped from the heap never decrease
+    const unsigned num_timers = 50, num_expirations = 2000;
+    RadixHeap<Timer, uint64_t, TimerKey> heap;
+    UAllocTraits_t traits = {0};
+
+    TEST_ASSERT_TRUE(heap.init(16, 16, traits));
+    for (unsigned i = 0; i < num_timers; i ++) {
+        TEST_ASSERT_TRUE(heap.insert(Timer(0x100000000ULL + rand() % 1000, i)));
+    }
+    uint64_t now = 0;
+    for (unsigned i = 0; i < num_expirations; i ++) {
+        Timer t = heap.pop_root();
+        TEST_ASSERT_TRUE(t.deadline >= now);
+        now = t.deadline;
+        TEST_ASSERT_TRUE(heap.insert(Timer(now + 1 + rand() % 1000, t.id)));
+    }
+    TEST_ASSERT_EQUAL(num_timers, heap.get_num_elements());
+    }
+    // The heap destroys the elements that are still in it
+    TEST_ASSERT_EQUAL(0, Timer::inst_count);
+}
+
+#if defined(TARGET_LIKE_POSIX)
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// A timer trace: periodic timers (1 ms to 1 s ticks) and timeouts re-armed with a random delay
+// of up to 50 ms, with deadlines in microseconds. Each entry has the deadline in its upper bits
+// and the timer id in the lower 16 bits, so all the keys are different and every heap pops
+// them in the same order.
+static const unsigned trace_periodic = 32, trace_timeouts = 64, trace_expirations = 200000;
+static const uint64_t trace_periods[] = {1000, 10000, 100000, 1000000};
+
+template <typename Heap>
+static uint64_t replay_timer_trace(Heap& heap, uint64_t& checksum) {
+    uint32_t seed = 12345;
+    for (uint64_t id = 0; id < trace_periodic + trace_timeouts; id ++) {
+        TEST_ASSERT_TRUE(heap.insert((((id * 37) % 1000) << 16) | id));
+    }
+    checksum = 0;
+    uint64_t start = now_ns();
+    for (unsigned i = 0; i < trace_expirations; i ++) {
+        uint64_t e = heap.pop_root(), id = e & 0xFFFF, delay;
+        if (id < trace_periodic) {
+            delay = trace_periods[id % 4];
+        } else {
+            seed = seed * 1103515245 + 12345;
+            delay = 1 + (seed >> 8) % 50000;
+        }
+        heap.insert((((e >> 16) + delay) << 16) | id);
+        checksum = checksum * 31 + e;
+    }
+    uint64_t elapsed = now_ns() - start;
+    TEST_ASSERT_EQUAL(trace_periodic + trace_timeouts, heap.get_num_elements());
+    return elapsed;
+}
+
+// Cost of one expiration (pop the root, insert the re-armed timer) with each heap. The heaps
+// use a NullLock, since the CriticalSectionLock is a system call on POSIX.
+static void test_timer_trace_benchmark() {
+    UAllocTraits_t traits = {0};
+    BinaryHeap<uint64_t, MinCompare<uint64_t>, NullLock> binary_heap;
+    RadixHeap<uint64_t, uint64_t, RadixIdentityKey<uint64_t>, NullLock> radix_heap;
+    PairingHeap<uint64_t, MinCompare<uint64_t>, NullLock> pairing_heap;
+    TEST_ASSERT_TRUE(binary_heap.init(128, 128, traits));
+    TEST_ASSERT_TRUE(radix_heap.init(128, 128, traits));
+    TEST_ASSERT_TRUE(pairing_heap.init(128, 128, traits));
+
+    uint64_t binary_checksum, radix_checksum, pairing_checksum;
+    uint64_t binary_ns = replay_timer_trace(binary_heap, binary_checksum);
+    uint64_t radix_ns = replay_timer_trace(radix_heap, radix_checksum);
+    uint64_t pairing_ns = replay_timer_trace(pairing_heap, pairing_checksum);
+    TEST_ASSERT_TRUE(radix_checksum == binary_checksum);
+    TEST_ASSERT_TRUE(pairing_checksum == binary_checksum);
+    printf("Timer trace, %u timers: BinaryHeap %.1f ns, RadixHeap %.1f ns, PairingHeap %.1f ns per expiration\r\n",
+           trace_periodic + trace_timeouts, (double)binary_ns / trace_expirations,
+           (double)radix_ns / trace_expirations, (double)pairing_ns / trace_expirations);
+}
+#endif // defined(TARGET_LIKE_POSIX)
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(5, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("RadixHeap  - test_radix_heap_pod", test_radix_heap_pod, greentea_failure_handler),
+    Case("RadixHeap  - test_radix_heap_timers", test_radix_heap_timers, greentea_failure_handler),
+#if defined(TARGET_LIKE_POSIX)
+    Case("RadixHeap  - test_timer_trace_benchmark", test_timer_trace_benchmark, greentea_failure_handler),
+#endif
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
@@ -17,10 +17,29 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include "greentea-client/test_env.h"
 #include "unity/unity.h"
 #include "utest/utest.h"
 #include "core-util/SharedPointer.h"
+#include "core-util/ExtendablePoolAllocator.h"
+
+#if defined(TARGET_LIKE_POSIX)
+#include <pthread.h>
+#include <time.h>
+#endif
+
+class Traced {
+public:
+    int value;
+};
+
+CORE_UTIL_SHAREDPOINTER_ENABLE_TRACE(Traced)
+
+class Untraced {
+public:
+    int value;
+};
 
 using namespace utest::v1;
 using namespace mbed::util;
@@ -110,14 +129,556 @@ void test_shared_pointer() {
     }
 }
 
+class Pair {
+public:
+    Pair(int _first, int _second): first(_first), second(_second) {
+        liveObjects++;
+    }
+
+    ~Pair() {
+        liveObjects--;
+    }
+
+    int first;
+    int second;
+
+    static int liveObjects;
+};
+
+int Pair::liveObjects = 0;
+
+void test_make_shared() {
+    {
+        SharedPointer<Pair> sharedptr1 = make_shared<Pair>(1, 2);
+
+        // object is constructed with the forwarded arguments
+        TEST_ASSERT_TRUE(sharedptr1);
+        TEST_ASSERT_EQUAL(1, sharedptr1->first);
+        TEST_ASSERT_EQUAL(2, sharedptr1->second);
+        TEST_ASSERT_EQUAL(1, sharedptr1.use_count());
+        TEST_ASSERT_EQUAL(1, Pair::liveObjects);
+
+        // copies share the object
+        SharedPointer<Pair> sharedptr1copy = sharedptr1;
+        TEST_ASSERT_EQUAL(sharedptr1.get(), sharedptr1copy.get());
+        TEST_ASSERT_EQUAL(2, sharedptr1.use_count());
+
+        sharedptr1 = SharedPointer<Pair>();
+        TEST_ASSERT_EQUAL(1, sharedptr1copy.use_count());
+        TEST_ASSERT_EQUAL(1, Pair::liveObjects);
+    }
+
+    // last reference is gone, object is destroyed
+    TEST_ASSERT_EQUAL(0, Pair::liveObjects);
+}
+
+void test_allocate_shared() {
+    const unsigned numElements = 4;
+    const size_t elementSize = SharedPointer<Pair>::get_inplace_size();
+    UAllocTraits_t traits = {0};
+    void *poolMemory = mbed_ualloc(PoolAllocator::get_pool_size(numElements, elementSize), traits);
+    TEST_ASSERT_NOT_EQUAL(NULL, poolMemory);
+    PoolAllocator pool(poolMemory, numElements, elementSize);
+
+    {
+        SharedPointer<Pair> sharedptrs[numElements];
+
+        // every object and its counter use exactly one element of the pool
+        for (unsigned i = 0; i < numElements; i++) {
+            sharedptrs[i] = allocate_shared<Pair>(pool, i, 0);
+            TEST_ASSERT_TRUE(sharedptrs[i]);
+            TEST_ASSERT_EQUAL(i, sharedptrs[i]->first);
+        }
+        TEST_ASSERT_EQUAL(numElements, Pair::liveObjects);
+
+        // pool is exhausted
+        SharedPointer<Pair> empty = allocate_shared<Pair>(pool, 0, 0);
+        TEST_ASSERT_FALSE(empty);
+        TEST_ASSERT_EQUAL(0, empty.use_count());
+        TEST_ASSERT_EQUAL(numElements, Pair::liveObjects);
+
+        // releasing an object returns its element to the pool
+        sharedptrs[0] = SharedPointer<Pair>();
+        TEST_ASSERT_EQUAL(numElements - 1, Pair::liveObjects);
+        sharedptrs[0] = allocate_shared<Pair>(pool, 10, 0);
+        TEST_ASSERT_TRUE(sharedptrs[0]);
+        TEST_ASSERT_EQUAL(10, sharedptrs[0]->first);
+    }
+
+    TEST_ASSERT_EQUAL(0, Pair::liveObjects);
+
+    // all the elements are back in the pool
+    {
+        SharedPointer<Pair> sharedptrs[numElements];
+        for (unsigned i = 0; i < numElements; i++) {
+            sharedptrs[i] = allocate_shared<Pair>(pool, i, 0);
+            TEST_ASSERT_TRUE(sharedptrs[i]);
+        }
+    }
+
+    mbed_ufree(poolMemory);
+}
+
+void test_atomic_count() {
+    typedef SharedPointer<Pair, SharedPointerAtomicCount> AtomicPair;
+    {
+        AtomicPair sharedptr1(new Pair(1, 2));
+        AtomicPair sharedptr2 = make_shared<Pair, SharedPointerAtomicCount>(3, 4);
+        TEST_ASSERT_EQUAL(2, Pair::liveObjects);
+
+        {
+            AtomicPair copies[8];
+            for (unsigned i = 0; i < 8; i++) {
+                copies[i] = (i & 1) ? sharedptr1 : sharedptr2;
+            }
+            TEST_ASSERT_EQUAL(5, sharedptr1.use_count());
+            TEST_ASSERT_EQUAL(5, sharedptr2.use_count());
+            TEST_ASSERT_TRUE(copies[1] == sharedptr1);
+            TEST_ASSERT_TRUE(copies[0] != sharedptr1);
+        }
+
+        TEST_ASSERT_EQUAL(1, sharedptr1.use_count());
+        TEST_ASSERT_EQUAL(1, sharedptr2.use_count());
+        TEST_ASSERT_EQUAL(3, sharedptr2->first);
+
+        sharedptr2 = sharedptr1;
+        TEST_ASSERT_EQUAL(2, sharedptr1.use_count());
+        TEST_ASSERT_EQUAL(1, Pair::liveObjects);
+    }
+
+    TEST_ASSERT_EQUAL(0, Pair::liveObjects);
+}
+
+static SharedPointer<Pair> passThrough(SharedPointer<Pair> sharedptr) {
+    return sharedptr;
+}
+
+void test_move() {
+    {
+        SharedPointer<Pair> sharedptr1 = make_shared<Pair>(1, 2);
+        Pair *raw = sharedptr1.get();
+
+        // move construction transfers the reference
+        SharedPointer<Pair> sharedptr2(std::move(sharedptr1));
+        TEST_ASSERT_EQUAL(NULL, sharedptr1.get());
+        TEST_ASSERT_EQUAL(0, sharedptr1.use_count());
+        TEST_ASSERT_EQUAL(raw, sharedptr2.get());
+        TEST_ASSERT_EQUAL(1, sharedptr2.use_count());
+
+        // move assignment transfers the reference and releases the old one
+        SharedPointer<Pair> sharedptr3 = make_shared<Pair>(3, 4);
+        TEST_ASSERT_EQUAL(2, Pair::liveObjects);
+        sharedptr3 = std::move(sharedptr2);
+        TEST_ASSERT_EQUAL(1, Pair::liveObjects);
+        TEST_ASSERT_EQUAL(NULL, sharedptr2.get());
+        TEST_ASSERT_EQUAL(raw, sharedptr3.get());
+        TEST_ASSERT_EQUAL(1, sharedptr3.use_count());
+
+        // passing by value and returning only copies once
+        SharedPointer<Pair> sharedptr4 = passThrough(sharedptr3);
+        TEST_ASSERT_EQUAL(2, sharedptr3.use_count());
+        sharedptr4 = passThrough(std::move(sharedptr4));
+        TEST_ASSERT_EQUAL(2, sharedptr3.use_count());
+        TEST_ASSERT_EQUAL(raw, sharedptr4.get());
+
+        // copy assignment returns a reference
+        SharedPointer<Pair> sharedptr5;
+        (sharedptr5 = sharedptr3) = sharedptr4;
+        TEST_ASSERT_EQUAL(3, sharedptr3.use_count());
+
+        // swap exchanges the objects without changing the counters
+        SharedPointer<Pair> sharedptr6 = make_shared<Pair>(5, 6);
+        sharedptr6.swap(sharedptr5);
+        TEST_ASSERT_EQUAL(5, sharedptr5->first);
+        TEST_ASSERT_EQUAL(1, sharedptr5.use_count());
+        TEST_ASSERT_EQUAL(raw, sharedptr6.get());
+        TEST_ASSERT_EQUAL(3, sharedptr6.use_count());
+    }
+
+    TEST_ASSERT_EQUAL(0, Pair::liveObjects);
+}
+
+// A list node that owns the next one
+class Node {
+public:
+    Node(int _value): value(_value) {
+        liveNodes++;
+    }
+
+    ~Node() {
+        liveNodes--;
+    }
+
+    int value;
+    SharedPointer<Node> next;
+    static int liveNodes;
+};
+
+int Node::liveNodes = 0;
+
+static SharedPointer<Node> makeList(int length) {
+    SharedPointer<Node> head;
+    for (int i = length; i > 0; i--) {
+        SharedPointer<Node> node(new Node(i));
+        node->next = head;
+        head = node;
+    }
+    return head;
+}
+
+// Assigning from a SharedPointer that is owned by the object being released
+void test_assign_from_owned() {
+    {
+        SharedPointer<Node> list = makeList(3);
+        TEST_ASSERT_EQUAL(3, Node::liveNodes);
+        list = list->next;
+        TEST_ASSERT_EQUAL(2, Node::liveNodes);
+        TEST_ASSERT_EQUAL(2, list->value);
+        TEST_ASSERT_EQUAL(1, list.use_count());
+
+        list = std::move(list->next);
+        TEST_ASSERT_EQUAL(1, Node::liveNodes);
+        TEST_ASSERT_EQUAL(3, list->value);
+        TEST_ASSERT_EQUAL(1, list.use_count());
+
+        // self assignment keeps the reference
+        SharedPointer<Node> &alias = list;
+        list = alias;
+        list = std::move(alias);
+        TEST_ASSERT_EQUAL(3, list->value);
+        TEST_ASSERT_EQUAL(1, list.use_count());
+    }
+    TEST_ASSERT_EQUAL(0, Node::liveNodes);
+}
+
+static int deleterCalls = 0;
+
+static void countingDeleter(Pair *pair) {
+    deleterCalls++;
+    delete pair;
+}
+
+void test_custom_deleter() {
+    UAllocTraits_t traits = {0};
+
+    /* Test 1: function deleter, control block on the heap */
+    {
+        SharedPointer<Pair> sharedptr1(new Pair(1, 2), countingDeleter);
+        SharedPointer<Pair> sharedptr1copy = sharedptr1;
+        TEST_ASSERT_EQUAL(2, sharedptr1.use_count());
+        sharedptr1 = SharedPointer<Pair>();
+        TEST_ASSERT_EQUAL(0, deleterCalls);
+    }
+    TEST_ASSERT_EQUAL(1, deleterCalls);
+    TEST_ASSERT_EQUAL(0, Pair::liveObjects);
+
+    /* Test 2: objects and control blocks from pools */
+    const unsigned numElements = 2;
+    void *objectMemory = mbed_ualloc(PoolAllocator::get_pool_size(numElements, sizeof(Pair)), traits);
+    TEST_ASSERT_NOT_EQUAL(NULL, objectMemory);
+    PoolAllocator objectPool(objectMemory, numElements, sizeof(Pair));
+
+    typedef PoolDeleter<PoolAllocator> Deleter;
+    ExtendablePoolAllocator counterPool;
+    TEST_ASSERT_TRUE(counterPool.init(1, 1, SharedPointer<Pair>::get_control_block_size<Deleter>(), traits));
+
+    {
+        SharedPointer<Pair> sharedptrs[numElements];
+        for (unsigned i = 0; i < numElements; i++) {
+            void *mem = objectPool.alloc();
+            TEST_ASSERT_NOT_EQUAL(NULL, mem);
+            sharedptrs[i] = SharedPointer<Pair>(new(mem) Pair(i, 0), Deleter(objectPool), counterPool);
+            TEST_ASSERT_TRUE(sharedptrs[i]);
+            TEST_ASSERT_EQUAL(i, sharedptrs[i]->first);
+        }
+        TEST_ASSERT_EQUAL(numElements, Pair::liveObjects);
+        TEST_ASSERT_EQUAL(NULL, objectPool.alloc());
+
+        // the object goes back to its pool
+        sharedptrs[1] = SharedPointer<Pair>();
+        TEST_ASSERT_EQUAL(1, Pair::liveObjects);
+        void *mem = objectPool.alloc();
+        TEST_ASSERT_NOT_EQUAL(NULL, mem);
+        objectPool.free(mem);
+    }
+    TEST_ASSERT_EQUAL(0, Pair::liveObjects);
+
+    /* Test 3: the object is released if the control block can't be allocated */
+    {
+        uint64_t counterMemory[8];
+        TEST_ASSERT_TRUE(SharedPointer<Pair>::get_control_block_size<void (*)(Pair*)>() <= sizeof(counterMemory));
+        PoolAllocator emptyPool(counterMemory, 1, sizeof(counterMemory));
+        TEST_ASSERT_NOT_EQUAL(NULL, emptyPool.alloc());
+        SharedPointer<Pair> sharedptr(new Pair(3, 4), countingDeleter, emptyPool);
+        TEST_ASSERT_FALSE(sharedptr);
+        TEST_ASSERT_EQUAL(0, sharedptr.use_count());
+        TEST_ASSERT_EQUAL(2, deleterCalls);
+        TEST_ASSERT_EQUAL(0, Pair::liveObjects);
+    }
+
+    mbed_ufree(objectMemory);
+}
+
+void test_trace() {
+    SharedPointerTraceRecord record;
+    SharedPointerTrace::clear();
+
+    // types without tracing don't record anything
+    {
+        SharedPointer<Pair> sharedptr1(new Pair(1, 2));
+        SharedPointer<Pair> sharedptr1copy = sharedptr1;
+    }
+    TEST_ASSERT_EQUAL(0, SharedPointerTrace::get_num_records());
+
+    {
+        SharedPointer<Traced> sharedptr1 = make_shared<Traced>();
+        SharedPointer<Traced> sharedptr2 = sharedptr1;
+        SharedPointer<Traced> sharedptr3(std::move(sharedptr2));
+    }
+
+    const uint8_t events[] = {
+        SHAREDPOINTER_TRACE_CREATE, SHAREDPOINTER_TRACE_COPY, SHAREDPOINTER_TRACE_MOVE,
+        SHAREDPOINTER_TRACE_RELEASE, SHAREDPOINTER_TRACE_RELEASE
+    };
+    const uint32_t counts[] = {1, 2, 0, 1, 0};
+    const unsigned numEvents = sizeof(events) / sizeof(events[0]);
+
+    TEST_ASSERT_EQUAL(numEvents, SharedPointerTrace::get_num_records());
+    for (unsigned i = 0; i < numEvents; i++) {
+        TEST_ASSERT_TRUE(SharedPointerTrace::get_record(i, record));
+        TEST_ASSERT_EQUAL(events[i], record.event);
+        TEST_ASSERT_EQUAL(counts[i], record.count);
+    }
+    TEST_ASSERT_FALSE(SharedPointerTrace::get_record(numEvents, record));
+
+    // the oldest records are overwritten when the buffer is full
+    SharedPointer<Traced> sharedptr = make_shared<Traced>();
+    for (unsigned i = 0; i < CORE_UTIL_SHAREDPOINTER_TRACE_SIZE; i++) {
+        SharedPointer<Traced> copy = sharedptr;
+    }
+    TEST_ASSERT_EQUAL(CORE_UTIL_SHAREDPOINTER_TRACE_SIZE, SharedPointerTrace::get_num_records());
+    TEST_ASSERT_TRUE(SharedPointerTrace::get_record(CORE_UTIL_SHAREDPOINTER_TRACE_SIZE - 1, record));
+    TEST_ASSERT_EQUAL(SHAREDPOINTER_TRACE_RELEASE, record.event);
+    TEST_ASSERT_EQUAL(sharedptr.get(), record.object);
+    TEST_ASSERT_EQUAL(1, record.count);
+
+    SharedPointerTrace::clear();
+    TEST_ASSERT_EQUAL(0, SharedPointerTrace::get_num_records());
+}
+
+#if defined(TARGET_LIKE_POSIX)
+static const unsigned benchmarkIterations = 200000;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Create, copy and destroy throughput with the object and its counter in two heap blocks
+// (SharedPointer(new T)), in one heap block (make_shared) and in one pool element (allocate_shared)
+void test_benchmark_create() {
+    uint64_t start = now_ns();
+    for (unsigned i = 0; i < benchmarkIterations; i++) {
+        SharedPointer<Pair> sharedptr(new Pair(i, 0));
+        SharedPointer<Pair> copy = sharedptr;
+    }
+    const uint64_t separateNs = now_ns() - start;
+
+    start = now_ns();
+    for (unsigned i = 0; i < benchmarkIterations; i++) {
+        SharedPointer<Pair> sharedptr = make_shared<Pair>(i, 0);
+        SharedPointer<Pair> copy = sharedptr;
+    }
+    const uint64_t makeSharedNs = now_ns() - start;
+
+    const size_t elementSize = SharedPointer<Pair>::get_inplace_size();
+    UAllocTraits_t traits = {0};
+    void *poolMemory = mbed_ualloc(PoolAllocator::get_pool_size(1, elementSize), traits);
+    TEST_ASSERT_NOT_EQUAL(NULL, poolMemory);
+    PoolAllocator pool(poolMemory, 1, elementSize);
+    start = now_ns();
+    for (unsigned i = 0; i < benchmarkIterations; i++) {
+        SharedPointer<Pair> sharedptr = allocate_shared<Pair>(pool, i, 0);
+        SharedPointer<Pair> copy = sharedptr;
+    }
+    const uint64_t allocateSharedNs = now_ns() - start;
+    mbed_ufree(poolMemory);
+
+    TEST_ASSERT_EQUAL(0, Pair::liveObjects);
+    printf("create/copy/destroy: new %.1f ns, make_shared %.1f ns, allocate_shared %.1f ns\r\n",
+           (double)separateNs / benchmarkIterations, (double)makeSharedNs / benchmarkIterations,
+           (double)allocateSharedNs / benchmarkIterations);
+}
+
+template <class T>
+static uint64_t copyLoopNs(const SharedPointer<T>& source) {
+    uint64_t start = now_ns();
+    for (unsigned i = 0; i < benchmarkIterations; i++) {
+        SharedPointer<T> copy = source;
+        // compiler barrier, keeps the increment and decrement pair from being optimized out
+        __asm__ __volatile__("" : : "r"(&copy) : "memory");
+    }
+    return now_ns() - start;
+}
+
+// Copy/destroy cost for a type without tracing, for a traced type, and with the printf the
+// debug builds used to do on every copy and release. The printf output goes to /dev/null,
+// so it is only a lower bound of its cost on a target, where it is sent to the UART.
+void test_benchmark_trace() {
+    SharedPointer<Untraced> untraced = make_shared<Untraced>();
+    SharedPointer<Traced> traced = make_shared<Traced>();
+    const uint64_t untracedNs = copyLoopNs(untraced);
+    const uint64_t tracedNs = copyLoopNs(traced);
+    TEST_ASSERT_EQUAL(CORE_UTIL_SHAREDPOINTER_TRACE_SIZE, SharedPointerTrace::get_num_records());
+    traced = SharedPointer<Traced>();
+    SharedPointerTrace::clear();
+
+    FILE *sink = fopen("/dev/null", "w");
+    TEST_ASSERT_NOT_EQUAL(NULL, sink);
+    uint64_t start = now_ns();
+    for (unsigned i = 0; i < benchmarkIterations; i++) {
+        SharedPointer<Untraced> copy = untraced;
+        fprintf(sink, "SP&: %p = %p [%p: %p = %lu]\r\n", (void*)&copy, (void*)&untraced, (void*)copy.get(),
+                (void*)NULL, (unsigned long)copy.use_count());
+        fprintf(sink, "~SP: %p [%p: %p = %lu]\r\n", (void*)&copy, (void*)copy.get(), (void*)NULL,
+                (unsigned long)copy.use_count() - 1);
+    }
+    const uint64_t printfNs = now_ns() - start;
+    fclose(sink);
+
+    printf("copy/destroy: no trace %.1f ns, trace buffer %.1f ns, printf %.1f ns\r\n",
+           (double)untracedNs / benchmarkIterations, (double)tracedNs / benchmarkIterations,
+           (double)printfNs / benchmarkIterations);
+}
+
+static const unsigned stressThreads = 4;
+static const unsigned stressRounds = 50;
+static const unsigned stressCopies = 2000;
+
+class Shared {
+public:
+    Shared(): value(42) {
+    }
+
+    ~Shared() {
+        atomic_fetch_add(&destroyed, (uint32_t)1);
+    }
+
+    uint32_t value;
+
+    static uint32_t destroyed;
+};
+
+uint32_t Shared::destroyed = 0;
+
+typedef SharedPointer<Shared, SharedPointerAtomicCount> AtomicShared;
+
+static uint32_t stressErrors = 0;
+
+static void *copyAndDestroy(void *arg) {
+    // each thread owns one reference, the object is shared by all of them
+    AtomicShared *own = (AtomicShared*)arg;
+    for (unsigned i = 0; i < stressCopies; i++) {
+        AtomicShared copy = *own;
+        AtomicShared copy2(copy);
+        if (copy2->value != 42) {
+            atomic_fetch_add(&stressErrors, (uint32_t)1);
+        }
+    }
+    // the last thread to get here destroys the object
+    *own = AtomicShared();
+    return NULL;
+}
+
+// Copies and destroys references to one object from several threads at the same time:
+// the object must be destroyed exactly once, by whichever thread drops the last reference
+void test_atomic_count_threads() {
+    stressErrors = 0;
+    for (unsigned round = 0; round < stressRounds; round++) {
+        Shared::destroyed = 0;
+        AtomicShared own[stressThreads];
+        {
+            AtomicShared sharedptr = make_shared<Shared, SharedPointerAtomicCount>();
+            for (unsigned i = 0; i < stressThreads; i++) {
+                own[i] = sharedptr;
+            }
+            TEST_ASSERT_EQUAL(stressThreads + 1, sharedptr.use_count());
+        }
+
+        pthread_t threads[stressThreads];
+        for (unsigned i = 0; i < stressThreads; i++) {
+            TEST_ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, copyAndDestroy, &own[i]));
+        }
+        for (unsigned i = 0; i < stressThreads; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        TEST_ASSERT_EQUAL(1, Shared::destroyed);
+    }
+    TEST_ASSERT_EQUAL(0, stressErrors);
+}
+
+template <class RefCount>
+static void *copyLoop(void *arg) {
+    SharedPointer<Shared, RefCount> *source = (SharedPointer<Shared, RefCount>*)arg;
+    for (unsigned i = 0; i < benchmarkIterations; i++) {
+        SharedPointer<Shared, RefCount> copy = *source;
+        // compiler barrier, keeps the increment and decrement pair from being optimized out
+        __asm__ __volatile__("" : : "r"(&copy) : "memory");
+    }
+    return NULL;
+}
+
+template <class RefCount>
+static double copyThroughput(unsigned numThreads) {
+    // one reference per thread, all to the same object, so all threads use the same counter
+    SharedPointer<Shared, RefCount> sharedptr = make_shared<Shared, RefCount>();
+    SharedPointer<Shared, RefCount> own[stressThreads];
+    pthread_t threads[stressThreads];
+    for (unsigned i = 0; i < numThreads; i++) {
+        own[i] = sharedptr;
+    }
+    uint64_t start = now_ns();
+    for (unsigned i = 0; i < numThreads; i++) {
+        TEST_ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, copyLoop<RefCount>, &own[i]));
+    }
+    for (unsigned i = 0; i < numThreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return (double)numThreads * benchmarkIterations * 1e9 / (now_ns() - start);
+}
+
+// Copy/destroy throughput of the two counting policies. SharedPointerPlainCount can only be
+// used from one thread.
+void test_benchmark_policies() {
+    printf("copy/destroy: SharedPointerPlainCount %.0f/s, SharedPointerAtomicCount %.0f/s\r\n",
+           copyThroughput<SharedPointerPlainCount>(1), copyThroughput<SharedPointerAtomicCount>(1));
+    printf("copy/destroy: SharedPointerAtomicCount, %u threads %.0f/s\r\n",
+           stressThreads, copyThroughput<SharedPointerAtomicCount>(stressThreads));
+}
+#endif // defined(TARGET_LIKE_POSIX)
+
 static status_t test_setup(const size_t number_of_cases) {
-    GREENTEA_SETUP(2, "default_auto");
+    GREENTEA_SETUP(10, "default_auto");
 
     return greentea_test_setup_handler(number_of_cases);
 }
 
 static Case cases[] = {
-    Case("SharedPointer  - test_shared_pointer", test_shared_pointer)
+    Case("SharedPointer  - test_shared_pointer", test_shared_pointer),
+    Case("SharedPointer  - test_make_shared", test_make_shared),
+    Case("SharedPointer  - test_allocate_shared", test_allocate_shared),
+    Case("SharedPointer  - test_atomic_count", test_atomic_count),
+    Case("SharedPointer  - test_move", test_move),
+    Case("SharedPointer  - test_assign_from_owned", test_assign_from_owned),
+    Case("SharedPointer  - test_custom_deleter", test_custom_deleter),
+    Case("SharedPointer  - test_trace", test_trace),
+#if defined(TARGET_LIKE_POSIX)
+    Case("SharedPointer  - test_benchmark_create", test_benchmark_create),
+    Case("SharedPointer  - test_benchmark_trace", test_benchmark_trace),
+    Case("SharedPointer  - test_atomic_count_threads", test_atomic_count_threads),
+    Case("SharedPointer  - test_benchmark_policies", test_benchmark_policies),
+#endif
 };
 
 static Specification specification(test_setup, cases, greentea_test_teardown_handler);
@@ -0,0 +1,333 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <utility>
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "core-util/TimerQueue.h"
+#include "core-util/FunctionPointer.h"
+
+#if defined(TARGET_LIKE_POSIX)
+#include <time.h>
+#endif
+
+using namespace utest::v1;
+using namespace mbed::util;
+
+static const unsigned max_timers = 1000;
+
+static uint32_t calls[max_timers];
+static unsigned num_calls;
+
+static void record(uint32_t id) {
+    calls[num_calls ++] = id;
+}
+
+static TimerQueue *current_queue;
+static TimerQueue::Handle other_timer;
+
+static void cancel_other(uint32_t id) {
+    record(id);
+    current_queue->cancel(other_timer);
+    // a timer posted with no delay waits for the next dispatch()
+    current_queue->post_in(FunctionPointer1<void, uint32_t>(record).bind(id + 1), 0);
+}
+
+static void *alloc_pool_memory() {
+    UAllocTraits_t traits = {0};
+    return mbed_ualloc(PoolAllocator::get_pool_size(max_timers, TimerQueue::get_node_size()), traits);
+}
+
+static void test_post_and_dispatch() {
+    UAllocTraits_t traits = {0};
+    void *memory = alloc_pool_memory();
+    TEST_ASSERT_NOT_EQUAL(NULL, memory);
+    PoolAllocator pool(memory, max_timers, TimerQueue::get_node_size());
+    {
+        TimerQueue timers(pool);
+        TEST_ASSERT_TRUE(timers.init(16, 16, traits));
+        FunctionPointer1<void, uint32_t> fp(record);
+        num_calls = 0;
+
+        uint32_t deadline;
+        TEST_ASSERT_FALSE(timers.get_next_deadline(deadline));
+        TEST_ASSERT_FALSE(timers.post_in(Event(), 10).is_valid());
+
+        TimerQueue::Handle h30 = timers.post_at(fp.bind(30), 30);
+        timers.post_in(fp.bind(10), 10);
+        timers.post_at(fp.bind(20), 20);
+        // same deadline: called in posting order
+        timers.post_at(fp.bind(21), 20);
+        TEST_ASSERT_EQUAL(4, timers.get_num_pending());
+        TEST_ASSERT_TRUE(timers.get_next_deadline(deadline));
+        TEST_ASSERT_EQUAL(10, deadline);
+
+        TEST_ASSERT_EQUAL(0, timers.dispatch(9));
+        TEST_ASSERT_EQUAL(9, timers.get_time());
+        TEST_ASSERT_EQUAL(1, timers.dispatch(10));
+        TEST_ASSERT_EQUAL(2, timers.dispatch(25));
+        TEST_ASSERT_EQUAL(3, num_calls);
+        TEST_ASSERT_EQUAL(10, calls[0]);
+        TEST_ASSERT_EQUAL(20, calls[1]);
+        TEST_ASSERT_EQUAL(21, calls[2]);
+
+        // post_in() is relative to the time of the last dispatch()
+        timers.post_in(fp.bind(26), 1);
+        TEST_ASSERT_TRUE(timers.get_next_deadline(deadline));
+        TEST_ASSERT_EQUAL(26, deadline);
+
+        // cancellation
+        TEST_ASSERT_TRUE(timers.is_pending(h30));
+        TEST_ASSERT_TRUE(timers.cancel(h30));
+        TEST_ASSERT_FALSE(timers.is_pending(h30));
+        TEST_ASSERT_FALSE(timers.cancel(h30));
+        TEST_ASSERT_EQUAL(1, timers.dispatch(100));
+        TEST_ASSERT_EQUAL(4, num_calls);
+        TEST_ASSERT_EQUAL(26, calls[3]);
+        TEST_ASSERT_EQUAL(0, timers.get_num_pending());
+
+        // pending timers are freed by the destructor
+        for (unsigned i = 0; i < 10; i ++) {
+            TEST_ASSERT_TRUE(timers.post_in(fp.bind(i), i + 1).is_valid());
+        }
+    }
+    void *nodes[max_timers];
+    for (unsigned i = 0; i < max_timers; i ++) {
+        nodes[i] = pool.alloc();
+        TEST_ASSERT_NOT_EQUAL(NULL, nodes[i]);
+    }
+    TEST_ASSERT_EQUAL(NULL, pool.alloc());
+    for (unsigned i = 0; i < max_timers; i ++) {
+        pool.free(nodes[i]);
+    }
+    mbed_ufree(memory);
+}
+
+static void test_wraparound() {
+    UAllocTraits_t traits = {0};
+    void *memory = alloc_pool_memory();
+    TEST_ASSERT_NOT_EQUAL(NULL, memory);
+    PoolAllocator pool(memory, max_timers, TimerQueue::get_node_size());
+    {
+        TimerQueue timers(pool);
+        TEST_ASSERT_TRUE(timers.init(16, 16, traits));
+        FunctionPointer1<void, uint32_t> fp(record);
+        num_calls = 0;
+
+        TEST_ASSERT_EQUAL(0, timers.dispatch(0xFFFFFFF0UL));
+        timers.post_in(fp.bind(2), 0x20);
+        timers.post_in(fp.bind(1), 0x08);
+        TEST_ASSERT_EQUAL(1, timers.dispatch(0xFFFFFFF8UL));
+        TEST_ASSERT_EQUAL(0, timers.dispatch(0x0000000FUL));
+        TEST_ASSERT_EQUAL(1, timers.dispatch(0x00000010UL));
+        TEST_ASSERT_EQUAL(2, num_calls);
+        TEST_ASSERT_EQUAL(1, calls[0]);
+        TEST_ASSERT_EQUAL(2, calls[1]);
+    }
+    mbed_ufree(memory);
+}
+
+// A failed post leaves the moved-in Event with the caller and frees its node
+static void test_full_heap() {
+    UAllocTraits_t traits = {0};
+    void *memory = alloc_pool_memory();
+    TEST_ASSERT_NOT_EQUAL(NULL, memory);
+    PoolAllocator pool(memory, max_timers, TimerQueue::get_node_size());
+    {
+        TimerQueue timers(pool);
+        TEST_ASSERT_TRUE(timers.init(2, 0, traits));
+        FunctionPointer1<void, uint32_t> fp(record);
+        num_calls = 0;
+
+        TEST_ASSERT_TRUE(timers.post_at(fp.bind(1), 10).is_valid());
+        TEST_ASSERT_TRUE(timers.post_at(fp.bind(2), 20).is_valid());
+        Event e(fp.bind(3));
+        TEST_ASSERT_FALSE(timers.post_at(std::move(e), 30).is_valid());
+        TEST_ASSERT_FALSE(timers.post_in(std::move(e), 30).is_valid());
+        TEST_ASSERT_TRUE(e);
+        e.call();
+        TEST_ASSERT_EQUAL(1, num_calls);
+        TEST_ASSERT_EQUAL(3, calls[0]);
+        TEST_ASSERT_EQUAL(2, timers.get_num_pending());
+
+        // once a timer is dispatched there is room for the Event
+        TEST_ASSERT_EQUAL(1, timers.dispatch(10));
+        TEST_ASSERT_TRUE(timers.post_at(std::move(e), 30).is_valid());
+        TEST_ASSERT_FALSE(e);
+        TEST_ASSERT_EQUAL(2, timers.dispatch(30));
+        TEST_ASSERT_EQUAL(4, num_calls);
+        TEST_ASSERT_EQUAL(3, calls[3]);
+    }
+    // no node was leaked
+    void *nodes[max_timers];
+    for (unsigned i = 0; i < max_timers; i ++) {
+        nodes[i] = pool.alloc();
+        TEST_ASSERT_NOT_EQUAL(NULL, nodes[i]);
+    }
+    for (unsigned i = 0; i < max_timers; i ++) {
+        pool.free(nodes[i]);
+    }
+    mbed_ufree(memory);
+}
+
+static void test_batch_dispatch() {
+    UAllocTraits_t traits = {0};
+    void *memory = alloc_pool_memory();
+    TEST_ASSERT_NOT_EQUAL(NULL, memory);
+    PoolAllocator pool(memory, max_timers, TimerQueue::get_node_size());
+    {
+        TimerQueue timers(pool);
+        TEST_ASSERT_TRUE(timers.init(64, 64, traits));
+        FunctionPointer1<void, uint32_t> fp(record);
+        TimerQueue::Handle handles[max_timers];
+        num_calls = 0;
+
+        // fill the pool with timers in random order, then cancel every other one
+        srand(1);
+        for (unsigned i = 0; i < max_timers; i ++) {
+            uint32_t deadline = 1 + rand() % 10000;
+            handles[i] = timers.post_at(fp.bind(deadline), deadline);
+            TEST_ASSERT_TRUE(handles[i].is_valid());
+        }
+        TEST_ASSERT_FALSE(timers.post_at(fp.bind(0), 0).is_valid());
+        for (unsigned i = 0; i < max_timers; i += 2) {
+            TEST_ASSERT_TRUE(timers.cancel(handles[i]));
+        }
+        TEST_ASSERT_EQUAL(max_timers / 2, timers.get_num_pending());
+
+        // limited batches, then everything that is left
+        TEST_ASSERT_EQUAL(100, timers.dispatch(10000, 100));
+        TEST_ASSERT_EQUAL(max_timers / 2 - 100, timers.dispatch(10000));
+        TEST_ASSERT_EQUAL(max_timers / 2, num_calls);
+        for (unsigned i = 1; i < num_calls; i ++) {
+            TEST_ASSERT_TRUE(calls[i - 1] <= calls[i]);
+        }
+        for (unsigned i = 1; i < max_timers; i += 2) {
+            TEST_ASSERT_FALSE(timers.is_pending(handles[i]));
+        }
+
+        // the batch is taken before the events are called
+        num_calls = 0;
+        current_queue = &timers;
+        timers.post_at(FunctionPointer1<void, uint32_t>(cancel_other).bind(1), 20000);
+        other_timer = timers.post_at(fp.bind(3), 20000);
+        TEST_ASSERT_EQUAL(2, timers.dispatch(20000));
+        TEST_ASSERT_EQUAL(1, timers.dispatch(20000));
+        TEST_ASSERT_EQUAL(3, num_calls);
+        TEST_ASSERT_EQUAL(1, calls[0]);
+        TEST_ASSERT_EQUAL(3, calls[1]);
+        TEST_ASSERT_EQUAL(2, calls[2]);
+    }
+    mbed_ufree(memory);
+}
+
+#if defined(TARGET_LIKE_POSIX)
+static const unsigned many_timers = 1000000;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t last_deadline;
+static bool in_order;
+
+static void check_order(uint32_t deadline) {
+    in_order = in_order && (last_deadline <= deadline);
+    last_deadline = deadline;
+    num_calls ++;
+}
+
+// 10^6 pending timers, with the heap sized for all of them in init()
+static void test_many_timers() {
+    UAllocTraits_t traits = {0};
+    void *memory = mbed_ualloc(PoolAllocator::get_pool_size(many_timers, TimerQueue::get_node_size()), traits);
+    TEST_ASSERT_NOT_EQUAL(NULL, memory);
+    TimerQueue::Handle *handles = new TimerQueue::Handle[many_timers];
+    PoolAllocator pool(memory, many_timers, TimerQueue::get_node_size());
+    {
+        TimerQueue timers(pool);
+        TEST_ASSERT_TRUE(timers.init(many_timers, 1024, traits));
+        FunctionPointer1<void, uint32_t> fp(check_order);
+        num_calls = 0;
+        last_deadline = 0;
+        in_order = true;
+
+        srand(1);
+        uint64_t start = now_ns();
+        for (unsigned i = 0; i < many_timers; i ++) {
+            uint32_t deadline = 1 + rand() % 1000000;
+            handles[i] = timers.post_at(fp.bind(deadline), deadline);
+        }
+        const uint64_t postNs = now_ns() - start;
+        TEST_ASSERT_EQUAL(many_timers, timers.get_num_pending());
+        TEST_ASSERT_TRUE(handles[many_timers - 1].is_valid());
+
+        start = now_ns();
+        for (unsigned i = 0; i < many_timers; i += 4) {
+            TEST_ASSERT_TRUE(timers.cancel(handles[i]));
+        }
+        const uint64_t cancelNs = now_ns() - start;
+        TEST_ASSERT_EQUAL(many_timers - many_timers / 4, timers.get_num_pending());
+
+        start = now_ns();
+        TEST_ASSERT_EQUAL(many_timers - many_timers / 4, timers.dispatch(1000000));
+        const uint64_t dispatchNs = now_ns() - start;
+        TEST_ASSERT_EQUAL(many_timers - many_timers / 4, num_calls);
+        TEST_ASSERT_TRUE(in_order);
+        TEST_ASSERT_EQUAL(0, timers.get_num_pending());
+
+        printf("%u timers: post %.1f ns, cancel %.1f ns, dispatch %.1f ns per timer\r\n", many_timers,
+               (double)postNs / many_timers, (double)cancelNs / (many_timers / 4),
+               (double)dispatchNs / (many_timers - many_timers / 4));
+    }
+    delete [] handles;
+    mbed_ufree(memory);
+}
+#endif
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(30, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("TimerQueue  - test_post_and_dispatch", test_post_and_dispatch, greentea_failure_handler),
+    Case("TimerQueue  - test_wraparound", test_wraparound, greentea_failure_handler),
+    Case("TimerQueue  - test_full_heap", test_full_heap, greentea_failure_handler),
+    Case("TimerQueue  - test_batch_dispatch", test_batch_dispatch, greentea_failure_handler),
+#if defined(TARGET_LIKE_POSIX)
+    Case("TimerQueue  - test_many_timers", test_many_timers, greentea_failure_handler),
+#endif
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
@@ -0,0 +1,142 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "core-util/WeakPointer.h"
+
+using namespace utest::v1;
+using namespace mbed::util;
+
+class Number {
+public:
+    Number(int _num): num(_num) {
+        liveObjects++;
+    }
+
+    ~Number() {
+        liveObjects--;
+    }
+
+    int num;
+
+    static int liveObjects;
+};
+
+int Number::liveObjects = 0;
+
+template <class RefCount>
+static void test_weak_pointer(SharedPointer<Number, RefCount> sharedptr) {
+    WeakPointer<Number, RefCount> empty;
+    TEST_ASSERT_TRUE(empty.expired());
+    TEST_ASSERT_FALSE(empty.lock());
+
+    WeakPointer<Number, RefCount> weakptr1(sharedptr);
+    WeakPointer<Number, RefCount> weakptr2;
+    weakptr2 = weakptr1;
+
+    // weak references don't change the reference count
+    TEST_ASSERT_EQUAL(1, sharedptr.use_count());
+    TEST_ASSERT_EQUAL(1, weakptr1.use_count());
+    TEST_ASSERT_FALSE(weakptr2.expired());
+
+    {
+        // lock() gives a new strong reference
+        SharedPointer<Number, RefCount> locked = weakptr2.lock();
+        TEST_ASSERT_TRUE(locked == sharedptr);
+        TEST_ASSERT_EQUAL(2, sharedptr.use_count());
+        TEST_ASSERT_EQUAL(5, locked->num);
+
+        // the object is kept alive by the locked reference
+        sharedptr = SharedPointer<Number, RefCount>();
+        TEST_ASSERT_EQUAL(1, Number::liveObjects);
+        TEST_ASSERT_FALSE(weakptr1.expired());
+    }
+
+    // last strong reference is gone, object is destroyed
+    TEST_ASSERT_EQUAL(0, Number::liveObjects);
+    TEST_ASSERT_TRUE(weakptr1.expired());
+    TEST_ASSERT_TRUE(weakptr2.expired());
+    TEST_ASSERT_FALSE(weakptr1.lock());
+
+    // moving and resetting an expired WeakPointer is fine
+    WeakPointer<Number, RefCount> weakptr3(std::move(weakptr1));
+    TEST_ASSERT_TRUE(weakptr3.expired());
+    weakptr2.reset();
+    TEST_ASSERT_TRUE(weakptr2.expired());
+}
+
+static void test_weak_pointer_separate() {
+    test_weak_pointer(SharedPointer<Number>(new Number(5)));
+}
+
+static void test_weak_pointer_inplace() {
+    test_weak_pointer(make_shared<Number>(5));
+}
+
+static void test_weak_pointer_atomic() {
+    test_weak_pointer(make_shared<Number, SharedPointerAtomicCount>(5));
+}
+
+static void test_weak_pointer_pool() {
+    const size_t elementSize = SharedPointer<Number>::get_inplace_size();
+    UAllocTraits_t traits = {0};
+    void *poolMemory = mbed_ualloc(PoolAllocator::get_pool_size(1, elementSize), traits);
+    TEST_ASSERT_NOT_EQUAL(NULL, poolMemory);
+    PoolAllocator pool(poolMemory, 1, elementSize);
+
+    {
+        WeakPointer<Number> weakptr(allocate_shared<Number>(pool, 5));
+
+        // the object is destroyed, but its memory is only returned to the pool
+        // together with the last WeakPointer
+        TEST_ASSERT_TRUE(weakptr.expired());
+        TEST_ASSERT_EQUAL(0, Number::liveObjects);
+        TEST_ASSERT_FALSE(allocate_shared<Number>(pool, 6));
+    }
+
+    TEST_ASSERT_TRUE(allocate_shared<Number>(pool, 6));
+
+    mbed_ufree(poolMemory);
+}
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(5, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("WeakPointer  - test_weak_pointer_separate", test_weak_pointer_separate, greentea_failure_handler),
+    Case("WeakPointer  - test_weak_pointer_inplace", test_weak_pointer_inplace, greentea_failure_handler),
+    Case("WeakPointer  - test_weak_pointer_atomic", test_weak_pointer_atomic, greentea_failure_handler),
+    Case("WeakPointer  - test_weak_pointer_pool", test_weak_pointer_pool, greentea_failure_handler)
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
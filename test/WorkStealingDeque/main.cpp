@@ -0,0 +1,201 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "core-util/WorkStealingDeque.h"
+
+#if defined(TARGET_LIKE_POSIX)
+#include <pthread.h>
+#include <time.h>
+#endif
+
+using namespace utest::v1;
+using namespace mbed::util;
+
+static void test_init() {
+    UAllocTraits_t traits = {0};
+    WorkStealingDeque<uint32_t> d1, d2;
+    TEST_ASSERT_EQUAL(0, d1.get_capacity());
+    TEST_ASSERT_FALSE(d1.init(0, traits));
+    TEST_ASSERT_FALSE(d1.init(6, traits));
+    TEST_ASSERT_TRUE(d1.init(8, traits));
+    TEST_ASSERT_FALSE(d1.init(8, traits));
+    TEST_ASSERT_EQUAL(8, d1.get_capacity());
+    TEST_ASSERT_TRUE(d1.is_empty());
+}
+
+static void test_push_pop_steal() {
+    UAllocTraits_t traits = {0};
+    WorkStealingDeque<uint32_t> d;
+    TEST_ASSERT_TRUE(d.init(4, traits));
+    uint32_t e;
+
+    TEST_ASSERT_FALSE(d.pop(e));
+    TEST_ASSERT_FALSE(d.steal(e));
+    for (uint32_t i = 0; i < 4; i ++) {
+        TEST_ASSERT_TRUE(d.push(i));
+    }
+    TEST_ASSERT_FALSE(d.push(4));
+    TEST_ASSERT_EQUAL(4, d.get_num_elements());
+
+    // the owner gets the newest element, thieves get the oldest one
+    TEST_ASSERT_TRUE(d.pop(e));
+    TEST_ASSERT_EQUAL(3, e);
+    TEST_ASSERT_TRUE(d.steal(e));
+    TEST_ASSERT_EQUAL(0, e);
+    TEST_ASSERT_TRUE(d.steal(e));
+    TEST_ASSERT_EQUAL(1, e);
+
+    // the last element can be taken by either side, only once
+    TEST_ASSERT_TRUE(d.pop(e));
+    TEST_ASSERT_EQUAL(2, e);
+    TEST_ASSERT_FALSE(d.pop(e));
+    TEST_ASSERT_FALSE(d.steal(e));
+    TEST_ASSERT_TRUE(d.is_empty());
+    TEST_ASSERT_TRUE(d.push(5));
+    TEST_ASSERT_TRUE(d.steal(e));
+    TEST_ASSERT_EQUAL(5, e);
+    TEST_ASSERT_FALSE(d.pop(e));
+    TEST_ASSERT_EQUAL(0, d.get_num_elements());
+}
+
+static void test_wrap() {
+    UAllocTraits_t traits = {0};
+    WorkStealingDeque<uint32_t> d;
+    TEST_ASSERT_TRUE(d.init(4, traits));
+    uint32_t e, next_stolen = 0, next_pushed = 0;
+
+    // the indexes go around the storage many times
+    for (unsigned round = 0; round < 1000; round ++) {
+        while (d.push(next_pushed)) {
+            next_pushed ++;
+        }
+        TEST_ASSERT_EQUAL(4, d.get_num_elements());
+        for (unsigned i = 0; i < 3; i ++) {
+            TEST_ASSERT_TRUE(d.steal(e));
+            TEST_ASSERT_EQUAL(next_stolen ++, e);
+        }
+    }
+    TEST_ASSERT_TRUE(d.pop(e));
+    TEST_ASSERT_EQUAL(next_pushed - 1, e);
+}
+
+#if defined(TARGET_LIKE_POSIX)
+static const unsigned num_thieves = 3;
+static const unsigned num_items = 200000;
+static WorkStealingDeque<uint32_t> *shared_deque;
+static uint8_t taken[num_items];
+static uint32_t owner_done;
+static uint32_t num_taken;
+static uint32_t num_stolen;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void take(uint32_t e) {
+    atomic_fetch_add(&taken[e], (uint8_t)1, atomic_relaxed);
+    atomic_fetch_add(&num_taken, (uint32_t)1, atomic_relaxed);
+}
+
+static void *thief(void *) {
+    uint32_t e;
+    while (atomic_load(&owner_done, atomic_acquire) == 0 || !shared_deque->is_empty()) {
+        if (shared_deque->steal(e)) {
+            take(e);
+            atomic_fetch_add(&num_stolen, (uint32_t)1, atomic_relaxed);
+        }
+    }
+    return NULL;
+}
+
+// One owner pushing and popping, three thieves stealing: every element is taken exactly once
+static void test_threads() {
+    UAllocTraits_t traits = {0};
+    WorkStealingDeque<uint32_t> deque;
+    TEST_ASSERT_TRUE(deque.init(64, traits));
+    shared_deque = &deque;
+    memset(taken, 0, sizeof(taken));
+    owner_done = num_taken = num_stolen = 0;
+
+    pthread_t thieves[num_thieves];
+    uint64_t start = now_ns();
+    for (unsigned i = 0; i < num_thieves; i ++) {
+        TEST_ASSERT_EQUAL(0, pthread_create(&thieves[i], NULL, thief, NULL));
+    }
+    uint32_t e;
+    for (uint32_t i = 0; i < num_items; i ++) {
+        while (!deque.push(i)) {
+            if (deque.pop(e))
+                take(e);
+        }
+        // pop now and then, so the owner also races the thieves for the last element
+        if ((i % 3) == 0 && deque.pop(e))
+            take(e);
+    }
+    while (deque.pop(e)) {
+        take(e);
+    }
+    atomic_store(&owner_done, (uint32_t)1, atomic_release);
+    for (unsigned i = 0; i < num_thieves; i ++) {
+        pthread_join(thieves[i], NULL);
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    TEST_ASSERT_EQUAL(num_items, num_taken);
+    for (unsigned i = 0; i < num_items; i ++) {
+        TEST_ASSERT_EQUAL(1, taken[i]);
+    }
+    TEST_ASSERT_TRUE(deque.is_empty());
+    printf("%u elements, %u stolen by %u thieves, %.1f ns per element\r\n",
+           num_items, num_stolen, num_thieves, (double)elapsed / num_items);
+}
+#endif // defined(TARGET_LIKE_POSIX)
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("WorkStealingDeque  - test_init", test_init, greentea_failure_handler),
+    Case("WorkStealingDeque  - test_push_pop_steal", test_push_pop_steal, greentea_failure_handler),
+    Case("WorkStealingDeque  - test_wrap", test_wrap, greentea_failure_handler),
+#if defined(TARGET_LIKE_POSIX)
+    Case("WorkStealingDeque  - test_threads", test_threads, greentea_failure_handler),
+#endif
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
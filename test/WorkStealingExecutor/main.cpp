@@ -0,0 +1,403 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "core-util/WorkStealingExecutor.h"
+
+#if defined(TARGET_LIKE_POSIX)
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <time.h>
+#include <utility>
+#include "core-util/atomic_ops.h"
+#endif
+
+using namespace utest::v1;
+using namespace mbed::util;
+
+static const unsigned max_tasks = 64;
+static uint64_t memory[max_tasks * 16];
+
+static unsigned calls[max_tasks];
+static unsigned num_calls;
+
+static void record(unsigned id) {
+    calls[num_calls ++] = id;
+}
+
+static unsigned wakeups;
+
+static void wakeup() {
+    wakeups ++;
+}
+
+static void test_post_and_run() {
+    UAllocTraits_t traits = {0};
+    TEST_ASSERT_TRUE(PoolAllocator::get_pool_size(max_tasks, WorkStealingExecutor::get_node_size()) <= sizeof(memory));
+    PoolAllocator pool(memory, max_tasks, WorkStealingExecutor::get_node_size());
+    WorkStealingExecutor executor(pool);
+    TEST_ASSERT_FALSE(executor.init(0, 4, traits));
+    TEST_ASSERT_TRUE(executor.init(2, 4, traits));
+    TEST_ASSERT_FALSE(executor.init(2, 4, traits));
+    TEST_ASSERT_EQUAL(2, executor.get_num_workers());
+    executor.set_wakeup_handler(FunctionPointer(wakeup));
+    FunctionPointer1<void, unsigned> fp(record);
+    num_calls = wakeups = 0;
+
+    TEST_ASSERT_FALSE(executor.run_one(0));
+    TEST_ASSERT_FALSE(executor.post(Event()));
+
+    // Events posted from outside: the first worker to look runs the oldest one and moves the
+    // others to its deque, where the other worker can steal them
+    for (unsigned i = 0; i < 3; i ++) {
+        TEST_ASSERT_TRUE(executor.post(fp.bind(i)));
+    }
+    TEST_ASSERT_EQUAL(3, wakeups);
+    TEST_ASSERT_TRUE(executor.run_one(0));
+    TEST_ASSERT_TRUE(executor.run_one(1));
+    TEST_ASSERT_TRUE(executor.run_one(0));
+    TEST_ASSERT_FALSE(executor.run_one(0));
+    TEST_ASSERT_FALSE(executor.run_one(1));
+    TEST_ASSERT_EQUAL(3, num_calls);
+    TEST_ASSERT_EQUAL(0, calls[0]);
+    TEST_ASSERT_EQUAL(1, calls[1]);
+    TEST_ASSERT_EQUAL(2, calls[2]);
+
+    // Events posted by a worker: LIFO for the worker, FIFO for the thieves
+    num_calls = 0;
+    for (unsigned i = 0; i < 3; i ++) {
+        TEST_ASSERT_TRUE(executor.post(0, fp.bind(i)));
+    }
+    TEST_ASSERT_TRUE(executor.run_one(0));
+    TEST_ASSERT_TRUE(executor.run_one(1));
+    TEST_ASSERT_TRUE(executor.run_one(1));
+    TEST_ASSERT_FALSE(executor.run_one(1));
+    TEST_ASSERT_EQUAL(2, calls[0]);
+    TEST_ASSERT_EQUAL(0, calls[1]);
+    TEST_ASSERT_EQUAL(1, calls[2]);
+}
+
+static void test_overflow() {
+    UAllocTraits_t traits = {0};
+    PoolAllocator pool(memory, max_tasks, WorkStealingExecutor::get_node_size());
+    FunctionPointer1<void, unsigned> fp(record);
+    num_calls = 0;
+    {
+        WorkStealingExecutor executor(pool);
+        TEST_ASSERT_TRUE(executor.init(2, 2, traits));
+
+        // a full deque sends the rest of the Events to the overflow list
+        for (unsigned i = 0; i < 7; i ++) {
+            TEST_ASSERT_TRUE(executor.post(0, fp.bind(i)));
+        }
+        // worker 1 takes the overflow list before stealing: it runs the oldest Event, fills
+        // its own deque and keeps the last ones, which run in order before any Event posted later
+        TEST_ASSERT_TRUE(executor.run_one(1));
+        TEST_ASSERT_TRUE(executor.post(fp.bind(7)));
+        for (unsigned i = 0; i < 5; i ++) {
+            TEST_ASSERT_TRUE(executor.run_one(1));
+        }
+        TEST_ASSERT_EQUAL(6, num_calls);
+        TEST_ASSERT_EQUAL(2, calls[0]);
+        TEST_ASSERT_EQUAL(4, calls[1]);
+        TEST_ASSERT_EQUAL(3, calls[2]);
+        TEST_ASSERT_EQUAL(5, calls[3]);
+        TEST_ASSERT_EQUAL(6, calls[4]);
+        TEST_ASSERT_EQUAL(7, calls[5]);
+
+        // the pool limits the number of pending Events
+        num_calls = 0;
+        unsigned posted = 0;
+        while (executor.post(fp.bind(posted))) {
+            posted ++;
+        }
+        TEST_ASSERT_EQUAL(max_tasks - 2, posted);
+    }
+    // the Events that were not run are freed
+    TEST_ASSERT_EQUAL(0, num_calls);
+    void *nodes[max_tasks];
+    for (unsigned i = 0; i < max_tasks; i ++) {
+        nodes[i] = pool.alloc();
+        TEST_ASSERT_NOT_EQUAL(NULL, nodes[i]);
+    }
+    for (unsigned i = 0; i < max_tasks; i ++) {
+        pool.free(nodes[i]);
+    }
+}
+
+// Fork-join: every task splits its range in two halves until they are small enough
+static WorkStealingExecutor *fork_join_executor;
+static uint32_t fork_join_sum;
+static unsigned pending_tasks;
+
+static void sum_range(unsigned worker, uint32_t first, uint32_t last) {
+    if (last - first <= 4) {
+        for (uint32_t i = first; i < last; i ++) {
+            fork_join_sum += i;
+        }
+    } else {
+        FunctionPointer3<void, unsigned, uint32_t, uint32_t> fp(sum_range);
+        uint32_t middle = (first + last) / 2;
+        pending_tasks += 2;
+        TEST_ASSERT_TRUE(fork_join_executor->post(worker, fp.bind(worker, first, middle)));
+        TEST_ASSERT_TRUE(fork_join_executor->post(worker, fp.bind(worker, middle, last)));
+    }
+    pending_tasks --;
+}
+
+static void test_fork_join() {
+    UAllocTraits_t traits = {0};
+    PoolAllocator pool(memory, max_tasks, WorkStealingExecutor::get_node_size());
+    WorkStealingExecutor executor(pool);
+    TEST_ASSERT_TRUE(executor.init(3, 16, traits));
+    fork_join_executor = &executor;
+    fork_join_sum = 0;
+    pending_tasks = 1;
+
+    TEST_ASSERT_TRUE(executor.post(FunctionPointer3<void, unsigned, uint32_t, uint32_t>(sum_range).bind(0, 0, 1000)));
+    // the workers take turns, as if they were running in parallel
+    unsigned worker = 0, runs = 0;
+    while (pending_tasks > 0) {
+        executor.run_one(worker);
+        worker = (worker + 1) % executor.get_num_workers();
+        TEST_ASSERT_TRUE(++ runs < 10000);
+    }
+    TEST_ASSERT_EQUAL(999 * 1000 / 2, fork_join_sum);
+    TEST_ASSERT_FALSE(executor.run_one(0));
+}
+
+#if defined(TARGET_LIKE_POSIX)
+static const unsigned bench_max_workers = 4;
+static const unsigned bench_max_tasks = 8192;
+static uint64_t bench_memory[bench_max_tasks * 16];
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Baseline for the benchmarks: all the workers share one FIFO queue behind a mutex
+class SharedQueue {
+public:
+    SharedQueue(): _head(0), _tail(0) {
+        pthread_mutex_init(&_mutex, NULL);
+    }
+
+    ~SharedQueue() {
+        pthread_mutex_destroy(&_mutex);
+    }
+
+    bool post(Event&& e) {
+        pthread_mutex_lock(&_mutex);
+        bool posted = _tail - _head < bench_max_tasks;
+        if (posted) {
+            _events[_tail ++ % bench_max_tasks] = std::move(e);
+        }
+        pthread_mutex_unlock(&_mutex);
+        return posted;
+    }
+
+    bool run_one() {
+        pthread_mutex_lock(&_mutex);
+        if (_head == _tail) {
+            pthread_mutex_unlock(&_mutex);
+            return false;
+        }
+        Event e(std::move(_events[_head ++ % bench_max_tasks]));
+        pthread_mutex_unlock(&_mutex);
+        e.call();
+        return true;
+    }
+
+private:
+    pthread_mutex_t _mutex;
+    unsigned _head, _tail;
+    Event _events[bench_max_tasks];
+};
+
+// The workers run either on bench_executor or on bench_shared, and park on a counting
+// semaphore that is released once per posted Event
+static WorkStealingExecutor *bench_executor;
+static SharedQueue *bench_shared;
+static sem_t bench_wakeup;
+static bool bench_done;
+static uint32_t bench_remaining;
+static __thread unsigned bench_worker;
+
+static void bench_wake() {
+    sem_post(&bench_wakeup);
+}
+
+static void bench_finish() {
+    atomic_store(&bench_done, true, atomic_release);
+    for (unsigned i = 0; i < bench_max_workers; i ++) {
+        sem_post(&bench_wakeup);
+    }
+}
+
+// Posts from a worker go to its own deque; the others go to the overflow list
+static void bench_post(Event&& e, bool from_worker) {
+    while (true) {
+        bool posted;
+        if (bench_shared != NULL) {
+            posted = bench_shared->post(std::move(e));
+            if (posted) {
+                bench_wake();
+            }
+        } else if (from_worker) {
+            posted = bench_executor->post(bench_worker, std::move(e));
+        } else {
+            posted = bench_executor->post(std::move(e));
+        }
+        if (posted)
+            return;
+        sched_yield();
+    }
+}
+
+static void *bench_run_worker(void *arg) {
+    bench_worker = (unsigned)(uintptr_t)arg;
+    while (!atomic_load(&bench_done, atomic_acquire)) {
+        bool ran = bench_shared != NULL ? bench_shared->run_one() : bench_executor->run_one(bench_worker);
+        if (!ran) {
+            sem_wait(&bench_wakeup);
+        }
+    }
+    return NULL;
+}
+
+static const uint32_t fork_join_range = 1 << 16;
+static const uint32_t fork_join_leaf = 16;
+static const uint32_t tiny_tasks = 200000;
+static uint32_t bench_sum;
+
+static void bench_sum_range(uint32_t first, uint32_t last) {
+    if (last - first <= fork_join_leaf) {
+        uint32_t sum = 0;
+        for (uint32_t i = first; i < last; i ++) {
+            sum += i;
+        }
+        atomic_fetch_add(&bench_sum, sum, atomic_relaxed);
+        if (atomic_fetch_sub(&bench_remaining, last - first, atomic_acq_rel) == last - first) {
+            bench_finish();
+        }
+    } else {
+        FunctionPointer2<void, uint32_t, uint32_t> fp(bench_sum_range);
+        uint32_t middle = (first + last) / 2;
+        bench_post(fp.bind(first, middle), true);
+        bench_post(fp.bind(middle, last), true);
+    }
+}
+
+static void bench_tiny() {
+    if (atomic_fetch_sub(&bench_remaining, (uint32_t)1, atomic_acq_rel) == 1) {
+        bench_finish();
+    }
+}
+
+// Runs the workers until bench_finish() is called, and returns the elapsed time in ns
+static uint64_t bench_run(unsigned num_workers, bool shared, bool fork_join) {
+    UAllocTraits_t traits = {0};
+    TEST_ASSERT_TRUE(PoolAllocator::get_pool_size(bench_max_tasks, WorkStealingExecutor::get_node_size()) <= sizeof(bench_memory));
+    PoolAllocator pool(bench_memory, bench_max_tasks, WorkStealingExecutor::get_node_size());
+    WorkStealingExecutor executor(pool);
+    TEST_ASSERT_TRUE(executor.init(num_workers, 1024, traits));
+    executor.set_wakeup_handler(FunctionPointer(bench_wake));
+    static SharedQueue queue;
+    bench_executor = &executor;
+    bench_shared = shared ? &queue : NULL;
+    TEST_ASSERT_EQUAL(0, sem_init(&bench_wakeup, 0, 0));
+    bench_done = false;
+    bench_sum = 0;
+    bench_remaining = fork_join ? fork_join_range : tiny_tasks;
+
+    uint64_t start = now_ns();
+    pthread_t threads[bench_max_workers];
+    for (uintptr_t i = 0; i < num_workers; i ++) {
+        TEST_ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, bench_run_worker, (void*)i));
+    }
+    if (fork_join) {
+        bench_post(FunctionPointer2<void, uint32_t, uint32_t>(bench_sum_range).bind(0, fork_join_range), false);
+    } else {
+        FunctionPointer0<void> fp(bench_tiny);
+        for (uint32_t i = 0; i < tiny_tasks; i ++) {
+            bench_post(fp.bind(), false);
+        }
+    }
+    for (unsigned i = 0; i < num_workers; i ++) {
+        pthread_join(threads[i], NULL);
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    TEST_ASSERT_EQUAL(0, bench_remaining);
+    if (fork_join) {
+        TEST_ASSERT_EQUAL((uint32_t)((uint64_t)(fork_join_range - 1) * fork_join_range / 2), bench_sum);
+    }
+    TEST_ASSERT_FALSE(shared ? queue.run_one() : executor.run_one(0));
+    sem_destroy(&bench_wakeup);
+    return elapsed;
+}
+
+// Fork-join sum and a stream of tiny Events posted from outside the workers, on the
+// WorkStealingExecutor and on a single shared queue
+static void test_benchmark() {
+    const uint32_t fork_join_tasks = 2 * fork_join_range / fork_join_leaf - 1;
+    for (unsigned num_workers = 1; num_workers <= bench_max_workers; num_workers *= 2) {
+        uint64_t stealing_ns = bench_run(num_workers, false, true);
+        uint64_t shared_ns = bench_run(num_workers, true, true);
+        printf("%u workers, fork-join: work stealing %.0f ns/task, shared queue %.0f ns/task\r\n",
+               num_workers, (double)stealing_ns / fork_join_tasks, (double)shared_ns / fork_join_tasks);
+        stealing_ns = bench_run(num_workers, false, false);
+        shared_ns = bench_run(num_workers, true, false);
+        printf("%u workers, tiny tasks: work stealing %.0f ns/task, shared queue %.0f ns/task\r\n",
+               num_workers, (double)stealing_ns / tiny_tasks, (double)shared_ns / tiny_tasks);
+    }
+}
+#endif // defined(TARGET_LIKE_POSIX)
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("WorkStealingExecutor  - test_post_and_run", test_post_and_run, greentea_failure_handler),
+    Case("WorkStealingExecutor  - test_overflow", test_overflow, greentea_failure_handler),
+    Case("WorkStealingExecutor  - test_fork_join", test_fork_join, greentea_failure_handler),
+#if defined(TARGET_LIKE_POSIX)
+    Case("WorkStealingExecutor  - test_benchmark", test_benchmark, greentea_failure_handler),
+#endif
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
@@ -0,0 +1,336 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "core-util/atomic_ops.h"
+
+#if defined(TARGET_LIKE_POSIX)
+#include <pthread.h>
+#include <time.h>
+#endif
+
+using namespace utest::v1;
+using namespace mbed::util;
+
+template <typename T>
+static void check_integer() {
+    T value = 10, expected = 11;
+    TEST_ASSERT_FALSE(atomic_cas(&value, &expected, (T)20));
+    TEST_ASSERT_TRUE(expected == 10);
+    TEST_ASSERT_TRUE(atomic_cas(&value, &expected, (T)20));
+    TEST_ASSERT_TRUE(value == 20);
+    TEST_ASSERT_TRUE(atomic_incr(&value, (T)5) == 25);
+    TEST_ASSERT_TRUE(atomic_decr(&value, (T)25) == 0);
+    // wraps around like the plain operators
+    TEST_ASSERT_TRUE(atomic_decr(&value, (T)1) == (T)(0 - 1));
+}
+
+template <typename T>
+static void check_ordered() {
+    T value = 0;
+    atomic_store(&value, (T)3, atomic_release);
+    TEST_ASSERT_TRUE(atomic_load(&value, atomic_acquire) == 3);
+    TEST_ASSERT_TRUE(atomic_exchange(&value, (T)4, atomic_acq_rel) == 3);
+    // the fetch operations return the previous value
+    TEST_ASSERT_TRUE(atomic_fetch_add(&value, (T)2, atomic_relaxed) == 4);
+    TEST_ASSERT_TRUE(atomic_fetch_sub(&value, (T)1) == 6);
+    TEST_ASSERT_TRUE(atomic_fetch_or(&value, (T)0x30, atomic_relaxed) == 5);
+    TEST_ASSERT_TRUE(atomic_fetch_and(&value, (T)0x0F, atomic_release) == 0x35);
+    TEST_ASSERT_TRUE(atomic_load(&value) == 5);
+
+    // atomic_cas_weak can fail spuriously, so it is used in a loop
+    T expected = 6;
+    TEST_ASSERT_FALSE(atomic_cas_weak(&value, &expected, (T)7, atomic_acq_rel));
+    TEST_ASSERT_TRUE(expected == 5);
+    while (!atomic_cas_weak(&value, &expected, (T)(expected * 2), atomic_release)) {
+    }
+    TEST_ASSERT_TRUE(value == 10);
+}
+
+static void test_integers() {
+    check_integer<uint8_t>();
+    check_integer<uint16_t>();
+    check_integer<uint32_t>();
+    check_integer<uint64_t>();
+    check_integer<int32_t>();
+    check_integer<int64_t>();
+    check_integer<uintptr_t>();
+    check_integer<size_t>();
+
+    check_ordered<uint8_t>();
+    check_ordered<uint16_t>();
+    check_ordered<uint32_t>();
+    check_ordered<uint64_t>();
+    check_ordered<int32_t>();
+    check_ordered<uintptr_t>();
+
+    // 64 bit values are not truncated
+    uint64_t big = 0xFFFFFFFFULL, expected = big;
+    TEST_ASSERT_TRUE(atomic_incr(&big, (uint64_t)1) == 0x100000000ULL);
+    TEST_ASSERT_FALSE(atomic_cas(&big, &expected, (uint64_t)0));
+    TEST_ASSERT_TRUE(expected == 0x100000000ULL);
+}
+
+static void test_pointers() {
+    int a = 1, b = 2;
+    int *p = &a, *expected = &b;
+    TEST_ASSERT_FALSE(atomic_cas(&p, &expected, &b));
+    TEST_ASSERT_TRUE(expected == &a);
+    TEST_ASSERT_TRUE(atomic_cas(&p, &expected, &b));
+    TEST_ASSERT_TRUE(p == &b);
+
+    TEST_ASSERT_TRUE(atomic_exchange(&p, &a) == &b);
+    TEST_ASSERT_TRUE(atomic_load(&p, atomic_acquire) == &a);
+    atomic_store(&p, (int*)NULL, atomic_release);
+    TEST_ASSERT_TRUE(p == NULL);
+
+    // atomic_ptr_add moves the pointer by bytes, not elements
+    uint64_t buffer[4];
+    uint8_t *bump = (uint8_t*)buffer;
+    TEST_ASSERT_TRUE(atomic_ptr_add(&bump, 8) == (uint8_t*)&buffer[1]);
+    TEST_ASSERT_TRUE(atomic_ptr_add(&bump, 16, atomic_relaxed) == (uint8_t*)&buffer[3]);
+    TEST_ASSERT_TRUE(atomic_ptr_add(&bump, -24) == (uint8_t*)buffer);
+    uint64_t *typed = buffer;
+    TEST_ASSERT_TRUE(atomic_ptr_add(&typed, sizeof(uint64_t)) == &buffer[1]);
+    // volatile pointers, like the mbed_sbrk ones, are updated in place
+    void * volatile bump_void = buffer;
+    TEST_ASSERT_TRUE(atomic_ptr_add(&bump_void, 32) == (void*)&buffer[4]);
+    TEST_ASSERT_TRUE(bump_void == (void*)&buffer[4]);
+    TEST_ASSERT_TRUE(atomic_ptr_add(&bump_void, -8) == (void*)&buffer[3]);
+#if MBED_UTIL_ATOMIC_NATIVE
+    TEST_ASSERT_TRUE(atomic_is_native<int*>::value);
+    TEST_ASSERT_TRUE(atomic_is_native<uint32_t>::value);
+#endif
+}
+
+#if defined(TARGET_LIKE_POSIX)
+static const unsigned num_threads = 4;
+static const unsigned increments = 100000;
+static uint32_t counter32;
+static uint64_t counter64;
+static uint32_t cas_counter;
+static uint32_t relaxed_counter;
+static uint32_t weak_counter;
+
+static void *increment_counters(void *) {
+    for (unsigned i = 0; i < increments; i ++) {
+        atomic_incr(&counter32, (uint32_t)1);
+        atomic_incr(&counter64, (uint64_t)2);
+        // a failed atomic_cas loads the current value
+        uint32_t value = 0;
+        while (!atomic_cas(&cas_counter, &value, value + 1)) {
+        }
+        // a statistics counter doesn't need any ordering
+        atomic_fetch_add(&relaxed_counter, (uint32_t)1, atomic_relaxed);
+        value = 0;
+        while (!atomic_cas_weak(&weak_counter, &value, value + 1, atomic_relaxed)) {
+        }
+    }
+    return NULL;
+}
+
+static void test_threads() {
+    if (!atomic_is_native<uint32_t>::value || !atomic_is_native<uint64_t>::value) {
+        printf("No native atomics, skipping\r\n");
+        return;
+    }
+    counter32 = cas_counter = relaxed_counter = weak_counter = 0;
+    counter64 = 0;
+    pthread_t threads[num_threads];
+    for (unsigned i = 0; i < num_threads; i ++) {
+        TEST_ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, increment_counters, NULL));
+    }
+    for (unsigned i = 0; i < num_threads; i ++) {
+        pthread_join(threads[i], NULL);
+    }
+    TEST_ASSERT_TRUE(counter32 == num_threads * increments);
+    TEST_ASSERT_TRUE(counter64 == 2ULL * num_threads * increments);
+    TEST_ASSERT_TRUE(cas_counter == num_threads * increments);
+    TEST_ASSERT_TRUE(relaxed_counter == num_threads * increments);
+    TEST_ASSERT_TRUE(weak_counter == num_threads * increments);
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static const unsigned bench_ops = 1000000;
+
+// The two backends of atomic_cas and atomic_incr, called through their detail:: functions so
+// that both can be measured on the same target. Without native atomics, atomic_incr is a
+// loop on the locked atomic_cas.
+struct LockedBackend {
+    static bool cas(uint32_t *ptr, uint32_t *expected, uint32_t desired) {
+        return detail::atomic_cas_locked(ptr, expected, desired);
+    }
+
+    static uint32_t incr(uint32_t *ptr, uint32_t delta) {
+        uint32_t value = *ptr;
+        while (!detail::atomic_cas_locked(ptr, &value, value + delta)) {
+        }
+        return value + delta;
+    }
+};
+
+#if MBED_UTIL_ATOMIC_NATIVE
+struct NativeBackend {
+    static bool cas(uint32_t *ptr, uint32_t *expected, uint32_t desired) {
+        return detail::atomic_cas_dispatch(ptr, expected, desired, std::true_type());
+    }
+
+    static uint32_t incr(uint32_t *ptr, uint32_t delta) {
+        return detail::atomic_incr_dispatch(ptr, delta, std::true_type());
+    }
+};
+#endif
+
+template <typename Backend>
+static void benchmark_backend(const char *name) {
+    uint32_t counter = 0, value = 0;
+    uint64_t start = now_ns();
+    for (unsigned i = 0; i < bench_ops; i ++) {
+        while (!Backend::cas(&counter, &value, value + 1)) {
+        }
+        value ++;
+    }
+    uint64_t cas_ns = now_ns() - start;
+    start = now_ns();
+    for (unsigned i = 0; i < bench_ops; i ++) {
+        Backend::incr(&counter, 1);
+    }
+    uint64_t incr_ns = now_ns() - start;
+    TEST_ASSERT_TRUE(counter == 2 * bench_ops);
+    printf("%s backend: atomic_cas %.1f ns, atomic_incr %.1f ns\r\n",
+           name, (double)cas_ns / bench_ops, (double)incr_ns / bench_ops);
+}
+
+// Cost of atomic_cas and atomic_incr on an uncontended counter, for each backend. On POSIX
+// the CriticalSectionLock only blocks signals, so the locked backend is measured in a single
+// thread.
+static void test_benchmark_backends() {
+    benchmark_backend<LockedBackend>("CriticalSectionLock");
+#if MBED_UTIL_ATOMIC_NATIVE
+    benchmark_backend<NativeBackend>("Native");
+#endif
+}
+
+// Shared statistics counter and "last value" word, updated by every thread
+static uint32_t bench_counter;
+static uint32_t bench_last;
+
+template <atomic_order Order>
+static void *count_events(void *) {
+    for (unsigned i = 0; i < increments; i ++) {
+        atomic_fetch_add(&bench_counter, (uint32_t)1, Order);
+        atomic_store(&bench_last, (uint32_t)i, Order);
+    }
+    return NULL;
+}
+
+template <atomic_order Order>
+static uint64_t run_count_events(unsigned threads) {
+    pthread_t ids[num_threads];
+    bench_counter = 0;
+    uint64_t start = now_ns();
+    for (unsigned i = 0; i < threads; i ++) {
+        TEST_ASSERT_EQUAL(0, pthread_create(&ids[i], NULL, count_events<Order>, NULL));
+    }
+    for (unsigned i = 0; i < threads; i ++) {
+        pthread_join(ids[i], NULL);
+    }
+    uint64_t elapsed = now_ns() - start;
+    TEST_ASSERT_TRUE(bench_counter == threads * increments);
+    return elapsed;
+}
+
+// A counter updated by several threads, with relaxed and with sequentially consistent
+// atomic_fetch_add and atomic_store. The order must be a constant: the compiler treats a
+// variable order as atomic_seq_cst.
+static void test_benchmark_orders() {
+    if (!atomic_is_native<uint32_t>::value) {
+        printf("No native atomics, skipping\r\n");
+        return;
+    }
+    for (unsigned threads = 1; threads <= num_threads; threads *= 2) {
+        uint64_t relaxed_ns = run_count_events<atomic_relaxed>(threads);
+        uint64_t seq_cst_ns = run_count_events<atomic_seq_cst>(threads);
+        const double ops = 2.0 * threads * increments;
+        printf("%u threads: atomic_relaxed %.1f ns/op, atomic_seq_cst %.1f ns/op\r\n",
+               threads, relaxed_ns / ops, seq_cst_ns / ops);
+    }
+}
+
+// Message passing with release/acquire: the payload written before the release store
+// is visible after the acquire load that reads the flag
+static uint32_t payload;
+static uint32_t ready;
+
+static void *publish(void *) {
+    payload = 42;
+    atomic_store(&ready, (uint32_t)1, atomic_release);
+    return NULL;
+}
+
+static void test_release_acquire() {
+    if (!atomic_is_native<uint32_t>::value) {
+        printf("No native atomics, skipping\r\n");
+        return;
+    }
+    payload = ready = 0;
+    pthread_t thread;
+    TEST_ASSERT_EQUAL(0, pthread_create(&thread, NULL, publish, NULL));
+    while (atomic_load(&ready, atomic_acquire) == 0) {
+    }
+    TEST_ASSERT_EQUAL(42, payload);
+    pthread_join(thread, NULL);
+}
+#endif // defined(TARGET_LIKE_POSIX)
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(10, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("atomic_ops  - test_integers", test_integers, greentea_failure_handler),
+#if defined(TARGET_LIKE_POSIX)
+    Case("atomic_ops  - test_threads", test_threads, greentea_failure_handler),
+    Case("atomic_ops  - test_benchmark_backends", test_benchmark_backends, greentea_failure_handler),
+    Case("atomic_ops  - test_benchmark_orders", test_benchmark_orders, greentea_failure_handler),
+    Case("atomic_ops  - test_release_acquire", test_release_acquire, greentea_failure_handler),
+#endif
+    Case("atomic_ops  - test_pointers", test_pointers, greentea_failure_handler)
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
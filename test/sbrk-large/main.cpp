@@ -0,0 +1,110 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "core-util/sbrk.h"
+
+#if defined(TARGET_LIKE_POSIX)
+#include <sys/mman.h>
+#endif
+
+using namespace utest::v1;
+
+extern void * volatile mbed_sbrk_ptr;
+extern void * volatile mbed_krbs_ptr;
+extern ptrdiff_t mbed_sbrk_diff;
+
+static const uint64_t four_gb = 0x100000000ULL;
+
+// Free store of more than 4GB in a reserved virtual region. Only the bytes written by
+// the test are actually used.
+static void test_sbrk_past_4gb() {
+#if defined(TARGET_LIKE_POSIX)
+    if (sizeof(void*) < 8) {
+        printf("32 bit host, skipping\r\n");
+        return;
+    }
+    const size_t region_size = (size_t)(3 * four_gb);
+    uint8_t *region = (uint8_t*)mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (region == MAP_FAILED) {
+        printf("Can't reserve %lu bytes, skipping\r\n", (unsigned long)region_size);
+        return;
+    }
+
+    void *saved_sbrk_ptr = mbed_sbrk_ptr, *saved_krbs_ptr = mbed_krbs_ptr;
+    ptrdiff_t saved_sbrk_diff = mbed_sbrk_diff;
+    mbed_sbrk_ptr = region;
+    mbed_krbs_ptr = region + region_size;
+    mbed_sbrk_diff = (ptrdiff_t)region_size;
+
+    // sizes of 4GB and more are neither truncated nor rejected
+    const ptrdiff_t big = (ptrdiff_t)(four_gb + 1);
+    uint8_t *p = (uint8_t*)mbed_sbrk(big);
+    TEST_ASSERT_TRUE(p == region);
+    uint8_t *q = (uint8_t*)mbed_sbrk(16);
+    TEST_ASSERT_TRUE(q == region + four_gb + SBRK_ALIGN);
+    q[15] = 1;
+    TEST_ASSERT_TRUE(mbed_sbrk(0) == region + four_gb + SBRK_ALIGN + 16);
+
+    uint8_t *k = (uint8_t*)mbed_krbs(big);
+    TEST_ASSERT_TRUE(k == region + region_size - four_gb - KRBS_ALIGN);
+    k[0] = 1;
+    TEST_ASSERT_TRUE(mbed_sbrk_diff == (ptrdiff_t)(region_size - 2 * (four_gb + 8) - 16));
+
+    // the rest doesn't fit
+    TEST_ASSERT_TRUE(mbed_sbrk(big) == (void*)-1);
+    TEST_ASSERT_TRUE(mbed_krbs(big) == (void*)-1);
+
+    // giving memory back moves the pointer down across the boundary
+    TEST_ASSERT_TRUE(mbed_sbrk(-16) == region + four_gb + SBRK_ALIGN + 16);
+    TEST_ASSERT_TRUE(mbed_sbrk(-big) == region + four_gb + SBRK_ALIGN);
+    TEST_ASSERT_TRUE(mbed_sbrk(0) == region);
+
+    mbed_sbrk_ptr = saved_sbrk_ptr;
+    mbed_krbs_ptr = saved_krbs_ptr;
+    mbed_sbrk_diff = saved_sbrk_diff;
+    munmap(region, region_size);
+#else
+    printf("Can't reserve a virtual region on this target, skipping\r\n");
+#endif
+}
+
+static status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(10, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+static Case cases[] = {
+    Case("sbrk-large  - test_sbrk_past_4gb", test_sbrk_past_4gb, greentea_failure_handler)
+};
+
+static Specification specification(test_setup, cases, greentea_test_teardown_handler);
+
+void app_start(int, char**) {
+    Harness::run(specification);
+}
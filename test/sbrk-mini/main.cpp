@@ -21,7 +21,7 @@
 #include "core-util/sbrk.h"
 
 extern void * volatile mbed_sbrk_ptr;
-extern volatile uintptr_t mbed_sbrk_diff;
+extern ptrdiff_t mbed_sbrk_diff;
 
 #define TEST_SMALL sizeof(uint32_t)
 #define CHECK_EQ(A,B,P,F,L)\